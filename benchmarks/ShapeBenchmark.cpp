@@ -0,0 +1,92 @@
+#include <az/json/Reader.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+
+// allocations made through the global operator new, which is what std::string of a key uses
+std::size_t allocations = 0;
+
+} /* namespace */
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	if (void* memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+namespace {
+
+const int count = 200000;
+const int rounds = 9;
+
+// records of an array with keys which are longer than a short string, one of them escaped
+std::string makeRecords(bool alternating)
+{
+	std::string text = "[";
+	for (int index = 0; index < count; index++) {
+		text += "{\"record_identifier\": " + std::to_string(index) + ", \"record_description\": \"d\", \"creation_timestamp\": 1, "
+			"\"modification_timestamp\": 2, \"\\u006fwner_account_name\": \"o\", \"access_permissions\": [1, 2], \"deletion_requested\": false, ";
+		// records which differ only by their last key, so they share the beginning of their shapes
+		text += (alternating && index % 2) ? "\"archived_revision_number\": 3}," : "\"current_revision_number\": 3},";
+	}
+	text.back() = ']';
+	return text;
+}
+
+struct Measure {
+	double time = 0;
+	std::size_t allocations = 0;
+};
+
+// the best times of parsing the text by the same readers, so the cache is warm after the first round,
+// rounds with and without caching take turns, so both of them are equally disturbed by other processes
+void measureParsing(const std::string& text, Measure (&measures)[2])
+{
+	az::json::Value json;
+	az::json::Reader readers[] = {az::json::Reader(json), az::json::Reader(json)};
+	readers[0].withShapeCaching(false);
+	readers[1].withShapeCaching(true);
+	for (int round = 0; round < rounds; round++) {
+		for (int caching = 0; caching < 2; caching++) {
+			json = az::json::Value();
+			const auto allocated = allocations;
+			const auto start = std::chrono::steady_clock::now();
+			readers[caching].parse(text);
+			const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			measures[caching].time = (round == 0) ? time : std::min(measures[caching].time, time);
+			measures[caching].allocations = allocations - allocated;
+		}
+	}
+}
+
+} /* namespace */
+
+int main()
+{
+	for (bool alternating : {false, true}) {
+		const auto text = makeRecords(alternating);
+		Measure measures[2];
+		measureParsing(text, measures);
+		std::cout << count << (alternating ? " records of two shapes, " : " records of one shape, ")
+			<< std::fixed << std::setprecision(1) << double(text.size()) / 1e6 << " MB" << std::endl;
+		for (int caching = 0; caching < 2; caching++) {
+			std::cout << (caching ? "  with shape caching:    " : "  without shape caching: ") << std::setw(7) << measures[caching].time << " ms, "
+				<< std::setprecision(1) << double(measures[caching].allocations) / count << " allocations per record" << std::endl;
+		}
+	}
+	return 0;
+}
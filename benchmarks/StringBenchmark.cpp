@@ -0,0 +1,190 @@
+#include <az/json/Value.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// counts bytes which are taken by strings and arrays of values
+class CountingResource : public az::json::MemoryResource
+{
+public:
+	std::size_t getBytes() const {
+		return bytes;
+	}
+
+protected:
+	void* doAllocate(std::size_t size, std::size_t /*alignment*/) override {
+		bytes += size;
+		return ::operator new(size);
+	}
+	void doDeallocate(void* memory, std::size_t size, std::size_t /*alignment*/) override {
+		bytes -= size;
+		::operator delete(memory);
+	}
+
+private:
+	std::size_t bytes = 0;
+};
+
+// cache misses of the thread while it is alive, unavailable if the kernel does not let the process count them
+class CacheMisses
+{
+public:
+	CacheMisses() {
+#ifdef __linux__
+		perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		descriptor = int(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+	}
+	~CacheMisses() {
+#ifdef __linux__
+		if (descriptor >= 0) {
+			close(descriptor);
+		}
+#endif
+	}
+	CacheMisses(const CacheMisses&) = delete;
+	CacheMisses& operator=(const CacheMisses&) = delete;
+
+	bool isAvailable() const {
+		return descriptor >= 0;
+	}
+	void start() {
+#ifdef __linux__
+		if (descriptor >= 0) {
+			ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+			ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+	uint64_t stop() {
+		uint64_t misses = 0;
+#ifdef __linux__
+		if (descriptor >= 0) {
+			ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(descriptor, &misses, sizeof(misses)) != sizeof(misses)) {
+				misses = 0;
+			}
+		}
+#endif
+		return misses;
+	}
+
+private:
+	int descriptor = -1;
+};
+
+const std::size_t count = 2000000;
+
+std::vector<std::string> makeStrings(std::size_t size)
+{
+	std::mt19937 random(42);
+	std::vector<std::string> strings(count);
+	for (auto& string : strings) {
+		string.resize(size);
+		for (auto& letter : string) {
+			letter = char('a' + random() % 26);
+		}
+	}
+	return strings;
+}
+
+// bytes of a node of an array of values, which counts the value itself and the memory it takes
+double measureValues(const std::vector<std::string>& strings)
+{
+	CountingResource resource;
+	az::json::MemoryResource::Scope scope(&resource);
+	az::json::Value array(az::json::Value::Type::Array);
+	array.reserve(az::json::Value::Index(strings.size()));
+	for (const auto& string : strings) {
+		array.append(string);
+	}
+	return double(resource.getBytes()) / double(strings.size());
+}
+
+// the same for a vector of strings, each of them was allocated by a value before short strings were kept inside it
+double measureStrings(const std::vector<std::string>& strings)
+{
+	CountingResource resource;
+	az::json::MemoryResource::Scope scope(&resource);
+	std::vector<az::json::Value::Text, az::json::Allocator<az::json::Value::Text>> array;
+	array.reserve(strings.size());
+	for (const auto& string : strings) {
+		array.emplace_back(string.data(), string.size());
+	}
+	return double(resource.getBytes()) / double(strings.size());
+}
+
+// iterates the array in the order of a scan and in a random order, comparing every string with a key
+void measureIteration(const std::vector<std::string>& strings, CacheMisses& misses)
+{
+	az::json::Value array(az::json::Value::Type::Array);
+	array.reserve(az::json::Value::Index(strings.size()));
+	for (const auto& string : strings) {
+		array.append(string);
+	}
+	std::vector<az::json::Value::Index> order(strings.size());
+	for (std::size_t index = 0; index < order.size(); index++) {
+		order[index] = az::json::Value::Index(index);
+	}
+	std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+	const az::json::Value key(strings.front());
+	const auto& elements = array.getArray();
+	for (int pass = 0; pass < 2; pass++) {
+		std::size_t matches = 0;
+		misses.start();
+		const auto start = std::chrono::steady_clock::now();
+		for (std::size_t index = 0; index < elements.size(); index++) {
+			const auto& element = elements[pass == 0 ? index : order[index]];
+			matches += element == key ? 1 : 0;
+		}
+		const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		const auto missed = misses.stop();
+		std::cout << "  " << (pass == 0 ? "scan:   " : "random: ") << std::fixed << std::setprecision(1) << std::setw(7) << time << " ms";
+		if (misses.isAvailable()) {
+			std::cout << std::setw(8) << std::setprecision(3) << double(missed) / double(elements.size()) << " cache misses per node";
+		}
+		std::cout << " (" << matches << " matches)" << std::endl;
+	}
+}
+
+} /* namespace */
+
+int main()
+{
+	CacheMisses misses;
+	std::cout << "sizeof(Value): " << sizeof(az::json::Value) << ", strings inside values up to " << az::json::Value::small_capacity << " bytes" << std::endl;
+	if (!misses.isAvailable()) {
+		std::cout << "cache misses are not counted, only times are measured" << std::endl;
+	}
+	for (std::size_t size : {2, 8, 13, 14, 24}) {
+		const auto strings = makeStrings(size);
+		std::cout << std::endl << count << " strings of " << size << " bytes" << std::endl;
+		std::cout << "  bytes per node: " << std::fixed << std::setprecision(1) << measureValues(strings) << " in values, "
+			<< measureStrings(strings) << " in a vector of strings" << std::endl;
+		measureIteration(strings, misses);
+	}
+	return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include "MemoryResource.h"
+
+namespace az {
+namespace json {
+
+// a resource which hands memory out of large chunks one piece after another and releases it all at once,
+// it takes no locks, so it is used by one thread at a time
+class Arena final : public MemoryResource
+{
+public:
+	struct Options {
+		// the first chunk has this size, every next one is twice as large up to the maximum
+		std::size_t chunk_size = 64 << 10;
+		std::size_t max_chunk_size = 64 << 20;
+		// takes chunks of huge pages from the system if it supports them
+		bool huge_pages = false;
+		Options() {}
+	};
+
+	explicit Arena(const Options& options = {});
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// releases all chunks, memory which has been taken from the arena must not be used any more
+	void release();
+	// bytes which are taken from the system by chunks and bytes which are handed out of them
+	std::size_t getReserved() const;
+	std::size_t getUsed() const;
+
+protected:
+	void* doAllocate(std::size_t size, std::size_t alignment) override;
+	// memory is released with the whole arena
+	void doDeallocate(void*, std::size_t, std::size_t) override {}
+
+private:
+	struct Chunk {
+		Chunk* next;
+		std::size_t size;
+		bool mapped;
+	};
+	void addChunk(std::size_t size);
+
+	Options options;
+	Chunk* chunks = nullptr;
+	char* cursor = nullptr;
+	char* limit = nullptr;
+	std::size_t next_size;
+	std::size_t reserved = 0;
+	std::size_t used = 0;
+};
+
+} /* namespace json */
+} /* namespace az */
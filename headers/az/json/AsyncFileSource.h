@@ -0,0 +1,101 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "FileSource.h"
+#include "ReadAheadSource.h"
+
+namespace az {
+namespace json {
+
+// a queue of asynchronous file reads which is shared by many sources (io_uring on Linux)
+class IoRing
+{
+public:
+	struct Request {
+		int result = 0;
+		bool done = false;
+	};
+
+	// zero entries disable the ring, so the sources fall back to the read-ahead threads
+	explicit IoRing(unsigned entries = 256);
+	IoRing(const IoRing&) = delete;
+	IoRing& operator=(const IoRing&) = delete;
+	~IoRing();
+
+	// returns false if the kernel does not support asynchronous reads
+	bool isAvailable() const;
+
+	// queues a read which is submitted together with other queued reads on the next wait
+	void read(Request&, int file, char* buffer, uint32_t size, uint64_t offset);
+	// waits for the request to be completed while dispatching completions of other requests
+	void wait(Request&);
+
+private:
+	struct Queue;
+
+	// submits the queued reads without waiting for them
+	void flush();
+	void reap();
+	template<class Predicate>
+	void waitUntil(std::unique_lock<std::mutex>&, Predicate);
+
+private:
+	std::unique_ptr<Queue> queue;
+	std::mutex mutex;
+	std::condition_variable condition;
+	// a thread which is waiting for completions in the kernel
+	bool reaping = false;
+	unsigned pending = 0;
+	unsigned inflight = 0;
+};
+
+// a source which reads a file by blocks asynchronously through the shared ring
+class AsyncFileSource : public Source
+{
+public:
+	struct Options {
+		// a number of blocks which are read ahead of the parser
+		uint32_t blocks = 2;
+		uint32_t block_size = 1 << 18;
+		Options() {}
+	};
+
+	AsyncFileSource(IoRing&, const std::string& path, const Options& options = {});
+	AsyncFileSource(const AsyncFileSource&) = delete;
+	AsyncFileSource& operator=(const AsyncFileSource&) = delete;
+	~AsyncFileSource();
+
+	std::char_traits<char>::int_type getCharacter() const override;
+	// returns false if the source has fallen back to the read-ahead thread
+	bool isAsynchronous() const;
+
+private:
+	void skipCharacter() override;
+	void requestBlock(std::size_t slot);
+	void acquireBlock();
+	// waits for the reads which still use the buffers
+	void release();
+
+private:
+	IoRing& ring;
+	std::string path;
+	int file = -1;
+	uint64_t file_size = 0;
+	uint64_t requested = 0;
+	std::vector<std::vector<char>> buffers;
+	std::vector<IoRing::Request> requests;
+	std::vector<uint64_t> offsets;
+	// sizes of the requested blocks, zero means that the slot is not used
+	std::vector<uint32_t> sizes;
+	std::size_t slot = 0;
+	const char* current = nullptr;
+	const char* last = nullptr;
+	bool started = false;
+	// the fallback when the ring is not available
+	std::unique_ptr<FileSource> fallback_file;
+	std::unique_ptr<ReadAheadSource> fallback;
+};
+
+} /* namespace json */
+} /* namespace az */
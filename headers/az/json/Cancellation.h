@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace az {
+namespace json {
+
+// a token which stops the Reader or the Writer on request or once its deadline is expired
+class Cancellation
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// the token is checked once per the interval of tokens (or values for the Writer) to keep it cheap
+	explicit Cancellation(uint32_t interval = 1024);
+	Cancellation(const Cancellation&) = delete;
+	Cancellation& operator=(const Cancellation&) = delete;
+
+	Cancellation& withDeadline(Clock::time_point);
+	Cancellation& withTimeout(Clock::duration);
+
+	// may be called from any thread
+	void cancel();
+	bool isCancelled() const;
+	uint32_t getInterval() const;
+
+private:
+	std::atomic<bool> cancelled;
+	// ticks of the clock since its epoch, the maximum means no deadline
+	std::atomic<Clock::rep> deadline;
+	uint32_t interval;
+};
+
+} /* namespace json */
+} /* namespace az */
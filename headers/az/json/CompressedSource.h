@@ -0,0 +1,54 @@
+#pragma once
+#include <memory>
+#include "Reader.h"
+
+namespace az {
+namespace json {
+
+enum class Compression {
+	None,
+	Gzip,
+	Zstd
+};
+
+// recognizes a compression format by the magic bytes at the beginning of the data
+Compression detectCompression(const char* data, std::size_t size);
+
+// a source which decompresses gzip (or zlib) data of another source block by block
+class GzipSource : public BlockSource
+{
+public:
+	explicit GzipSource(BlockSource& input, std::size_t block_size = 1 << 16);
+	GzipSource(const GzipSource&) = delete;
+	GzipSource& operator=(const GzipSource&) = delete;
+	~GzipSource();
+
+	// returns false if the library is built without zlib
+	static bool isSupported();
+	std::size_t readBlock(char* buffer, std::size_t size) override;
+
+private:
+	struct Stream;
+	std::unique_ptr<Stream> stream;
+};
+
+// a source which decompresses zstd data of another source block by block
+class ZstdSource : public BlockSource
+{
+public:
+	explicit ZstdSource(BlockSource& input, std::size_t block_size = 1 << 16);
+	ZstdSource(const ZstdSource&) = delete;
+	ZstdSource& operator=(const ZstdSource&) = delete;
+	~ZstdSource();
+
+	// returns false if the library is built without zstd
+	static bool isSupported();
+	std::size_t readBlock(char* buffer, std::size_t size) override;
+
+private:
+	struct Stream;
+	std::unique_ptr<Stream> stream;
+};
+
+} /* namespace json */
+} /* namespace az */
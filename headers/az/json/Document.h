@@ -0,0 +1,46 @@
+#pragma once
+#include <istream>
+#include <string>
+#include "Arena.h"
+#include "Reader.h"
+#include "Value.h"
+
+namespace az {
+namespace json {
+
+// a parsed tree which keeps all its strings, arrays and objects in its own arena,
+// so the tree is destroyed by releasing the arena at once instead of value by value
+class Document
+{
+public:
+	explicit Document(const Arena::Options& options = {});
+	~Document();
+	Document(const Document&) = delete;
+	Document& operator=(const Document&) = delete;
+
+	// parses a text into the arena instead of the previous tree, the memory resource of the options is ignored
+	Document& parse(const char* text, std::size_t size, Reader::Options options = {});
+	Document& parse(const std::string& text, Reader::Options options = {});
+	Document& parse(std::istream& stream, Reader::Options options = {});
+	Document& parseFile(const std::string& path, Reader::Options options = {});
+
+	const Value& getRoot() const;
+	// the tree which may be modified through the reference is destroyed value by value,
+	// since the modified values may take their memory out of the arena
+	Value& modifyRoot();
+	const Arena& getArena() const;
+
+	// destroys the tree and releases the arena
+	void clear();
+
+private:
+	Reader::Options prepare(Reader::Options options);
+
+	Arena arena;
+	Value root;
+	// true while all storage of the tree is known to be taken from the arena
+	bool sealed = true;
+};
+
+} /* namespace json */
+} /* namespace az */
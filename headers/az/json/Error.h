@@ -1,27 +1,46 @@
-#pragma once
-#include <string>
-#include <exception>
-
-namespace az {
-namespace json {
-
-class Error : public std::exception
-{
-	struct Context {
-		int line = -1;
-		int column = -1;
-		std::string reason;
-	};
-public:
-	Error() = default;
-	Error(const std::string& reason, int line = -1, int column = -1);
-	char const* what() const noexcept override;
-	int column() const;
-	int line() const;
-
-private:
-	Context context;
-};
-
-} /* namespace json */
-} /* namespace az */
+#pragma once
+#include <string>
+#include <cstdint>
+#include <exception>
+
+namespace az {
+namespace json {
+
+class Error : public std::exception
+{
+public:
+	enum class Code : uint8_t {
+		Generic,
+		// the text is not a valid JSON5
+		Syntax,
+		// the text is not a well-formed UTF-8
+		Encoding,
+		// the text exceeds one of the resource limits
+		Limit,
+		// the reading or writing is stopped by a cancellation token
+		Cancelled
+	};
+private:
+	struct Context {
+		int line = -1;
+		int column = -1;
+		int64_t offset = -1;
+		Code code = Code::Generic;
+		std::string reason;
+	};
+public:
+	Error() = default;
+	Error(const std::string& reason, int line = -1, int column = -1, int64_t offset = -1, Code code = Code::Generic);
+	char const* what() const noexcept override;
+	int column() const;
+	int line() const;
+	// returns a byte offset of the error from the beginning of the source
+	int64_t offset() const;
+	Code code() const;
+
+private:
+	Context context;
+};
+
+} /* namespace json */
+} /* namespace az */
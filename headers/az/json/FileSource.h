@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdio>
+#include "Reader.h"
+
+namespace az {
+namespace json {
+
+// a source which reads a file by large blocks
+class FileSource : public BlockSource
+{
+public:
+	explicit FileSource(const std::string& path, std::size_t block_size = 1 << 16);
+	FileSource(const FileSource&) = delete;
+	FileSource& operator=(const FileSource&) = delete;
+	~FileSource();
+
+	std::size_t readBlock(char* buffer, std::size_t size) override;
+	// reads the first bytes of the file which are still returned by the next blocks,
+	// so a pipe is read only once as well, returns fewer bytes at the end of the file
+	std::size_t peek(char* buffer, std::size_t size);
+
+private:
+	std::size_t readFile(char* buffer, std::size_t size);
+
+	std::string path;
+	std::FILE* file = nullptr;
+	// bytes which have been peeked and not yet read
+	std::string peeked;
+};
+
+} /* namespace json */
+} /* namespace az */
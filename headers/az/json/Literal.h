@@ -0,0 +1,659 @@
+#pragma once
+#if __cplusplus < 202002L
+#error "az/json/Literal.h requires C++20 or later"
+#endif
+#ifndef AZ_JSON_CONSTEXPR_LITERALS
+#error "az/json/Literal.h is used instead of the runtime literals when AZ_JSON_CONSTEXPR_LITERALS is defined"
+#endif
+#include <cstdlib>
+#include <string_view>
+#include "Reader.h"
+
+// compile-time JSON5 literals:
+//  - "..."_json is checked during the compilation and materialized into a Value only once
+//  - "..."_json_view provides the constant representation without any Value at all
+
+namespace az {
+namespace json {
+namespace literal {
+
+// a text of a literal which is passed as a template argument
+template<std::size_t N>
+struct Text
+{
+	char data[N] = {};
+
+	constexpr Text(const char (&text)[N]) {
+		for (std::size_t index = 0; index < N; index++) {
+			data[index] = text[index];
+		}
+	}
+	constexpr std::size_t size() const {
+		return N - 1;
+	}
+};
+
+struct Node
+{
+	Value::Type type = Value::Type::Null;
+	bool boolean = false;
+	// an integer value or a number of elements of a container
+	int64_t integer = 0;
+	// a string or a text of a real number
+	uint32_t text = 0;
+	uint32_t text_size = 0;
+	// a key of an object member
+	uint32_t key = 0;
+	uint32_t key_size = 0;
+	// an index of the node which follows the last descendant
+	uint32_t end = 0;
+};
+
+// it is not constexpr, so a call of it stops the compilation with the reason in the diagnostics
+inline void syntaxError(const char* reason, std::size_t /*offset*/)
+{
+	throw Error(reason);
+}
+
+// throws on access to a missing element of a view
+inline void rangeError(const char* reason)
+{
+	throw Error(reason);
+}
+
+// an immutable preorder sequence of nodes and their unescaped texts
+template<std::size_t Nodes, std::size_t Chars>
+struct Tape
+{
+	Node nodes[Nodes + 1] = {};
+	char chars[Chars + 1] = {};
+	std::size_t node_count = 0;
+	std::size_t char_count = 0;
+
+	constexpr uint32_t addNode() {
+		return uint32_t(node_count++);
+	}
+	constexpr Node& getNode(uint32_t index) {
+		return nodes[index];
+	}
+	constexpr void addChar(char letter) {
+		chars[char_count++] = letter;
+	}
+};
+
+// measures a tape without storing anything
+struct Sizes
+{
+	Node node;
+	std::size_t node_count = 0;
+	std::size_t char_count = 0;
+
+	constexpr uint32_t addNode() {
+		return uint32_t(node_count++);
+	}
+	constexpr Node& getNode(uint32_t) {
+		return node;
+	}
+	constexpr void addChar(char) {
+		char_count++;
+	}
+};
+
+constexpr bool isDigit(int letter)
+{
+	return letter >= '0' && letter <= '9';
+}
+
+constexpr bool isHexDigit(int letter)
+{
+	return isDigit(letter) || (letter >= 'a' && letter <= 'f') || (letter >= 'A' && letter <= 'F');
+}
+
+constexpr int getHexDigit(int letter)
+{
+	return isDigit(letter) ? letter - '0' : (letter | 0x20) - 'a' + 10;
+}
+
+constexpr bool isAlpha(int letter)
+{
+	return (letter >= 'a' && letter <= 'z') || (letter >= 'A' && letter <= 'Z');
+}
+
+constexpr bool isSpace(int letter)
+{
+	return letter == ' ' || (letter >= '\t' && letter <= '\r');
+}
+
+// the same grammar as the one of az::json::Reader, but evaluated by the compiler
+template<class Storage>
+class Parser
+{
+	enum class Token {
+		Identifier,
+		Assignment,
+		ObjectBegin,
+		ObjectEnd,
+		ArrayBegin,
+		ArrayEnd,
+		Next,
+		String,
+		Integer,
+		Real,
+		Hex,
+		End
+	};
+
+	const char* text;
+	std::size_t size;
+	Storage& storage;
+	std::size_t offset = 0;
+	// the current lexeme
+	std::size_t begin = 0;
+
+	constexpr int peek(std::size_t shift = 0) const {
+		return offset + shift < size ? static_cast<unsigned char>(text[offset + shift]) : -1;
+	}
+	constexpr bool isLexeme(std::string_view lexeme) const {
+		return std::string_view(text + begin, offset - begin) == lexeme;
+	}
+	constexpr bool isSpecialSpace() const {
+		// Byte Order Mark, Line separator and Paragraph separator
+		return (peek() == 0xEF && peek(1) == 0xBB && peek(2) == 0xBF) ||
+			(peek() == 0xE2 && peek(1) == 0x80 && (peek(2) == 0xA8 || peek(2) == 0xA9));
+	}
+
+	constexpr void skipSpaces() {
+		while (offset < size) {
+			if (isSpace(peek())) {
+				offset++;
+			}
+			else if (isSpecialSpace()) {
+				offset += 3;
+			}
+			else if (peek() == '/' && peek(1) == '/') {
+				while (offset < size && peek() != '\n') {
+					offset++;
+				}
+			}
+			else if (peek() == '/' && peek(1) == '*') {
+				offset += 2;
+				while (!(peek() == '*' && peek(1) == '/')) {
+					if (offset >= size) {
+						syntaxError("unterminated comment", begin);
+					}
+					offset++;
+				}
+				offset += 2;
+			}
+			else if (peek() == '/') {
+				syntaxError("unexpected character", offset);
+			}
+			else {
+				break;
+			}
+		}
+	}
+
+	constexpr void skipDigits() {
+		while (isDigit(peek())) {
+			offset++;
+		}
+	}
+
+	constexpr Token nextNumber() {
+		bool digits = isDigit(peek());
+		skipDigits();
+		if ((peek() == 'x' || peek() == 'X') && offset - begin == std::size_t(1 + (text[begin] == '-' || text[begin] == '+')) && text[offset - 1] == '0') {
+			offset++;
+			if (!isHexDigit(peek())) {
+				syntaxError("hexadecimal digits were expected", offset);
+			}
+			while (isHexDigit(peek())) {
+				offset++;
+			}
+			return Token::Hex;
+		}
+		Token token = Token::Integer;
+		if (peek() == '.') {
+			token = Token::Real;
+			offset++;
+			digits = digits || isDigit(peek());
+			skipDigits();
+		}
+		if (!digits) {
+			syntaxError("digits were expected", offset);
+		}
+		if (peek() == 'e' || peek() == 'E') {
+			token = Token::Real;
+			offset++;
+			if (peek() == '+' || peek() == '-') {
+				offset++;
+			}
+			if (!isDigit(peek())) {
+				syntaxError("exponent digits were expected", offset);
+			}
+			skipDigits();
+		}
+		return token;
+	}
+
+	constexpr Token nextToken() {
+		skipSpaces();
+		begin = offset;
+		int letter = peek();
+		switch (letter) {
+			case -1:
+				return Token::End;
+			case ':':
+				offset++;
+				return Token::Assignment;
+			case ',':
+				offset++;
+				return Token::Next;
+			case '{':
+				offset++;
+				return Token::ObjectBegin;
+			case '}':
+				offset++;
+				return Token::ObjectEnd;
+			case '[':
+				offset++;
+				return Token::ArrayBegin;
+			case ']':
+				offset++;
+				return Token::ArrayEnd;
+			case '"':
+			case '\'':
+				for (offset++; peek() != letter; offset++) {
+					if (peek() == -1) {
+						syntaxError("unterminated string", begin);
+					}
+					if (peek() == '\\') {
+						offset++;
+						if (peek() == 'u') {
+							for (int digit = 1; digit <= 4; digit++) {
+								if (!isHexDigit(peek(digit))) {
+									syntaxError("invalid unicode escape sequence", offset);
+								}
+							}
+							offset += 4;
+						}
+						else if (peek() == -1 || std::string_view("\"\'\\/bfnrt\n").find(char(peek())) == std::string_view::npos) {
+							syntaxError("invalid escape sequence", offset);
+						}
+					}
+				}
+				offset++;
+				return Token::String;
+			case '-':
+			case '+':
+				offset++;
+				if (isAlpha(peek())) {
+					while (isAlpha(peek())) {
+						offset++;
+					}
+					if (!isLexeme("-Infinity") && !isLexeme("+Infinity") && !isLexeme("-NaN") && !isLexeme("+NaN")) {
+						syntaxError("Infinity or NaN were expected", begin);
+					}
+					return Token::Real;
+				}
+				return nextNumber();
+			case '.':
+				return nextNumber();
+			default:
+				if (isDigit(letter)) {
+					return nextNumber();
+				}
+				if (isAlpha(letter) || letter == '_') {
+					while (isAlpha(peek()) || isDigit(peek()) || peek() == '_') {
+						offset++;
+					}
+					return Token::Identifier;
+				}
+				syntaxError("unexpected character", offset);
+				return Token::End;
+		}
+	}
+
+	constexpr void addText(Node& node, std::size_t first, std::size_t last) {
+		node.text = uint32_t(storage.char_count);
+		for (auto index = first; index < last; index++) {
+			storage.addChar(text[index]);
+		}
+		node.text_size = uint32_t(storage.char_count - node.text);
+	}
+
+	constexpr void addUnicode(uint32_t unicode) {
+		// the same conversion as Reader::convertUnicode
+		if (unicode <= 0x7F) {
+			storage.addChar(char(unicode));
+		}
+		else if (unicode <= 0x7FF) {
+			storage.addChar(char(0xC0 | (0x1F & (unicode >> 6))));
+			storage.addChar(char(0x80 | (0x3F & unicode)));
+		}
+		else {
+			storage.addChar(char(0xE0 | (0xF & (unicode >> 12))));
+			storage.addChar(char(0x80 | (0x3F & (unicode >> 6))));
+			storage.addChar(char(0x80 | (0x3F & unicode)));
+		}
+	}
+
+	// the same unescaping as Reader::unescapeString
+	constexpr void addString(uint32_t& position, uint32_t& length) {
+		position = uint32_t(storage.char_count);
+		for (auto index = begin + 1; index + 1 < offset; index++) {
+			if (text[index] != '\\') {
+				storage.addChar(text[index]);
+				continue;
+			}
+			switch (text[++index]) {
+				case 'b': storage.addChar('\b'); break;
+				case 'f': storage.addChar('\f'); break;
+				case 'n': storage.addChar('\n'); break;
+				case 'r': storage.addChar('\r'); break;
+				case 't': storage.addChar('\t'); break;
+				case '\n': break;
+				case 'u': {
+					uint32_t unicode = 0;
+					for (int digit = 0; digit < 4; digit++) {
+						unicode = unicode * 16 + uint32_t(getHexDigit(text[++index]));
+					}
+					addUnicode(unicode);
+					break;
+				}
+				default: storage.addChar(text[index]);
+			}
+		}
+		length = uint32_t(storage.char_count - position);
+	}
+
+	constexpr int64_t getInteger(int base) const {
+		auto index = begin;
+		bool negative = text[index] == '-';
+		if (text[index] == '-' || text[index] == '+') {
+			index++;
+		}
+		if (base == 16) {
+			index += 2;
+		}
+		// accumulates a negative number to reach the minimum
+		int64_t number = 0;
+		const int64_t limit = negative ? INT64_MIN : -INT64_MAX;
+		for (; index < offset; index++) {
+			int digit = getHexDigit(text[index]);
+			if (number < (limit + digit) / base) {
+				syntaxError("integer is out of range", begin);
+			}
+			number = number * base - digit;
+		}
+		return negative ? number : -number;
+	}
+
+	constexpr void parseValue(Token token, uint32_t index) {
+		switch (token) {
+			case Token::String:
+				storage.getNode(index).type = Value::Type::String;
+				addString(storage.getNode(index).text, storage.getNode(index).text_size);
+				break;
+			case Token::Integer:
+			case Token::Hex:
+				storage.getNode(index).type = Value::Type::Integer;
+				storage.getNode(index).integer = getInteger(token == Token::Hex ? 16 : 10);
+				break;
+			case Token::Real:
+				storage.getNode(index).type = Value::Type::Real;
+				addText(storage.getNode(index), begin, offset);
+				break;
+			case Token::Identifier:
+				if (isLexeme("true") || isLexeme("false")) {
+					storage.getNode(index).type = Value::Type::Bool;
+					storage.getNode(index).boolean = isLexeme("true");
+				}
+				else if (isLexeme("NaN") || isLexeme("Infinity")) {
+					storage.getNode(index).type = Value::Type::Real;
+					addText(storage.getNode(index), begin, offset);
+				}
+				else if (!isLexeme("null")) {
+					// the Reader takes other identifiers as strings
+					storage.getNode(index).type = Value::Type::String;
+					addText(storage.getNode(index), begin, offset);
+				}
+				break;
+			case Token::ArrayBegin:
+				parseArray(index);
+				break;
+			case Token::ObjectBegin:
+				parseObject(index);
+				break;
+			default:
+				syntaxError("value was expected", begin);
+		}
+		storage.getNode(index).end = uint32_t(storage.node_count);
+	}
+
+	constexpr void parseArray(uint32_t index) {
+		storage.getNode(index).type = Value::Type::Array;
+		for (auto token = nextToken(); token != Token::ArrayEnd; ) {
+			auto element = storage.addNode();
+			parseValue(token, element);
+			storage.getNode(index).integer++;
+			token = nextToken();
+			if (token == Token::Next) {
+				token = nextToken();
+			}
+			else if (token != Token::ArrayEnd) {
+				syntaxError("']' or ',' were expected", begin);
+			}
+		}
+	}
+
+	constexpr void parseObject(uint32_t index) {
+		storage.getNode(index).type = Value::Type::Object;
+		for (auto token = nextToken(); token != Token::ObjectEnd; ) {
+			auto member = storage.addNode();
+			if (token == Token::Identifier) {
+				addText(storage.getNode(member), begin, offset);
+			}
+			else if (token == Token::String) {
+				addString(storage.getNode(member).text, storage.getNode(member).text_size);
+			}
+			else {
+				syntaxError("identifier, string or } were expected", begin);
+			}
+			// the key is kept apart since the text is used by the value
+			storage.getNode(member).key = storage.getNode(member).text;
+			storage.getNode(member).key_size = storage.getNode(member).text_size;
+			storage.getNode(member).text = storage.getNode(member).text_size = 0;
+			if (storage.getNode(member).key_size == 0) {
+				syntaxError("empty object name", begin);
+			}
+			if (nextToken() != Token::Assignment) {
+				syntaxError("assignment was expected", begin);
+			}
+			parseValue(nextToken(), member);
+			storage.getNode(index).integer++;
+			token = nextToken();
+			if (token == Token::Next) {
+				token = nextToken();
+			}
+			else if (token != Token::ObjectEnd) {
+				syntaxError("'}' or ',' were expected", begin);
+			}
+		}
+	}
+
+public:
+	constexpr Parser(const char* text, std::size_t size, Storage& storage)
+		: text(text), size(size), storage(storage) {}
+
+	constexpr void parse() {
+		parseValue(nextToken(), storage.addNode());
+		if (nextToken() != Token::End) {
+			syntaxError("expected end of file", begin);
+		}
+	}
+};
+
+template<Text text>
+consteval auto compile()
+{
+	constexpr auto sizes = [] {
+		Sizes sizes;
+		Parser<Sizes>(text.data, text.size(), sizes).parse();
+		return sizes;
+	}();
+	Tape<sizes.node_count, sizes.char_count> tape;
+	Parser<decltype(tape)>(text.data, text.size(), tape).parse();
+	return tape;
+}
+
+// a read-only view of a node of the constant representation
+class View
+{
+	const Node* nodes = nullptr;
+	const char* chars = nullptr;
+	uint32_t index = 0;
+
+	constexpr const Node& node() const {
+		return nodes[index];
+	}
+	constexpr View child(uint32_t child) const {
+		return View(nodes, chars, child);
+	}
+	constexpr std::string_view text(uint32_t position, uint32_t size) const {
+		return std::string_view(chars + position, size);
+	}
+
+public:
+	constexpr View(const Node* nodes, const char* chars, uint32_t index = 0)
+		: nodes(nodes), chars(chars), index(index) {}
+
+	constexpr Value::Type getType() const { return node().type; }
+	constexpr bool isNull() const { return getType() == Value::Type::Null; }
+	constexpr bool isBool() const { return getType() == Value::Type::Bool; }
+	constexpr bool isInteger() const { return getType() == Value::Type::Integer; }
+	constexpr bool isReal() const { return getType() == Value::Type::Real; }
+	constexpr bool isString() const { return getType() == Value::Type::String; }
+	constexpr bool isArray() const { return getType() == Value::Type::Array; }
+	constexpr bool isObject() const { return getType() == Value::Type::Object; }
+
+	constexpr bool asBool() const {
+		return node().boolean;
+	}
+	constexpr int64_t asInteger() const {
+		return node().integer;
+	}
+	// real numbers are kept as their text to be converted exactly like the Reader does it
+	double asReal() const {
+		if (isInteger()) {
+			return double(node().integer);
+		}
+		return std::strtod(std::string(asString()).c_str(), nullptr);
+	}
+	constexpr std::string_view asString() const {
+		return text(node().text, node().text_size);
+	}
+	constexpr std::string_view getKey() const {
+		return text(node().key, node().key_size);
+	}
+
+	// returns a number of elements of an array or an object
+	constexpr uint32_t size() const {
+		return isArray() || isObject() ? uint32_t(node().integer) : 0;
+	}
+	constexpr View operator[](uint32_t position) const {
+		auto element = index + 1;
+		for (; position > 0 && element < node().end; position--) {
+			element = nodes[element].end;
+		}
+		if (!(isArray() || isObject()) || element >= node().end) {
+			rangeError("index is out of range");
+		}
+		return child(element);
+	}
+	constexpr bool has(std::string_view key) const {
+		return find(key) != 0;
+	}
+	constexpr View operator[](std::string_view key) const {
+		auto member = find(key);
+		if (member == 0) {
+			rangeError("key is not found");
+		}
+		return child(member);
+	}
+
+	Value materialize() const {
+		switch (getType()) {
+			case Value::Type::Bool:
+				return Value(asBool());
+			case Value::Type::Integer:
+				return Value(asInteger());
+			case Value::Type::Real:
+				return Value(asReal());
+			case Value::Type::String:
+				return Value(std::string(asString()));
+			case Value::Type::Array: {
+				Value array(Value::Type::Array);
+				for (auto element = index + 1; element < node().end; element = nodes[element].end) {
+					array.append(child(element).materialize());
+				}
+				return array;
+			}
+			case Value::Type::Object: {
+				Value object(Value::Type::Object);
+				for (auto member = index + 1; member < node().end; member = nodes[member].end) {
+					object[std::string(child(member).getKey())] = child(member).materialize();
+				}
+				return object;
+			}
+			default:
+				return Value();
+		}
+	}
+
+private:
+	// returns an index of the last member with the key like the Reader keeps the last one
+	constexpr uint32_t find(std::string_view key) const {
+		uint32_t found = 0;
+		if (isObject()) {
+			for (auto member = index + 1; member < node().end; member = nodes[member].end) {
+				if (child(member).getKey() == key) {
+					found = member;
+				}
+			}
+		}
+		return found;
+	}
+};
+
+template<Text text>
+struct Literal
+{
+	static constexpr auto tape = compile<text>();
+
+	static constexpr View view() {
+		return View(tape.nodes, tape.chars);
+	}
+	// the value is made on the first use and then shared
+	static const Value& value() {
+		static const Value value = view().materialize();
+		return value;
+	}
+};
+
+} /* namespace literal */
+} /* namespace json */
+} /* namespace az */
+
+template<az::json::literal::Text text>
+const az::json::Value& operator""_json()
+{
+	return az::json::literal::Literal<text>::value();
+}
+
+template<az::json::literal::Text text>
+constexpr az::json::literal::View operator""_json_view()
+{
+	return az::json::literal::Literal<text>::view();
+}
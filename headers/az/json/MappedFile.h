@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace az {
+namespace json {
+
+// a read-only view of a whole file mapped into memory
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	const char* data() const;
+	std::size_t size() const;
+	// returns the last modification time of the file in nanoseconds
+	int64_t getModificationTime() const;
+	const std::string& getPath() const;
+
+private:
+	std::string path;
+	const char* address = nullptr;
+	std::size_t length = 0;
+	int64_t modification_time = 0;
+	// keeps the content of the file on systems without memory mapping
+	std::vector<char> content;
+};
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+namespace az {
+namespace json {
+
+// a source of memory for strings, arrays and objects of values as std::pmr::memory_resource of C++17 is
+class MemoryResource
+{
+public:
+	virtual ~MemoryResource() = default;
+
+	void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+		return doAllocate(size, alignment);
+	}
+	void deallocate(void* memory, std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+		doDeallocate(memory, size, alignment);
+	}
+
+	// takes memory by operator new
+	static MemoryResource* getDefault();
+	// values which are made by the current thread take their memory from this resource
+	static MemoryResource* getCurrent();
+
+	// makes a resource current for the thread until the scope is left, a null resource keeps the current one
+	class Scope
+	{
+	public:
+		explicit Scope(MemoryResource*);
+		~Scope();
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		MemoryResource* previous;
+	};
+
+protected:
+	virtual void* doAllocate(std::size_t size, std::size_t alignment) = 0;
+	virtual void doDeallocate(void* memory, std::size_t size, std::size_t alignment) = 0;
+};
+
+// an allocator of standard containers which takes memory from the resource which is current when it is made
+template<class T>
+class Allocator
+{
+public:
+	using value_type = T;
+	// a container which is moved or swapped takes the resource of the other one
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	Allocator() noexcept
+		: resource(MemoryResource::getCurrent()) {}
+	explicit Allocator(MemoryResource* resource) noexcept
+		: resource(resource) {}
+	template<class U>
+	Allocator(const Allocator<U>& other) noexcept
+		: resource(other.getResource()) {}
+
+	T* allocate(std::size_t count) {
+		return static_cast<T*>(resource->allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T* memory, std::size_t count) noexcept {
+		resource->deallocate(memory, count * sizeof(T), alignof(T));
+	}
+	MemoryResource* getResource() const noexcept {
+		return resource;
+	}
+
+	template<class U>
+	bool operator==(const Allocator<U>& other) const noexcept {
+		return resource == other.getResource();
+	}
+	template<class U>
+	bool operator!=(const Allocator<U>& other) const noexcept {
+		return resource != other.getResource();
+	}
+
+private:
+	MemoryResource* resource;
+};
+
+} /* namespace json */
+} /* namespace az */
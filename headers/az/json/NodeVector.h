@@ -0,0 +1,265 @@
+#pragma once
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <new>
+#include "MemoryResource.h"
+
+namespace az {
+namespace json {
+
+// a vector which allocates its elements one by one and keeps pointers to them,
+// so references to the elements survive inserting others and sorting them by sortNodes
+template<class T>
+class NodeVector
+{
+	using Nodes = std::vector<T*, Allocator<T*>>;
+
+	// an iterator over the pointers which gives the elements they point to
+	template<class Element>
+	class Indirect
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Element*;
+		using reference = Element&;
+
+		Indirect() = default;
+		explicit Indirect(typename Nodes::const_iterator node)
+			: node(node) {}
+		// a mutable iterator converts to a constant one
+		template<class Other, class = typename std::enable_if<std::is_same<const Other, Element>::value>::type>
+		Indirect(const Indirect<Other>& other)
+			: node(other.base()) {}
+
+		typename Nodes::const_iterator base() const {
+			return node;
+		}
+		reference operator*() const {
+			return **node;
+		}
+		pointer operator->() const {
+			return *node;
+		}
+		reference operator[](difference_type offset) const {
+			return *node[offset];
+		}
+		Indirect& operator++() {
+			++node;
+			return *this;
+		}
+		Indirect operator++(int) {
+			return Indirect(node++);
+		}
+		Indirect& operator--() {
+			--node;
+			return *this;
+		}
+		Indirect operator--(int) {
+			return Indirect(node--);
+		}
+		Indirect& operator+=(difference_type offset) {
+			node += offset;
+			return *this;
+		}
+		Indirect& operator-=(difference_type offset) {
+			node -= offset;
+			return *this;
+		}
+		Indirect operator+(difference_type offset) const {
+			return Indirect(node + offset);
+		}
+		friend Indirect operator+(difference_type offset, const Indirect& iterator) {
+			return iterator + offset;
+		}
+		Indirect operator-(difference_type offset) const {
+			return Indirect(node - offset);
+		}
+		difference_type operator-(const Indirect& other) const {
+			return node - other.node;
+		}
+		bool operator==(const Indirect& other) const {
+			return node == other.node;
+		}
+		bool operator!=(const Indirect& other) const {
+			return node != other.node;
+		}
+		bool operator<(const Indirect& other) const {
+			return node < other.node;
+		}
+		bool operator>(const Indirect& other) const {
+			return node > other.node;
+		}
+		bool operator<=(const Indirect& other) const {
+			return node <= other.node;
+		}
+		bool operator>=(const Indirect& other) const {
+			return node >= other.node;
+		}
+
+	private:
+		typename Nodes::const_iterator node;
+	};
+
+public:
+	using value_type = T;
+	using allocator_type = Allocator<T>;
+	using size_type = std::size_t;
+	using iterator = Indirect<T>;
+	using const_iterator = Indirect<const T>;
+
+	NodeVector() = default;
+	NodeVector(const NodeVector& other)
+		: nodes(other.nodes.get_allocator()) {
+		nodes.reserve(other.size());
+		for (const auto& element : other) {
+			push_back(element);
+		}
+	}
+	NodeVector(NodeVector&& other) noexcept
+		: nodes(std::move(other.nodes)) {}
+	NodeVector& operator=(const NodeVector& other) {
+		if (this != &other) {
+			clear();
+			nodes.reserve(other.size());
+			for (const auto& element : other) {
+				push_back(element);
+			}
+		}
+		return *this;
+	}
+	NodeVector& operator=(NodeVector&& other) noexcept {
+		if (this != &other) {
+			clear();
+			nodes = std::move(other.nodes);
+		}
+		return *this;
+	}
+	~NodeVector() {
+		clear();
+	}
+
+	allocator_type get_allocator() const {
+		return allocator_type(nodes.get_allocator());
+	}
+	bool empty() const {
+		return nodes.empty();
+	}
+	size_type size() const {
+		return nodes.size();
+	}
+	size_type capacity() const {
+		return nodes.capacity();
+	}
+	// reserves the pointers only, the elements are allocated as they are added
+	void reserve(size_type size) {
+		nodes.reserve(size);
+	}
+	void clear() {
+		for (auto node : nodes) {
+			destroy(node);
+		}
+		nodes.clear();
+	}
+
+	T& operator[](size_type position) {
+		return *nodes[position];
+	}
+	const T& operator[](size_type position) const {
+		return *nodes[position];
+	}
+	T& back() {
+		return *nodes.back();
+	}
+	const T& back() const {
+		return *nodes.back();
+	}
+	iterator begin() {
+		return iterator(nodes.begin());
+	}
+	iterator end() {
+		return iterator(nodes.end());
+	}
+	const_iterator begin() const {
+		return const_iterator(nodes.begin());
+	}
+	const_iterator end() const {
+		return const_iterator(nodes.end());
+	}
+
+	template<class... Arguments>
+	void emplace_back(Arguments&&... arguments) {
+		insertNode(nodes.end(), create(std::forward<Arguments>(arguments)...));
+	}
+	void push_back(const T& element) {
+		emplace_back(element);
+	}
+	void push_back(T&& element) {
+		emplace_back(std::move(element));
+	}
+	iterator insert(const_iterator position, T&& element) {
+		const auto offset = position - begin();
+		insertNode(nodes.begin() + offset, create(std::move(element)));
+		return begin() + offset;
+	}
+	iterator erase(const_iterator first, const_iterator last) {
+		const auto offset = first - begin();
+		for (auto node = first.base(); node != last.base(); ++node) {
+			destroy(*node);
+		}
+		nodes.erase(first.base(), last.base());
+		return begin() + offset;
+	}
+	// moves the pointers instead of the elements, so references to them stay valid
+	template<class Compare>
+	void sortNodes(Compare compare) {
+		std::sort(nodes.begin(), nodes.end(), [&compare](const T* left, const T* right) {
+			return compare(*left, *right);
+		});
+	}
+
+	friend bool operator==(const NodeVector& left, const NodeVector& right) {
+		return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin());
+	}
+	friend bool operator!=(const NodeVector& left, const NodeVector& right) {
+		return !(left == right);
+	}
+
+private:
+	template<class... Arguments>
+	T* create(Arguments&&... arguments) {
+		auto allocator = get_allocator();
+		T* node = allocator.allocate(1);
+		try {
+			::new (static_cast<void*>(node)) T(std::forward<Arguments>(arguments)...);
+		}
+		catch (...) {
+			allocator.deallocate(node, 1);
+			throw;
+		}
+		return node;
+	}
+	void destroy(T* node) {
+		node->~T();
+		get_allocator().deallocate(node, 1);
+	}
+	void insertNode(typename Nodes::const_iterator position, T* node) {
+		try {
+			nodes.insert(position, node);
+		}
+		catch (...) {
+			destroy(node);
+			throw;
+		}
+	}
+
+private:
+	Nodes nodes;
+};
+
+} /* namespace json */
+} /* namespace az */
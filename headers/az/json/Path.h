@@ -1,6 +1,7 @@
 #pragma once
 #include <list>
 #include "Value.h"
+#include "Tape.h"
 
 namespace az {
 namespace json {
@@ -10,8 +11,13 @@ class Path
 public:
 	Path(const std::string& path);
 	const Value& resolve(const Value& root) const;
+	// the view refers to no value if the path can not be resolved
+	Tape::View resolve(const Tape::View& root) const;
 	Value& make(Value& root) const;
 	std::string asString() const;
+	// formats a single step of a path in the same way as asString does
+	static std::string keyToString(const std::string& key);
+	static std::string indexToString(Value::Index);
 private:
 	struct Argument {
 		enum class Type {
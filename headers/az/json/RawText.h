@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Value.h"
+
+namespace az {
+namespace json {
+
+// spans of values in a parsed text which let the Writer copy values that have not been modified since parsing
+// as they are written in the text, the text has to outlive the values
+class RawText
+{
+public:
+	struct Span {
+		std::size_t begin;
+		std::size_t size;
+		// the storage of the parsed value, so values of other texts never match the span
+		const void* storage;
+	};
+
+	bool empty() const {
+		return spans.empty();
+	}
+	void clear() {
+		text = nullptr;
+		spans.clear();
+	}
+	// returns false if the value has been modified since parsing or has not been parsed from this text,
+	// only long strings, arrays and objects keep their spans, since other values take no storage
+	bool find(const Value& value, const char*& begin, std::size_t& size) const {
+		const auto storage = value.getStorage();
+		if (!storage || storage->span == 0 || storage->span > spans.size()) {
+			return false;
+		}
+		const auto& span = spans[storage->span - 1];
+		if (span.storage != storage) {
+			return false;
+		}
+		begin = text + span.begin;
+		size = span.size;
+		return true;
+	}
+
+private:
+	friend class Reader;
+	void add(Value& value, std::size_t begin, std::size_t size) {
+		// values above the maximum index are just written as usual
+		const auto storage = value.getStorage();
+		if (storage && spans.size() < UINT32_MAX) {
+			spans.push_back({begin, size, storage});
+			storage->span = Value::Index(spans.size());
+		}
+	}
+
+private:
+	const char* text = nullptr;
+	// storage of a value refers to its span by an index starting from one
+	std::vector<Span> spans;
+};
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "Reader.h"
+
+namespace az {
+namespace json {
+
+// a source which reads blocks of another source in a background thread ahead of the parser
+class ReadAheadSource : public Source
+{
+public:
+	struct Options {
+		// a number of blocks in the ring (2 - double buffering, 3 - triple buffering, etc.)
+		uint32_t blocks = 3;
+		std::size_t block_size = 1 << 20;
+		Options() {}
+	};
+
+	explicit ReadAheadSource(BlockSource& input, const Options& options = {});
+	ReadAheadSource(const ReadAheadSource&) = delete;
+	ReadAheadSource& operator=(const ReadAheadSource&) = delete;
+	~ReadAheadSource();
+
+	std::char_traits<char>::int_type getCharacter() const override;
+
+private:
+	friend class AsyncFileSource;
+
+	void skipCharacter() override;
+	// takes the next filled block from the ring
+	void acquireBlock();
+	// fills the ring in the background thread
+	void produce();
+	template<class Predicate>
+	void waitFor(Predicate);
+	void notify();
+
+private:
+	BlockSource& input;
+	std::vector<std::vector<char>> buffers;
+	std::vector<std::size_t> sizes;
+	// numbers of blocks which have been filled by the producer and released by the consumer
+	std::atomic<uint64_t> produced{0};
+	std::atomic<uint64_t> consumed{0};
+	std::atomic<bool> stopping{false};
+	std::exception_ptr failure;
+	// used only to sleep while the ring is empty or full
+	std::mutex mutex;
+	std::condition_variable condition;
+	const char* current = nullptr;
+	const char* last = nullptr;
+	bool started = false;
+	bool holding = false;
+	std::thread thread;
+};
+
+} /* namespace json */
+} /* namespace az */
@@ -1,122 +1,382 @@
-#pragma once
-#include <list>
-#include "Error.h"
-#include "Value.h"
-
-namespace az {
-namespace json {
-
-class Source
-{
-	struct Position {
-		int line = 1;
-		int column = 1;
-	} position;
-	std::string lexeme;
-
-	// moves to the next character
-	virtual void skipCharacter() = 0;
-public:
-	virtual ~Source() = default;
-	void skipLexeme(); // skips the current lexeme
-	const std::string& getLexeme() const { return lexeme; }
-	const Position& getPosition() const { return position; }
-	Source& operator++();
-
-	// returns the current character
-	virtual std::char_traits<char>::int_type getCharacter() const = 0;
-};
-
-template<class Iterator>
-class IterableSource : public Source
-{
-	Iterator first;
-	Iterator last;
-
-	void skipCharacter() override {
-		first++;
-	}
-public:
-	IterableSource(Iterator first, Iterator last)
-		: first(first), last(last) {}
-
-	std::char_traits<char>::int_type getCharacter() const override {
-		if (first < last) {
-			return std::char_traits<char>::to_int_type(*first);
-		}
-		return std::char_traits<char>::eof();
-	}
-};
-
-class Reader
-{
-public:
-	struct Options {
-		// do not allow the source to contain excess data at the end
-		bool strictly = false;
-		// do not throw exceptions, just collect them
-		bool no_throws = false;
-		Options() {}
-	};
-	Reader(Value&, const Options& options = {});
-	Reader& withNoThrows(bool = true);
-	Reader& strictly(bool = true);
-
-	Reader& parse(Source&);
-	Reader& parse(const char*);
-	Reader& parse(const std::string&);
-	Reader& parse(std::istream&);
-	Reader& parse(std::FILE*);
-
-	template<class Iterator>
-	Reader& parse(Iterator first, Iterator last) {
-		IterableSource<Iterator> source(first, last);
-		return parse(source);
-	}
-
-	bool hasErrors() const;
-	Error getLastError() const;
-
-	static std::string convertUnicode(uint32_t unicode);
-	static std::string unescapeString(const std::string&);
-
-private:
-	enum class Token {
-		Unknown,
-		Identifier,
-		Assignment,
-		ObjectBegin,
-		ObjectEnd,
-		ArrayBegin,
-		ArrayEnd,
-		Next,
-		String,
-		Integer,
-		Real,
-		Hex,
-		End
-	};
-
-	Token nextToken(Source&) const;
-	bool parseArray(Source&, Value&);
-	bool parseObject(Source&, Value&);
-	bool parseValue(Token, Source&, Value&);
-	void putError(const std::string&, int line = -1, int column = -1);
-	void putError(const std::string&, const Source&);
-private:
-	Value& root;
-	Options options;
-	std::list<Error> errors;
-};
-
-Value parse(const char* text, std::size_t size);
-Value parse(const std::string&);
-Value parse(std::istream&);
-
-} /* namespace json */
-} /* namespace az */
-
-inline az::json::Value operator""_json(const char* text, std::size_t size)
-{
-	return az::json::parse(text, size);
-}
+#pragma once
+#include <list>
+#include <vector>
+#include "Error.h"
+#include "Cancellation.h"
+#include "Value.h"
+#include "Utf8Validator.h"
+#include "RecordIndex.h"
+#include "SourceMap.h"
+#include "RawText.h"
+#include "StringSink.h"
+#include "Tape.h"
+
+namespace az {
+namespace json {
+
+class Source
+{
+	struct Position {
+		int line = 1;
+		int column = 1;
+		std::size_t offset = 0;
+	};
+	// positions of the beginning of the lexeme and of the character after it
+	Position position;
+	Position next;
+	std::string lexeme;
+	bool keeping = true;
+
+	// moves to the next character
+	virtual void skipCharacter() = 0;
+public:
+	virtual ~Source() = default;
+	void skipLexeme(); // skips the current lexeme
+	const std::string& getLexeme() const { return lexeme; }
+	const Position& getPosition() const { return position; }
+	// a size of the lexeme in the text, which counts the characters that are not kept as well
+	std::size_t getLexemeSize() const { return next.offset - position.offset; }
+	// characters which are read while the lexeme is not kept are only counted in the positions
+	void keepLexeme(bool keep) { keeping = keep; }
+	Source& operator++();
+
+	// returns the current character
+	virtual std::char_traits<char>::int_type getCharacter() const = 0;
+	// provides the rest of the text if the source keeps it contiguously in memory
+	virtual bool getBuffer(const char*&, std::size_t&) const { return false; }
+};
+
+template<class Iterator>
+class IterableSource : public Source
+{
+	Iterator first;
+	Iterator last;
+
+	void skipCharacter() override {
+		first++;
+	}
+public:
+	IterableSource(Iterator first, Iterator last)
+		: first(first), last(last) {}
+
+	std::char_traits<char>::int_type getCharacter() const override {
+		if (first < last) {
+			return std::char_traits<char>::to_int_type(*first);
+		}
+		return std::char_traits<char>::eof();
+	}
+	bool getBuffer(const char*& text, std::size_t& size) const override;
+};
+
+template<class Iterator>
+bool IterableSource<Iterator>::getBuffer(const char*&, std::size_t&) const
+{
+	return false;
+}
+
+template<>
+inline bool IterableSource<const char*>::getBuffer(const char*& text, std::size_t& size) const
+{
+	text = first;
+	size = std::size_t(last - first);
+	return true;
+}
+
+// a piece of a text which is laid out like iovec
+struct Segment {
+	const char* data;
+	std::size_t size;
+};
+
+// a source which goes through a chain of segments without joining them
+class SegmentedSource : public Source
+{
+	const Segment* segment;
+	const Segment* last;
+	const char* current = nullptr;
+	const char* end = nullptr;
+
+	void skipCharacter() override {
+		if (++current == end) {
+			++segment;
+			findSegment();
+		}
+	}
+	// moves to the first non-empty segment starting from the current one
+	void findSegment();
+public:
+	SegmentedSource(const Segment* segments, std::size_t count);
+
+	std::char_traits<char>::int_type getCharacter() const override {
+		if (current < end) {
+			return std::char_traits<char>::to_int_type(*current);
+		}
+		return std::char_traits<char>::eof();
+	}
+	bool getBuffer(const char*& text, std::size_t& size) const override;
+};
+
+// a source which reads the text by large blocks instead of single characters
+class BlockSource : public Source
+{
+	std::size_t block_size;
+	std::vector<char> buffer;
+	std::size_t current = 0;
+	std::size_t size = 0;
+	bool started = false;
+
+	void skipCharacter() override;
+	void fetchBlock();
+public:
+	explicit BlockSource(std::size_t block_size = 1 << 16);
+
+	std::char_traits<char>::int_type getCharacter() const override;
+	// reads the next block of the text into the buffer, returns 0 at the end of the text
+	virtual std::size_t readBlock(char* buffer, std::size_t size) = 0;
+	std::size_t getBlockSize() const;
+};
+
+class Reader
+{
+public:
+	// limits of resources which a parsed text may use, zero means no limit
+	struct Limits {
+		// maximum size of the text in bytes
+		uint64_t bytes = 0;
+		// maximum nesting of arrays and objects
+		uint32_t depth = 0;
+		// maximum length of a string or a key as it is written in the text
+		uint64_t string_length = 0;
+		// maximum number of elements of an array or members of an object
+		uint64_t elements = 0;
+		// maximum number of values in the whole tree
+		uint64_t values = 0;
+		// maximum heap memory in bytes which the tree is estimated to take
+		uint64_t memory = 0;
+		Limits() {}
+	};
+
+	struct Options {
+		// do not allow the source to contain excess data at the end
+		bool strictly = false;
+		// do not throw exceptions, just collect them
+		bool no_throws = false;
+		// check that the source is a well-formed UTF-8 text
+		bool utf8 = false;
+		// read files in a background thread ahead of the parser
+		bool read_ahead = false;
+		// scan a text in memory twice to allocate every array with its exact size
+		bool exact_sizing = false;
+		// take keys of objects from the ordered key lists of previous objects if they are the same
+		bool shape_caching = true;
+		// keep members of objects in the order of the text instead of the order of their keys
+		bool insertion_order = false;
+		// keep short numbers as their digits which are decoded on access and written as they are,
+		// numbers which are not written as JSON does or do not fit a value are decoded at once
+		bool lazy_numbers = false;
+		// streams string values which are longer than the threshold (zero disables it) or at the paths to the sink
+		StringSink* string_sink = nullptr;
+		std::size_t string_threshold = 1 << 20;
+		std::vector<std::string> string_paths;
+		Limits limits;
+		// stops the parsing with an error once it is cancelled
+		const Cancellation* cancellation = nullptr;
+		// takes the storage of parsed values from the resource instead of the current one
+		MemoryResource* memory_resource = nullptr;
+		Options() {}
+	};
+	Reader(Value&, const Options& options = {});
+	// parses texts into the tape instead of a value, the string sink and exact sizing are not used,
+	// source maps, raw texts and records are parsed into values only
+	Reader(Tape&, const Options& options = {});
+	Reader& withNoThrows(bool = true);
+	Reader& withUtf8Validation(bool = true);
+	Reader& withReadAhead(bool = true);
+	Reader& withExactSizing(bool = true);
+	Reader& withShapeCaching(bool = true);
+	Reader& withInsertionOrder(bool = true);
+	Reader& withLazyNumbers(bool = true);
+	Reader& withStringSink(StringSink&, std::size_t threshold = 1 << 20, const std::vector<std::string>& paths = {});
+	Reader& withLimits(const Limits&);
+	Reader& withCancellation(const Cancellation&);
+	Reader& withMemoryResource(MemoryResource*);
+	Reader& strictly(bool = true);
+
+	Reader& parse(Source&);
+	Reader& parse(const char*);
+	Reader& parse(const std::string&);
+	Reader& parse(std::istream&);
+	Reader& parse(std::FILE*);
+	Reader& parse(const Segment* segments, std::size_t count);
+	Reader& parseFile(const std::string& path);
+
+	template<class Iterator>
+	Reader& parse(Iterator first, Iterator last) {
+		IterableSource<Iterator> source(first, last);
+		return parse(source);
+	}
+
+	// checks the text with the same options as parsing does, but leaves the value untouched
+	Reader& validate(Source&);
+	Reader& validate(const char*);
+	Reader& validate(const std::string&);
+	Reader& validate(std::istream&);
+	Reader& validate(const Segment* segments, std::size_t count);
+
+	template<class Iterator>
+	Reader& validate(Iterator first, Iterator last) {
+		IterableSource<Iterator> source(first, last);
+		return validate(source);
+	}
+
+	// parses a text and records spans of its containers to re-parse it after edits
+	Reader& parse(const std::string& text, SourceMap&);
+	// applies the edits one after another to the text which has been parsed with the map,
+	// re-parsing only the smallest containers which enclose them and splicing them into the value
+	Reader& reparse(std::string& text, const std::vector<SourceMap::Edit>&, SourceMap&);
+
+	// parses a text and records spans of its values, so the Writer copies unmodified values from the text,
+	// short numbers are kept as their digits, so they are written as they are in the text as well
+	Reader& parse(const char* text, std::size_t size, RawText&);
+	Reader& parse(const std::string& text, RawText&);
+	// the spans refer to the text, so it must outlive the values
+	Reader& parse(std::string&& text, RawText&) = delete;
+
+	// parses a single record of an indexed NDJSON file
+	Reader& parseRecord(const MappedFile&, const RecordIndex&, uint64_t record);
+	// parses a range of records of an indexed NDJSON file into an array
+	Reader& parseRecords(const MappedFile&, const RecordIndex&, uint64_t first, uint64_t count);
+
+	bool hasErrors() const;
+	Error getLastError() const;
+
+	static std::string convertUnicode(uint32_t unicode);
+	static std::string unescapeString(const std::string&);
+
+private:
+	enum class Token {
+		Unknown,
+		Identifier,
+		Assignment,
+		ObjectBegin,
+		ObjectEnd,
+		ArrayBegin,
+		ArrayEnd,
+		Next,
+		String,
+		Integer,
+		Real,
+		Hex,
+		// a string which has been written to the sink
+		StreamedString,
+		End
+	};
+
+	// a string is streamed to the sink only if the token is expected to be a value
+	Token nextToken(Source&, bool streamable = false);
+	bool streamString(Source&, std::size_t& streamed);
+
+	// an ordered list of keys of objects which are repeated, for example records of an array
+	struct Shape {
+		// keys as they are written in the text
+		std::vector<std::string> lexemes;
+		std::vector<std::string> keys;
+	};
+	static const std::size_t no_shape = std::size_t(-1);
+	// a progress of matching keys of an object with a shape
+	struct ShapeMatch {
+		// no_shape while the object does not follow any of the cached shapes
+		std::size_t shape = no_shape;
+		Shape learned;
+		bool learning = false;
+	};
+	static const std::size_t max_shapes = 32;
+	static const std::size_t max_shape_size = 32;
+	const std::string* matchShape(ShapeMatch&, uint64_t member, const std::string& lexeme);
+	void learnKey(ShapeMatch&, const std::string& lexeme, const std::string& key);
+	void learnShape(ShapeMatch&);
+	static void unescapeText(const char* begin, const char* end, std::string& unescaped);
+	bool skipLexeme(Source&, bool finishing = false);
+	bool prepareSource(Source&);
+	void finishSource(Source&);
+	void read(Source&, Value*);
+	void measureSource(Source&);
+	bool reparseSpan(const std::string& text, std::size_t begin, std::size_t size, uint32_t depth, SourceMap::Span&, Value*);
+	std::size_t openContainer();
+	void parseRecords(const MappedFile&, const RecordIndex&, uint64_t first, uint64_t count, bool array);
+	// the value is null when the text is only validated
+	bool parseArray(Source&, Value*);
+	bool parseObject(Source&, Value*);
+	bool parseMembers(Source&, Value*);
+	bool parseValue(Token, Source&, Value*);
+	bool parseContainer(Token, Source&, Value*);
+	bool validateValue(Token, Source&);
+	bool parseNumber(Token, Source&, Value&);
+	// puts an error if the reader parses into a tape
+	bool rejectTape();
+	bool useMemory(std::size_t size, const Source&);
+	void putError(const std::string&, int line = -1, int column = -1, int64_t offset = -1, Error::Code = Error::Code::Generic);
+	void putError(const std::string&, const Source&, Error::Code = Error::Code::Syntax);
+	void putEncodingError(const Source&, const char* text, std::size_t size);
+private:
+	// a value which the reader of a tape refers to as its root
+	Value unused;
+	Value& root;
+	Tape* tape = nullptr;
+	// the tape which is being built by the current parsing
+	Tape* taping = nullptr;
+	Options options;
+	std::list<Error> errors;
+	// validates a source which is not kept in memory lexeme by lexeme
+	Utf8Validator validator;
+	bool validating = false;
+	// true while the text is only validated, so strings are checked without keeping them
+	bool dropping_strings = false;
+	// true if the last string has nothing but escaped new lines
+	bool empty_string = false;
+	// resources which are used by the current parsing
+	struct Usage {
+		uint32_t depth = 0;
+		uint64_t values = 0;
+		uint64_t memory = 0;
+	} usage;
+	// the limits where zero is replaced with the maximum
+	Limits limits;
+	// tokens which are left to read before the next check of the cancellation
+	uint32_t countdown = 0;
+	// sizes of containers in the order of their first elements which are counted by the first pass
+	enum class Sizing {
+		None,
+		Replaying
+	} sizing = Sizing::None;
+	std::vector<uint32_t> sizes;
+	std::size_t next_size = 0;
+	// a span of the container which is being parsed with its offset from the beginning of the text
+	SourceMap::Span* spans = nullptr;
+	std::size_t spans_begin = 0;
+	// spans of parsed values in the text
+	RawText* raw_text = nullptr;
+	// a path of the value which is being parsed, it is tracked only for the string sink
+	std::string path;
+	std::vector<std::string> string_paths;
+	std::string chunk;
+	// shapes of objects which have been met so far
+	std::vector<Shape> shapes;
+};
+
+Value parse(const char* text, std::size_t size);
+Value parse(const std::string&);
+Value parse(std::istream&);
+
+} /* namespace json */
+} /* namespace az */
+
+#ifdef AZ_JSON_CONSTEXPR_LITERALS
+// literals are checked and converted during the compilation (requires C++20)
+#include "Literal.h"
+#else
+inline az::json::Value operator""_json(const char* text, std::size_t size)
+{
+	return az::json::parse(text, size);
+}
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MappedFile.h"
+
+namespace az {
+namespace json {
+
+// an index of byte offsets of records (non-empty lines) of NDJSON text
+class RecordIndex
+{
+public:
+	static const uint32_t version = 1;
+
+	struct Options {
+		// keep an offset of every N-th record only
+		uint32_t sampling = 1;
+		// a number of threads to build the index (0 means a number of CPU cores)
+		unsigned threads = 0;
+		Options() {}
+	};
+
+	RecordIndex() = default;
+
+	static RecordIndex build(const char* text, std::size_t size, const Options& options = {});
+	static RecordIndex build(const MappedFile&, const Options& options = {});
+
+	// saves the index into a file which is bound to the indexed file by its size and modification time
+	void save(const std::string& path) const;
+	// loads the index from a file and checks that it is still valid for the indexed file
+	static RecordIndex load(const std::string& path, const MappedFile&);
+
+	uint64_t getRecords() const;
+	uint32_t getSampling() const;
+
+	// returns a byte offset of the record in the indexed text
+	std::size_t locate(const char* text, std::size_t size, uint64_t record) const;
+
+private:
+	static std::size_t skipRecord(const char* text, std::size_t size, std::size_t offset);
+
+private:
+	uint64_t file_size = 0;
+	int64_t file_time = 0;
+	uint32_t sampling = 1;
+	uint64_t records = 0;
+	std::vector<uint64_t> offsets;
+};
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace az {
+namespace json {
+
+// spans of arrays and objects of a parsed text which let the Reader re-parse only edited containers
+class SourceMap
+{
+public:
+	// replaces the removed bytes at the offset with the inserted text
+	struct Edit {
+		std::size_t offset = 0;
+		std::size_t removed = 0;
+		std::string inserted;
+		Edit() {}
+		Edit(std::size_t offset, std::size_t removed, const std::string& inserted)
+			: offset(offset), removed(removed), inserted(inserted) {}
+	};
+
+	struct Span {
+		// an offset from the beginning of the parent container
+		std::size_t begin = 0;
+		std::size_t size = 0;
+		// a key of the container in its object or an index in its array
+		std::string key;
+		uint32_t index = 0;
+		// false if the container is replaced by a later member of its object with the same key
+		bool live = true;
+		std::vector<Span> children;
+	};
+
+	bool empty() const {
+		return root.children.empty();
+	}
+	void clear() {
+		root = Span();
+	}
+
+private:
+	friend class Reader;
+	// a span of the whole text which contains the root container
+	Span root;
+};
+
+} /* namespace json */
+} /* namespace az */
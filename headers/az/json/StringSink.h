@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include "Value.h"
+
+namespace az {
+namespace json {
+
+// receives long strings chunk by chunk, so they are never kept in memory as a whole
+class StringSink
+{
+public:
+	virtual ~StringSink() = default;
+
+	// starts a string which is a value at the path (for example ".data[2].blob")
+	virtual void open(const std::string& path) = 0;
+	// receives the next unescaped chunk of the string
+	virtual void write(const char* data, std::size_t size) = 0;
+	// finishes the string and returns a value which is kept in the tree instead of it
+	virtual Value close() = 0;
+	// is called instead of close if the text is broken in the middle of the string, must not throw
+	virtual void abort() {}
+};
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,236 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Value.h"
+
+namespace az {
+namespace json {
+
+// a read-only tree which is kept in two contiguous buffers instead of nodes on the heap:
+// a tape of 64-bit entries in the order of the text and a buffer of unescaped strings
+class Tape
+{
+public:
+	class Iterator;
+
+	// a reference to a value on the tape which offers the read API of Value,
+	// it is valid while the tape is neither parsed again nor cleared
+	class View
+	{
+	public:
+		View() = default;
+
+		// false if the view refers to no value, for example to a missing member
+		explicit operator bool() const {
+			return entry != nullptr;
+		}
+		Value::Type getType() const {
+			return entry ? Value::Type(*entry >> type_shift) : Value::Type::Null;
+		}
+		const char* getTypeString() const;
+		bool empty() const;
+		uint32_t size() const;
+
+		bool isNull() const {
+			return getType() == Value::Type::Null;
+		}
+		bool isBool() const {
+			return getType() == Value::Type::Bool;
+		}
+		bool isInteger() const {
+			return getType() == Value::Type::Integer;
+		}
+		bool isReal() const {
+			return getType() == Value::Type::Real;
+		}
+		bool isString() const {
+			return getType() == Value::Type::String;
+		}
+		bool isArray() const {
+			return getType() == Value::Type::Array;
+		}
+		bool isObject() const {
+			return getType() == Value::Type::Object;
+		}
+		bool isNegative() const;
+
+		bool asBool() const;
+		int64_t asInteger() const;
+		double asReal() const;
+		std::string asString() const;
+		// bytes of a string on the tape which are followed by a zero, nullptr for other values
+		const char* getStringData() const;
+		std::size_t getStringSize() const;
+
+		// members are found by scanning the object, which keeps a repeated key once with its last value as Value does,
+		// elements are found by positions of every few of them and skipping the rest
+		View find(const char* key, std::size_t size) const;
+		View find(const char* key) const;
+		View find(const std::string& key) const;
+		View find(Value::Index) const;
+		View find(int) const;
+
+		View operator[](const char* key) const {
+			return find(key);
+		}
+		View operator[](const std::string& key) const {
+			return find(key);
+		}
+		View operator[](Value::Index index) const {
+			return find(index);
+		}
+		View operator[](int index) const {
+			return find(index);
+		}
+
+		bool has(const char*) const;
+		bool has(const std::string&) const;
+		bool has(Value::Index) const;
+		bool has(int) const;
+
+		// copies the value into a tree which may be modified or written
+		Value toValue() const;
+
+		// members are iterated in the order of the text
+		Iterator begin() const;
+		Iterator end() const;
+
+	private:
+		friend class Tape;
+		friend class Iterator;
+		View(const uint64_t* entry, const char* strings)
+			: entry(entry), strings(strings) {}
+		uint64_t getPayload() const {
+			return *entry & payload_mask;
+		}
+
+		const uint64_t* entry = nullptr;
+		const char* strings = nullptr;
+	};
+
+	class Iterator
+	{
+	public:
+		using value_type = View;
+		using pointer = void;
+		using reference = View;
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+
+		Iterator() = default;
+		bool isArray() const {
+			return entry && !object;
+		}
+		bool isObject() const {
+			return entry && object;
+		}
+		View value() const {
+			return View(object ? entry + 2 : entry, strings);
+		}
+		std::string key() const {
+			if (object) {
+				const View key(entry, strings);
+				return std::string(key.getStringData(), key.getStringSize());
+			}
+			return {};
+		}
+		Iterator& operator++() {
+			entry = object ? getNext(entry + 2) : getNext(entry);
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator iter = *this;
+			++(*this);
+			return iter;
+		}
+		bool operator==(const Iterator& other) const {
+			return entry == other.entry;
+		}
+		bool operator!=(const Iterator& other) const {
+			return !(*this == other);
+		}
+		View operator*() const {
+			return value();
+		}
+
+	private:
+		friend class View;
+		Iterator(const uint64_t* entry, const char* strings, bool object)
+			: entry(entry), strings(strings), object(object) {}
+
+		// a key of an object member is followed by its value
+		const uint64_t* entry = nullptr;
+		const char* strings = nullptr;
+		bool object = false;
+	};
+
+	bool empty() const {
+		return entries.empty();
+	}
+	void clear();
+	// a view of the root value, which refers to no value if the tape is empty
+	View getRoot() const;
+	// bytes which are taken by the entries and the strings
+	std::size_t getMemory() const;
+
+private:
+	friend class Reader;
+	// an entry keeps the type of its value in the highest byte and a payload in the rest:
+	// null and bool keep the value in the payload and take one entry,
+	// integer and real take one more entry with their bits,
+	// string keeps its offset in the buffer and takes one more entry with its size,
+	// array and object keep the number of entries which they take with their children
+	// and take one more entry with the number of their elements or members,
+	// array takes one more entry with the offset of the end of its elements,
+	// which are followed by offsets of every index_stride-th element if there are more of them,
+	// a member of an object is a string entry of its key followed by its value
+	static const int type_shift = 56;
+	static const uint64_t payload_mask = (uint64_t(1) << type_shift) - 1;
+	static const std::size_t array_header = 3;
+	static const std::size_t object_header = 2;
+	static const std::size_t index_stride = 16;
+
+	static uint64_t makeEntry(Value::Type type, uint64_t payload) {
+		return uint64_t(type) << type_shift | payload;
+	}
+	// an entry which follows the value, so siblings are skipped without going through their children
+	static const uint64_t* getNext(const uint64_t* entry) {
+		switch (Value::Type(*entry >> type_shift)) {
+			case Value::Type::Null:
+			case Value::Type::Bool:
+				return entry + 1;
+			case Value::Type::Array:
+			case Value::Type::Object:
+				return entry + (*entry & payload_mask);
+			default:
+				return entry + 2;
+		}
+	}
+
+	void addNull();
+	void addBool(bool);
+	void addInteger(int64_t);
+	void addReal(double);
+	// adds the string which has been appended to the buffer from the offset, returns its size
+	std::size_t addString(std::size_t offset);
+	std::size_t addString(const char* data, std::size_t size);
+	// adds a header of an array or an object whose children are added next
+	std::size_t openContainer(Value::Type);
+	// completes the header once all children are added
+	void closeContainer(std::size_t header);
+	// merges members of a repeated key into the first of them with the value of the last one, returns the number of members
+	uint64_t mergeMembers(std::size_t header);
+	bool isSameKey(std::size_t left, std::size_t right) const;
+
+	std::vector<uint64_t> entries;
+	std::string strings;
+	// positions of members of the object which is closed, kept to reuse their memory
+	std::vector<std::size_t> members;
+	std::vector<std::size_t> order;
+	std::vector<uint64_t> merged;
+};
+
+} /* namespace json */
+} /* namespace az */
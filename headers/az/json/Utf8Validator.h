@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace az {
+namespace json {
+
+class Utf8Validator
+{
+public:
+	static const std::size_t npos = std::size_t(-1);
+
+	// returns an offset of the first malformed sequence of a whole text or npos if it is well-formed
+	static std::size_t validate(const char* text, std::size_t size);
+
+	// checks the next piece of a text; a sequence may be split between pieces
+	bool feed(const char* text, std::size_t size);
+	// checks that the text has not been finished in the middle of a sequence
+	bool finish();
+
+	bool isMalformed() const;
+	// returns an offset of the first malformed sequence from the beginning of the whole text
+	std::size_t getOffset() const;
+
+private:
+	static int getSequenceLength(const uint8_t* sequence, std::size_t available);
+	static std::size_t validateScalar(const uint8_t* text, std::size_t size, std::size_t& incomplete);
+	static std::size_t validateBlocks(const uint8_t* text, std::size_t size, std::size_t& incomplete);
+
+private:
+	std::size_t offset = 0;
+	std::size_t malformed = npos;
+	uint8_t pending[4] = {};
+	uint8_t pending_size = 0;
+};
+
+} /* namespace json */
+} /* namespace az */
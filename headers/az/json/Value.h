@@ -1,240 +1,542 @@
-#pragma once
-#include <map>
-#include <deque>
-#include <string>
-#include <initializer_list>
-#include <ostream>
-#include <iterator>
-
-namespace az { 
-namespace json {
-
-class Iterator;
-
-class Value final
-{
-public:
-	enum class Type : uint8_t {
-		Null,
-		Bool,
-		Real,
-		Integer,
-		String,
-		Array,
-		Object
-	};
-	using Index = uint32_t;
-	using String = std::string;
-	using Array = std::deque<Value>;
-	using Object = std::map<String,Value>;
-	static const Value null;
-
-	void reset(Type = Type::Null);
-
-	void assign(bool);
-	void assign(int);
-	void assign(int64_t);
-	void assign(uint64_t);
-	void assign(float);
-	void assign(double);
-	void assign(const char*);
-	void assign(std::string&&);
-	void assign(const std::string&);
-	void assign(const wchar_t*);
-	void assign(const std::wstring&);
-	void assign(const Array&);
-	void assign(const Object&);
-	void assign(Value&&) noexcept;
-	void assign(const Value&);
-
-	Value(Type type = Type::Null) {
-		reset(type);
-	}
-
-	Value(std::nullptr_t) {}
-	
-	template<class T>
-	Value(T&& value) {
-		assign(value);
-	}
-
-	Value(Value&& other) noexcept {
-		assign(other);
-	}
-
-	Value(const Value& other) {
-		assign(other);
-	}
-
-	Value(std::initializer_list<Value>);
-
-	template<class Iterator>
-	Value(Iterator begin, Iterator end) {
-		reset(Type::Array);
-		any.array_->assign(begin, end);
-	}
-
-	Value(void*) = delete;
-
-	~Value() {
-		reset();
-	}
-
-	Value& operator=(const Value&);
-	Value& operator=(Value&&) noexcept;
-
-	void swap(Value&);
-	bool empty() const;
-	uint32_t size() const;
-	Type getType() const;
-	static const char* getTypeString(Type);
-	const char* getTypeString() const;
-
-	bool isNull() const;
-	bool isBool() const;
-	bool isInteger() const;
-	bool isReal() const;
-	bool isString() const;
-	bool isArray() const;
-	bool isObject() const;
-	bool isNegative() const;
-
-	bool asBool() const;
-	int64_t asInteger() const;
-	double asReal() const;
-	std::string asString() const;
-	std::wstring asWideString() const;
-
-	Value& convert(Type);
-	Value convert(Type) const;
-
-	bool operator==(const Value&) const;
-	bool operator!=(const Value&) const;
-	bool operator<(const Value&) const;
-	bool operator>(const Value&) const;
-	bool operator<=(const Value&) const;
-	bool operator>=(const Value&) const;
-
-	Value& append(Value&&);
-	Value& append(const Value&);
-	void append(std::initializer_list<Value>);
-
-	Value& operator[](const char*);
-	Value& operator[](const std::string&);
-	Value& operator[](Index);
-	Value& operator[](int);
-
-	const Value& operator[](const char*) const;
-	const Value& operator[](const std::string&) const;
-	const Value& operator[](Index) const;
-	const Value& operator[](int) const;
-
-	Value get(const std::string& key, const Value& default_value = Value::null) const;
-	Value get(Index, const Value& default_value = Value::null) const;
-
-	bool has(const std::string&) const;
-	bool has(Index) const;
-
-	std::string stringify(bool pretty = true) const;
-
-	const Array& getArray() const;
-	const Object& getObject() const;
-
-	Iterator begin() const;
-	Iterator end() const;
-
-private:
-	Type type = Type::Null;
-
-	union {
-		bool bool_;
-		int64_t integer_;
-		double real_;
-		String* string_;
-		Array* array_;
-		Object* object_;
-	} any = {};
-};
-
-class Iterator {
-	Value::Type type = Value::Type::Null;
-	Value::Array::const_iterator arr_iter;
-	Value::Object::const_iterator obj_iter;
-public:
-	using value_type = Value;
-	using pointer = const Value*;
-	using reference = const Value&;
-	using iterator_category = std::random_access_iterator_tag;
-	using difference_type = std::ptrdiff_t;
-
-	Iterator() = default;
-	Iterator(const Iterator&) = default;
-	Iterator(Value::Array::const_iterator iter) {
-		type = Value::Type::Array;
-		arr_iter = iter;
-	}
-	Iterator(Value::Object::const_iterator iter) {
-		type = Value::Type::Object;
-		obj_iter = iter;
-	}
-	bool isArray() const {
-		return type == Value::Type::Array;
-	}
-	bool isObject() const {
-		return type == Value::Type::Object;
-	}
-	Iterator::reference value() const {
-		if (isArray()) {
-			return *arr_iter;
-		}
-		if (isObject()) {
-			return obj_iter->second;
-		}
-		return Value::null;
-	}
-	std::string key() const {
-		if (isObject()) {
-			return obj_iter->first;
-		}
-		return {};
-	}
-	Iterator& operator++() {
-		if (isArray()) {
-			arr_iter++;
-		} else if (isObject()) {
-			obj_iter++;
-		}
-		return *this;
-	}
-	Iterator operator++(int) {
-		Iterator iter = *this;
-		++(*this);
-		return iter;
-	}
-	bool operator==(const Iterator& other) const {
-		if (type != other.type) {
-			return false;
-		}
-		if (isArray()) {
-			return arr_iter == other.arr_iter;
-		} else if (isObject()) {
-			return obj_iter == other.obj_iter;
-		}
-		return true;
-	}
-	bool operator!=(const Iterator& other) const {
-		return !(*this == other);
-	}
-	Iterator::reference operator*() const {
-		return value();
-	}
-};
-
-} /* namespace json */
-} /* namespace az */
-
-namespace std
-{
-ostream& operator<<(ostream& stream, const az::json::Value::Type&);
-ostream& operator<<(ostream& stream, const az::json::Value&);
-}
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <initializer_list>
+#include <ostream>
+#include <iterator>
+#include <utility>
+#include <cstdint>
+#include <atomic>
+#include "MemoryResource.h"
+#ifdef AZ_JSON_STABLE_MEMBERS
+#include "NodeVector.h"
+#endif
+
+namespace az { 
+namespace json {
+
+class Iterator;
+class Object;
+class RawText;
+class Reader;
+
+class Value final
+{
+public:
+	enum class Type : uint8_t {
+		Null,
+		Bool,
+		Real,
+		Integer,
+		String,
+		Array,
+		Object
+	};
+	using Index = uint32_t;
+	using String = std::string;
+	// a string which takes its memory from the current resource, long strings and keys of values are kept in it
+	using Text = std::basic_string<char, std::char_traits<char>, Allocator<char>>;
+#ifdef AZ_JSON_STABLE_ARRAYS
+	// references to elements stay valid when the array grows
+	using Array = std::deque<Value, Allocator<Value>>;
+#else
+	using Array = std::vector<Value, Allocator<Value>>;
+#endif
+	using Object = json::Object;
+	static const Value null;
+	// strings up to this size are kept inside the value without allocations
+	static const std::size_t small_capacity = 13;
+
+	void reset(Type = Type::Null);
+
+	void assign(bool);
+	void assign(int);
+	void assign(int64_t);
+	void assign(uint64_t);
+	void assign(float);
+	void assign(double);
+	void assign(const char*);
+	// copies the string as the other overload does, since memory of std::string is not taken from a resource
+	void assign(std::string&&);
+	void assign(const std::string&);
+	void assign(const wchar_t*);
+	void assign(const std::wstring&);
+	void assign(const Array&);
+	void assign(const Object&);
+	void assign(Object&&);
+	void assign(Value&&) noexcept;
+	void assign(const Value&);
+
+	Value(Type type = Type::Null) {
+		reset(type);
+	}
+
+	Value(std::nullptr_t) {}
+	
+	template<class T>
+	Value(T&& value) {
+		assign(std::forward<T>(value));
+	}
+
+	Value(Value&& other) noexcept {
+		assign(std::move(other));
+	}
+
+	Value(const Value& other) {
+		assign(other);
+	}
+
+	Value(std::initializer_list<Value>);
+
+	template<class Iterator>
+	Value(Iterator begin, Iterator end) {
+		reset(Type::Array);
+		any.array_->data.assign(begin, end);
+	}
+
+	Value(void*) = delete;
+
+	~Value() {
+		reset();
+	}
+
+	Value& operator=(const Value&);
+	Value& operator=(Value&&) noexcept;
+
+	void swap(Value&);
+	bool empty() const;
+	uint32_t size() const;
+	Type getType() const;
+	static const char* getTypeString(Type);
+	const char* getTypeString() const;
+
+	bool isNull() const;
+	bool isBool() const;
+	bool isInteger() const;
+	bool isReal() const;
+	bool isString() const;
+	bool isArray() const;
+	bool isObject() const;
+	bool isNegative() const;
+
+	bool asBool() const;
+	int64_t asInteger() const;
+	double asReal() const;
+	std::string asString() const;
+	std::wstring asWideString() const;
+
+	Value& convert(Type);
+	Value convert(Type) const;
+
+	bool operator==(const Value&) const;
+	bool operator!=(const Value&) const;
+	bool operator<(const Value&) const;
+	bool operator>(const Value&) const;
+	bool operator<=(const Value&) const;
+	bool operator>=(const Value&) const;
+
+	Value& append(Value&&);
+	Value& append(const Value&);
+	void append(std::initializer_list<Value>);
+	// constructs a new element at the end of the array in place
+	template<class... Args>
+	Value& emplace(Args&&... args) {
+		if (!isArray()) {
+			reset(Type::Array);
+		}
+		auto& array = leakArray();
+		array.emplace_back(std::forward<Args>(args)...);
+		return array.back();
+	}
+	// elements are kept contiguously, so references to them are invalidated once the array outgrows its capacity
+	// an object is reserved for members instead, any other value becomes an array
+	void reserve(Index);
+	Index capacity() const;
+	void shrinkToFit();
+
+	Value& operator[](const char*);
+	Value& operator[](const std::string&);
+	Value& operator[](Index);
+	Value& operator[](int);
+
+	const Value& operator[](const char*) const;
+	const Value& operator[](const std::string&) const;
+	const Value& operator[](Index) const;
+	const Value& operator[](int) const;
+
+	Value get(const std::string& key, const Value& default_value = Value::null) const;
+	Value get(Index, const Value& default_value = Value::null) const;
+
+	// return the member or the element without copying it or the key, nullptr if there is no such one
+	const Value* find(const char* key, std::size_t size) const;
+	const Value* find(const char* key) const;
+	const Value* find(const std::string& key) const;
+	const Value* find(Index) const;
+	const Value* find(int) const;
+	// return a reference to the member or the element, the default value must outlive the reference
+	const Value& lookup(const char* key, std::size_t size, const Value& default_value = Value::null) const;
+	const Value& lookup(const std::string& key, const Value& default_value = Value::null) const;
+	const Value& lookup(Index, const Value& default_value = Value::null) const;
+
+	bool has(const char*) const;
+	bool has(const std::string&) const;
+	bool has(Index) const;
+	bool has(int) const;
+
+	std::string stringify(bool pretty = true) const;
+
+	const Array& getArray() const;
+	const Object& getObject() const;
+
+	// copies of a value share its strings, arrays and objects until one of them is modified,
+	// an array or an object which has handed out a reference to its element or member is copied instead of shared
+	// returns a copy which shares nothing with this value
+	Value clone() const;
+	// a resource which the storage of the value is taken from, nullptr if the value has no storage
+	MemoryResource* getResource() const;
+
+	Iterator begin() const;
+	Iterator end() const;
+
+private:
+	friend class RawText;
+	friend class Reader;
+	friend class Document;
+	friend class Writer;
+	static const uint8_t long_string = UINT8_MAX;
+
+	const char* getStringData() const;
+	std::size_t getStringSize() const;
+	void assignString(const char* data, std::size_t size);
+	// keeps digits of a number as they are written in a text, they are decoded on every access
+	// without modifying the value, so a const value is read by several threads at once
+	void assignDigits(Type, const char* data, std::size_t size);
+	// returns false if the value is not a number which is kept as digits
+	bool getDigits(const char*& data, std::size_t& size) const;
+	int64_t getInteger() const;
+	double getReal() const;
+	// copies members to an object keeping its resource, the values are cloned if deep
+	static void copyMembers(const Object& from, Object& to, bool deep);
+
+	// a header of storage which is shared by copies of a value and released by the last of them to its resource
+	struct Storage {
+		std::atomic<std::size_t> owners;
+		MemoryResource* resource;
+		// an index of the span of the storage in a parsed text starting from one, which is reset once the data is modified
+		Index span = 0;
+		// true once a reference into the data has escaped, so the data is never shared again
+		bool leaked = false;
+
+		explicit Storage(MemoryResource* resource)
+			: owners(1), resource(resource) {}
+	};
+	template<class Data>
+	struct Shared : Storage {
+		Data data;
+
+		template<class... Args>
+		explicit Shared(MemoryResource* resource, Args&&... args)
+			: Storage(resource), data(std::forward<Args>(args)...) {}
+	};
+	// the storage of a long string, an array or an object, nullptr for other values
+	Storage* getStorage() const;
+	// takes one more owner of the storage of the value
+	void retain();
+	// copies the array or the object of the value if it is shared with other values
+	void unshare();
+	Array& ownArray() {
+		if (any.array_->owners.load(std::memory_order_acquire) != 1) {
+			unshare();
+		}
+		any.array_->span = 0;
+		return any.array_->data;
+	}
+	Object& ownObject();
+	// own the storage which is modified through references returned to the caller
+	Array& leakArray() {
+		auto& array = ownArray();
+		any.array_->leaked = true;
+		return array;
+	}
+	Object& leakObject();
+	bool isLeaked() const;
+	// constructs a new element whose reference does not escape, so the array is still shared by copies
+	Value& addElement() {
+		auto& array = ownArray();
+		array.emplace_back();
+		return array.back();
+	}
+	// leaves the storage of the value to its resource which releases it at once
+	void abandon() {
+		type = Type::Null;
+		small_size = 0;
+		any = {};
+	}
+	// a string or digits which are kept inside the value with a zero after them,
+	// they take the payload and the bytes which follow it, so the value takes 16 bytes
+	char* getSmall() {
+		return reinterpret_cast<char*>(this);
+	}
+	const char* getSmall() const {
+		return reinterpret_cast<const char*>(this);
+	}
+	// copies the payload and the rest of a string which is kept inside the value
+	void copySmall(const Value& other);
+
+	union {
+		bool bool_;
+		int64_t integer_;
+		double real_;
+		Shared<Text>* string_;
+		Shared<Array>* array_;
+		Shared<Object>* object_;
+	} any = {};
+	char small_rest_[small_capacity + 1 - sizeof(any)] = {};
+	// a size of the string which is kept inside the value or long_string if it is allocated,
+	// or a size of the digits of a number which has not been decoded
+	uint8_t small_size = 0;
+	Type type = Type::Null;
+};
+
+// members of an object which are kept contiguously in the order of their keys or of their insertion
+class Object final
+{
+public:
+	enum class Order : uint8_t {
+		// by bytes of the keys as std::map does
+		Sorted,
+		// in the order in which the keys have been inserted first
+		Insertion
+	};
+	enum class Lookup : uint8_t {
+		// small objects are scanned, larger ones are searched by halves if sorted or by hashes of their keys
+		Automatic,
+		// members are always found by hashes of their keys
+		Hashed
+	};
+	// a key which is taken from the resource of its object as well,
+	// it converts to std::string and compares with it, so keys are used where std::string is expected
+	class Key : public Value::Text
+	{
+	public:
+		using Value::Text::basic_string;
+
+		operator std::string() const {
+			return std::string(data(), size());
+		}
+		friend bool operator==(const Key& key, const Key& other) {
+			return key.compare(other) == 0;
+		}
+		friend bool operator!=(const Key& key, const Key& other) {
+			return !(key == other);
+		}
+		friend bool operator==(const Key& key, const std::string& other) {
+			return key.compare(0, key.size(), other.data(), other.size()) == 0;
+		}
+		friend bool operator==(const std::string& other, const Key& key) {
+			return key == other;
+		}
+		friend bool operator!=(const Key& key, const std::string& other) {
+			return !(key == other);
+		}
+		friend bool operator!=(const std::string& other, const Key& key) {
+			return !(key == other);
+		}
+	};
+	using key_type = Key;
+	using mapped_type = Value;
+	using value_type = std::pair<key_type, Value>;
+#ifdef AZ_JSON_STABLE_MEMBERS
+	// references to members stay valid when other members are inserted or the members are sorted
+	using Members = NodeVector<value_type>;
+#else
+	using Members = std::vector<value_type, Allocator<value_type>>;
+#endif
+	using const_iterator = Members::const_iterator;
+	// objects up to this size are searched by the first bytes of their keys, larger ones by an index
+	static const std::size_t flat_size = 16;
+	// sorted objects above this size are indexed by hashes of their keys as well
+	static const std::size_t hashed_size = 256;
+
+	explicit Object(Order order = Order::Sorted, Lookup lookup = Lookup::Automatic)
+		: order(order), lookup(lookup) {}
+	Object(const Object&);
+	Object(Object&&) noexcept;
+	Object& operator=(const Object&);
+	Object& operator=(Object&&);
+
+	Order getOrder() const {
+		return order;
+	}
+	Lookup getLookup() const {
+		return lookup;
+	}
+	bool empty() const {
+		return members.empty();
+	}
+	std::size_t size() const {
+		return members.size();
+	}
+	const_iterator begin() const {
+		sort();
+		return members.begin();
+	}
+	const_iterator end() const {
+		sort();
+		return members.end();
+	}
+
+	const_iterator find(const std::string&) const;
+	const_iterator find(const char* key, std::size_t size) const;
+	std::size_t count(const std::string&) const;
+	// throws std::out_of_range if there is no such key
+	const Value& at(const std::string&) const;
+	// inserts a null value if there is no such key, a large sorted object appends the member
+	// and sorts its members once they are read in order, which moves the members as inserting does
+	Value& operator[](const std::string&);
+	Value& operator[](std::string&&);
+	// inserts the member if there is no such key yet
+	bool emplace(std::string key, Value value);
+	void clear();
+	// allocates the members and their index at once, so inserting up to this size never rehashes
+	void reserve(std::size_t);
+	std::size_t capacity() const {
+		return members.capacity();
+	}
+
+	// objects are equal if they have the same members regardless of their order
+	bool operator==(const Object&) const;
+	bool operator!=(const Object&) const;
+	// compares members in the order of their keys regardless of the order of the objects
+	bool operator<(const Object&) const;
+
+private:
+	friend class Value;
+	friend class Reader;
+	static const std::size_t npos = std::size_t(-1);
+	// a position of a member plus one with the hash of its key, so the index grows without hashing keys again
+	struct Slot {
+		uint32_t position;
+		uint32_t hash;
+	};
+
+	bool isIndexed(std::size_t size) const;
+	std::size_t locate(const char* key, std::size_t size) const;
+	std::size_t scan(const char* key, std::size_t size) const;
+	// a position of the first key which is not less than the given one in a sorted object
+	std::size_t lowerBound(const char* key, std::size_t size) const;
+	std::size_t probe(const char* key, std::size_t size, uint32_t hash) const;
+	Value& insert(const char* key, std::size_t size);
+	void indexHeads();
+	// hashes all keys into an index which fits the given number of members
+	void indexMembers(std::size_t size);
+	void growIndex(std::size_t size);
+	void place(Slot slot);
+	// appends a member without looking for its key, the object is settled once all members are appended
+	Value& append(const std::string& key);
+	// sorts the appended members if needed and keeps the last value of every duplicate key
+	void settle();
+	// sorts members which have been inserted out of order before they are read in order,
+	// a const object may be read by several threads, so the first of them sorts it and the others wait
+	void sort() const {
+		if (unsorted.load(std::memory_order_acquire)) {
+			sortMembers();
+		}
+	}
+	void sortMembers() const;
+
+private:
+	Members members;
+	// first bytes of the keys of a small object
+	uint8_t heads[flat_size] = {};
+	// members of a large object by hashes of their keys, a zero position is an empty slot
+	std::vector<Slot, Allocator<Slot>> index;
+	Order order;
+	Lookup lookup;
+	// true if a sorted object has appended members out of the order of their keys
+	mutable std::atomic<bool> unsorted{false};
+};
+
+class Iterator {
+	Value::Type type = Value::Type::Null;
+	Value::Array::const_iterator arr_iter;
+	Value::Object::const_iterator obj_iter;
+public:
+	using value_type = Value;
+	using pointer = const Value*;
+	using reference = const Value&;
+	using iterator_category = std::random_access_iterator_tag;
+	using difference_type = std::ptrdiff_t;
+
+	Iterator() = default;
+	Iterator(const Iterator&) = default;
+	Iterator(Value::Array::const_iterator iter) {
+		type = Value::Type::Array;
+		arr_iter = iter;
+	}
+	Iterator(Value::Object::const_iterator iter) {
+		type = Value::Type::Object;
+		obj_iter = iter;
+	}
+	bool isArray() const {
+		return type == Value::Type::Array;
+	}
+	bool isObject() const {
+		return type == Value::Type::Object;
+	}
+	Iterator::reference value() const {
+		if (isArray()) {
+			return *arr_iter;
+		}
+		if (isObject()) {
+			return obj_iter->second;
+		}
+		return Value::null;
+	}
+	std::string key() const {
+		if (isObject()) {
+			return std::string(obj_iter->first.data(), obj_iter->first.size());
+		}
+		return {};
+	}
+	Iterator& operator++() {
+		if (isArray()) {
+			arr_iter++;
+		} else if (isObject()) {
+			obj_iter++;
+		}
+		return *this;
+	}
+	Iterator operator++(int) {
+		Iterator iter = *this;
+		++(*this);
+		return iter;
+	}
+	bool operator==(const Iterator& other) const {
+		if (type != other.type) {
+			return false;
+		}
+		if (isArray()) {
+			return arr_iter == other.arr_iter;
+		} else if (isObject()) {
+			return obj_iter == other.obj_iter;
+		}
+		return true;
+	}
+	bool operator!=(const Iterator& other) const {
+		return !(*this == other);
+	}
+	Iterator::reference operator*() const {
+		return value();
+	}
+};
+
+} /* namespace json */
+} /* namespace az */
+
+namespace std
+{
+ostream& operator<<(ostream& stream, const az::json::Value::Type&);
+ostream& operator<<(ostream& stream, const az::json::Value&);
+}
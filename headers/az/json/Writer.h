@@ -1,49 +1,62 @@
-#pragma once
-#include <iostream>
-#include "Value.h"
-
-namespace az {
-namespace json {
-
-class Writer
-{
-public:
-	struct Options {
-		bool pretty = false;
-		bool quoting = true;
-		char indent_char = ' ';
-		uint32_t indent_size = 3;
-		uint32_t left_margin = 0;
-		std::string new_line = "\n";
-		Options() {}
-	};
-	Writer(std::ostream& stream, const Options& options = {})
-		: stream(stream), options(options) {}
-
-	Writer& pretty(bool = true);
-	Writer& withIndentChar(char);
-	Writer& withIndentSize(uint32_t);
-	Writer& withLeftMargin(uint32_t);
-	Writer& withNewLine(const std::string&);
-	Writer& withoutQuoting(bool = true);
-
-	void write(const Value&);
-	void escape(const char*);
-	void escape(const std::string&);
-	void escape(const char* begin, const char* end);
-	static int convertUnicode(const char* begin, const char* end, uint32_t& unicode);
-	static bool isIdentifier(const std::string&);
-
-private:
-	void writeNewLine();
-	void writeIndentation(int level);
-	void writeIdentifier(const std::string&);
-	void writeValue(const Value&, int level);
-
-private:
-	std::ostream& stream;
-	Options options;
-};
-
-} /* namespace json */
-} /* namespace az */
+#pragma once
+#include <iostream>
+#include "Value.h"
+#include "Cancellation.h"
+#include "RawText.h"
+
+namespace az {
+namespace json {
+
+class Writer
+{
+public:
+	struct Options {
+		bool pretty = false;
+		bool quoting = true;
+		char indent_char = ' ';
+		uint32_t indent_size = 3;
+		uint32_t left_margin = 0;
+		std::string new_line = "\n";
+		// stops the writing with an error once it is cancelled
+		const Cancellation* cancellation = nullptr;
+		// copies values which have not been modified since parsing from the text as they are written there,
+		// only if they are plain JSON and the values are written neither pretty nor without quoting
+		const RawText* raw_text = nullptr;
+		Options() {}
+	};
+	Writer(std::ostream& stream, const Options& options = {})
+		: stream(stream), options(options) {}
+
+	Writer& pretty(bool = true);
+	Writer& withIndentChar(char);
+	Writer& withIndentSize(uint32_t);
+	Writer& withLeftMargin(uint32_t);
+	Writer& withNewLine(const std::string&);
+	Writer& withoutQuoting(bool = true);
+	Writer& withCancellation(const Cancellation&);
+	Writer& withRawText(const RawText&);
+
+	void write(const Value&);
+	void escape(const char*);
+	void escape(const std::string&);
+	void escape(const char* begin, const char* end);
+	static int convertUnicode(const char* begin, const char* end, uint32_t& unicode);
+	static bool isIdentifier(const std::string&);
+	static bool isIdentifier(const char* begin, const char* end);
+
+private:
+	void writeNewLine();
+	void writeIndentation(int level);
+	void writeIdentifier(const Value::Object::key_type&);
+	void writeValue(const Value&, int level);
+	void checkCancellation();
+
+private:
+	std::ostream& stream;
+	Options options;
+	// values which are left to write before the next check of the cancellation
+	uint32_t countdown = 0;
+};
+
+} /* namespace json */
+} /* namespace az */
@@ -16,3 +16,13 @@ $(call import_modules,Cpp)
 # Default compiler options
 $(call set_cxx_standard,c++11)
 $(call add_compile_options,-Wall)
+
+# Optional compression libraries
+ifneq ($(wildcard /usr/include/zlib.h),)
+$(call add_compile_options,-DAZ_JSON_WITH_ZLIB)
+COMPRESSION_LIBRARIES+=z
+endif
+ifneq ($(wildcard /usr/include/zstd.h),)
+$(call add_compile_options,-DAZ_JSON_WITH_ZSTD)
+COMPRESSION_LIBRARIES+=zstd
+endif
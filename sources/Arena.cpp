@@ -0,0 +1,138 @@
+#include <az/json/Arena.h>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace az {
+namespace json {
+namespace {
+
+const std::size_t huge_page_size = 2 << 20;
+// chunks start with their headers, so the memory after a header keeps the maximum alignment
+const std::size_t header_size = (sizeof(void*) * 3 + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+char* alignUp(char* pointer, std::size_t alignment)
+{
+	const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+	return pointer + ((alignment - address % alignment) % alignment);
+}
+
+// returns nullptr if the system has no huge pages to give
+void* mapHugePages(std::size_t size)
+{
+#if defined(__linux__)
+#ifdef MAP_HUGETLB
+	void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (memory != MAP_FAILED) {
+		return memory;
+	}
+#endif
+	// transparent huge pages are asked for if no pages are reserved
+	memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return nullptr;
+	}
+#ifdef MADV_HUGEPAGE
+	::madvise(memory, size, MADV_HUGEPAGE);
+#endif
+	return memory;
+#else
+	(void)size;
+	return nullptr;
+#endif
+}
+
+void unmapHugePages(void* memory, std::size_t size)
+{
+#if defined(__linux__)
+	::munmap(memory, size);
+#else
+	(void)memory;
+	(void)size;
+#endif
+}
+
+} /* namespace */
+
+Arena::Arena(const Options& options /*= {}*/)
+	: options(options), next_size(std::max<std::size_t>(options.chunk_size, 4096))
+{
+}
+
+Arena::~Arena()
+{
+	release();
+}
+
+void Arena::release()
+{
+	while (chunks) {
+		const auto chunk = chunks;
+		chunks = chunk->next;
+		if (chunk->mapped) {
+			unmapHugePages(chunk, chunk->size);
+		}
+		else {
+			::operator delete(chunk);
+		}
+	}
+	cursor = nullptr;
+	limit = nullptr;
+	next_size = std::max<std::size_t>(options.chunk_size, 4096);
+	reserved = 0;
+	used = 0;
+}
+
+std::size_t Arena::getReserved() const
+{
+	return reserved;
+}
+
+std::size_t Arena::getUsed() const
+{
+	return used;
+}
+
+void* Arena::doAllocate(std::size_t size, std::size_t alignment)
+{
+	auto begin = cursor ? alignUp(cursor, alignment) : nullptr;
+	if (!begin || size > std::size_t(limit - begin)) {
+		addChunk(size + alignment);
+		begin = alignUp(cursor, alignment);
+	}
+	cursor = begin + size;
+	used += size;
+	return begin;
+}
+
+void Arena::addChunk(std::size_t size)
+{
+	static_assert(sizeof(Chunk) <= header_size, "a header of a chunk overlaps its memory");
+	size = std::max(next_size, header_size + size);
+	next_size = std::min(next_size * 2, std::max(options.max_chunk_size, next_size));
+	void* memory = nullptr;
+	bool mapped = false;
+	if (options.huge_pages) {
+		size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+		memory = mapHugePages(size);
+		mapped = memory != nullptr;
+	}
+	if (!memory) {
+		memory = ::operator new(size);
+	}
+	const auto chunk = static_cast<Chunk*>(memory);
+	chunk->next = chunks;
+	chunk->size = size;
+	chunk->mapped = mapped;
+	chunks = chunk;
+	cursor = static_cast<char*>(memory) + header_size;
+	limit = static_cast<char*>(memory) + size;
+	reserved += size;
+}
+
+} /* namespace json */
+} /* namespace az */
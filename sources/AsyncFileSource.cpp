@@ -0,0 +1,421 @@
+#include <az/json/AsyncFileSource.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace az {
+namespace json {
+
+#ifdef __linux__
+
+namespace {
+
+// io_uring is used through the raw system calls to avoid a dependency on liburing
+int setupRing(unsigned entries, io_uring_params& params)
+{
+	return int(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int enterRing(int ring, unsigned submit, unsigned complete, unsigned flags)
+{
+	return int(::syscall(__NR_io_uring_enter, ring, submit, complete, flags, nullptr, 0));
+}
+
+bool isReadSupported(int ring)
+{
+	const unsigned count = IORING_OP_READ + 1;
+	std::vector<char> memory(sizeof(io_uring_probe) + count * sizeof(io_uring_probe_op));
+	auto probe = reinterpret_cast<io_uring_probe*>(memory.data());
+	if (::syscall(__NR_io_uring_register, ring, IORING_REGISTER_PROBE, probe, count) < 0) {
+		return false;
+	}
+	return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+} /* namespace */
+
+struct IoRing::Queue
+{
+	int ring = -1;
+	void* sq_memory = MAP_FAILED;
+	std::size_t sq_memory_size = 0;
+	void* cq_memory = MAP_FAILED;
+	std::size_t cq_memory_size = 0;
+	io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	std::size_t sqes_size = 0;
+
+	unsigned* sq_head = nullptr;
+	unsigned* sq_tail = nullptr;
+	unsigned* sq_array = nullptr;
+	unsigned sq_mask = 0;
+	unsigned sq_entries = 0;
+	unsigned* cq_head = nullptr;
+	unsigned* cq_tail = nullptr;
+	io_uring_cqe* cqes = nullptr;
+	unsigned cq_mask = 0;
+	unsigned cq_entries = 0;
+
+	explicit Queue(unsigned entries);
+	~Queue();
+	void close();
+	bool isAvailable() const { return ring >= 0; }
+};
+
+IoRing::Queue::Queue(unsigned entries)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ring = setupRing(entries, params);
+	if (ring < 0) {
+		return; // not supported by the kernel or forbidden
+	}
+	sq_memory_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_memory_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		sq_memory_size = cq_memory_size = std::max(sq_memory_size, cq_memory_size);
+	}
+	sq_memory = ::mmap(nullptr, sq_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cq_memory = sq_memory;
+	}
+	else if (sq_memory != MAP_FAILED) {
+		cq_memory = ::mmap(nullptr, cq_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+	}
+	sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	if (cq_memory != MAP_FAILED) {
+		sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES));
+	}
+	if (sqes == MAP_FAILED || !isReadSupported(ring)) {
+		close();
+		return;
+	}
+
+	auto sq = static_cast<char*>(sq_memory);
+	sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	sq_entries = params.sq_entries;
+	auto cq = static_cast<char*>(cq_memory);
+	cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	cq_entries = params.cq_entries;
+}
+
+IoRing::Queue::~Queue()
+{
+	close();
+}
+
+void IoRing::Queue::close()
+{
+	if (sqes != MAP_FAILED) {
+		::munmap(sqes, sqes_size);
+	}
+	if (cq_memory != MAP_FAILED && cq_memory != sq_memory) {
+		::munmap(cq_memory, cq_memory_size);
+	}
+	if (sq_memory != MAP_FAILED) {
+		::munmap(sq_memory, sq_memory_size);
+	}
+	if (ring >= 0) {
+		::close(ring);
+	}
+	ring = -1;
+	sq_memory = cq_memory = MAP_FAILED;
+	sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+}
+
+IoRing::IoRing(unsigned entries /*= 256*/)
+{
+	if (entries > 0) {
+		queue.reset(new Queue(entries));
+	}
+}
+
+IoRing::~IoRing()
+{
+}
+
+bool IoRing::isAvailable() const
+{
+	return queue && queue->isAvailable();
+}
+
+void IoRing::flush()
+{
+	while (pending > 0) {
+		int result = enterRing(queue->ring, pending, 0, 0);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw Error("unable to submit file reads");
+		}
+		pending -= std::min(pending, unsigned(result));
+	}
+}
+
+void IoRing::reap()
+{
+	unsigned head = *queue->cq_head;
+	unsigned tail = __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != tail; head++) {
+		const auto& completion = queue->cqes[head & queue->cq_mask];
+		auto request = reinterpret_cast<Request*>(completion.user_data);
+		request->result = completion.res;
+		request->done = true;
+		inflight--;
+	}
+	__atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+}
+
+template<class Predicate>
+void IoRing::waitUntil(std::unique_lock<std::mutex>& lock, Predicate predicate)
+{
+	while (!predicate()) {
+		if (reaping) {
+			condition.wait(lock);
+			continue;
+		}
+		// this thread submits all the queued reads and waits in the kernel on behalf of the others
+		reaping = true;
+		auto count = pending;
+		pending = 0;
+		lock.unlock();
+		int result = enterRing(queue->ring, count, 1, IORING_ENTER_GETEVENTS);
+		int error = errno;
+		lock.lock();
+		reaping = false;
+		pending += count - std::min(count, unsigned(std::max(result, 0)));
+		reap();
+		condition.notify_all();
+		if (result < 0 && error != EINTR && error != EAGAIN && error != EBUSY) {
+			throw Error("unable to wait for file reads");
+		}
+	}
+}
+
+void IoRing::read(Request& request, int file, char* buffer, uint32_t size, uint64_t offset)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	// the number of reads in flight must not exceed the completion queue
+	waitUntil(lock, [&] {
+		return inflight < queue->cq_entries;
+	});
+	unsigned tail = *queue->sq_tail;
+	if (tail - __atomic_load_n(queue->sq_head, __ATOMIC_ACQUIRE) >= queue->sq_entries) {
+		flush();
+	}
+	unsigned index = tail & queue->sq_mask;
+	auto& entry = queue->sqes[index];
+	memset(&entry, 0, sizeof(entry));
+	entry.opcode = IORING_OP_READ;
+	entry.fd = file;
+	entry.addr = reinterpret_cast<uint64_t>(buffer);
+	entry.len = size;
+	entry.off = offset;
+	entry.user_data = reinterpret_cast<uint64_t>(&request);
+	queue->sq_array[index] = index;
+	__atomic_store_n(queue->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	request.done = false;
+	pending++;
+	inflight++;
+	if (reaping) {
+		flush(); // the reaping thread has already entered the kernel, so it will not submit this read
+	}
+}
+
+void IoRing::wait(Request& request)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	waitUntil(lock, [&] {
+		return request.done;
+	});
+}
+
+AsyncFileSource::AsyncFileSource(IoRing& ring, const std::string& path, const Options& options /*= {}*/)
+	: ring(ring), path(path)
+{
+	auto blocks = std::max<uint32_t>(options.blocks, 1);
+	auto block_size = std::max<uint32_t>(options.block_size, 1);
+	if (!ring.isAvailable()) {
+		ReadAheadSource::Options fallback_options;
+		fallback_options.blocks = blocks;
+		fallback_options.block_size = block_size;
+		fallback_file.reset(new FileSource(path));
+		fallback.reset(new ReadAheadSource(*fallback_file, fallback_options));
+		return;
+	}
+
+	file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0) {
+		throw Error("unable to open file " + path);
+	}
+	struct stat status;
+	if (::fstat(file, &status) != 0) {
+		::close(file);
+		throw Error("unable to get status of file " + path);
+	}
+	file_size = uint64_t(status.st_size);
+	buffers.assign(blocks, std::vector<char>(block_size));
+	requests.resize(blocks);
+	offsets.resize(blocks);
+	sizes.resize(blocks);
+	try {
+		// the first reads of all the blocks are submitted at once
+		for (std::size_t block = 0; block < blocks; block++) {
+			requestBlock(block);
+		}
+	}
+	catch (...) {
+		release();
+		throw;
+	}
+}
+
+AsyncFileSource::~AsyncFileSource()
+{
+	release();
+}
+
+void AsyncFileSource::release()
+{
+	for (std::size_t block = 0; block < sizes.size(); block++) {
+		if (sizes[block] > 0) {
+			ring.wait(requests[block]);
+			sizes[block] = 0;
+		}
+	}
+	if (file >= 0) {
+		::close(file);
+		file = -1;
+	}
+}
+
+void AsyncFileSource::requestBlock(std::size_t block)
+{
+	sizes[block] = 0;
+	if (requested >= file_size) {
+		return;
+	}
+	auto size = uint32_t(std::min<uint64_t>(buffers[block].size(), file_size - requested));
+	ring.read(requests[block], file, buffers[block].data(), size, requested);
+	sizes[block] = size;
+	offsets[block] = requested;
+	requested += size;
+}
+
+void AsyncFileSource::acquireBlock()
+{
+	if (started) {
+		// the consumed block is refilled while the parser goes on with the next one
+		requestBlock(slot);
+		slot = (slot + 1) % buffers.size();
+	}
+	started = true;
+	current = last = nullptr;
+	if (sizes[slot] == 0) {
+		return; // the end of the file
+	}
+	uint32_t filled = 0;
+	while (true) {
+		ring.wait(requests[slot]);
+		auto result = requests[slot].result;
+		if (result <= 0) {
+			sizes[slot] = 0;
+			throw Error(result < 0 ? "unable to read file " + path : "file " + path + " has been truncated");
+		}
+		filled += uint32_t(result);
+		if (filled >= sizes[slot]) {
+			break;
+		}
+		// a short read is continued from where it has stopped
+		ring.read(requests[slot], file, buffers[slot].data() + filled, sizes[slot] - filled, offsets[slot] + filled);
+	}
+	current = buffers[slot].data();
+	last = current + sizes[slot];
+}
+
+#else
+
+IoRing::IoRing(unsigned /*entries = 256*/)
+{
+}
+
+IoRing::~IoRing()
+{
+}
+
+bool IoRing::isAvailable() const
+{
+	return false;
+}
+
+void IoRing::read(Request&, int, char*, uint32_t, uint64_t)
+{
+	throw Error("asynchronous file reads are not supported");
+}
+
+void IoRing::wait(Request&)
+{
+}
+
+AsyncFileSource::AsyncFileSource(IoRing& ring, const std::string& path, const Options& options /*= {}*/)
+	: ring(ring), path(path)
+{
+	ReadAheadSource::Options fallback_options;
+	fallback_options.blocks = std::max<uint32_t>(options.blocks, 1);
+	fallback_options.block_size = std::max<uint32_t>(options.block_size, 1);
+	fallback_file.reset(new FileSource(path));
+	fallback.reset(new ReadAheadSource(*fallback_file, fallback_options));
+}
+
+AsyncFileSource::~AsyncFileSource()
+{
+}
+
+#endif
+
+bool AsyncFileSource::isAsynchronous() const
+{
+	return !fallback;
+}
+
+void AsyncFileSource::skipCharacter()
+{
+	if (fallback) {
+		fallback->skipCharacter();
+	}
+	else if (current && ++current >= last) {
+		acquireBlock();
+	}
+}
+
+std::char_traits<char>::int_type AsyncFileSource::getCharacter() const
+{
+	if (fallback) {
+		return fallback->getCharacter();
+	}
+	if (!started) {
+		const_cast<AsyncFileSource*>(this)->acquireBlock();
+	}
+	if (current < last) {
+		return std::char_traits<char>::to_int_type(*current);
+	}
+	return std::char_traits<char>::eof();
+}
+
+} /* namespace json */
+} /* namespace az */
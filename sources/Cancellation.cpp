@@ -0,0 +1,43 @@
+#include <az/json/Cancellation.h>
+#include <limits>
+
+namespace az {
+namespace json {
+
+Cancellation::Cancellation(uint32_t interval /*= 1024*/)
+	: cancelled(false), deadline(std::numeric_limits<Clock::rep>::max()), interval(interval ? interval : 1)
+{
+}
+
+Cancellation& Cancellation::withDeadline(Clock::time_point v)
+{
+	deadline = v.time_since_epoch().count();
+	return *this;
+}
+
+Cancellation& Cancellation::withTimeout(Clock::duration v)
+{
+	return withDeadline(Clock::now() + v);
+}
+
+void Cancellation::cancel()
+{
+	cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool Cancellation::isCancelled() const
+{
+	if (cancelled.load(std::memory_order_relaxed)) {
+		return true;
+	}
+	auto ticks = deadline.load(std::memory_order_relaxed);
+	return ticks != std::numeric_limits<Clock::rep>::max() && Clock::now().time_since_epoch().count() >= ticks;
+}
+
+uint32_t Cancellation::getInterval() const
+{
+	return interval;
+}
+
+} /* namespace json */
+} /* namespace az */
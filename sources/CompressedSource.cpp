@@ -0,0 +1,219 @@
+#include <az/json/CompressedSource.h>
+#include <cstring>
+
+#ifdef AZ_JSON_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef AZ_JSON_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace az {
+namespace json {
+
+Compression detectCompression(const char* data, std::size_t size)
+{
+	if (size >= 2 && memcmp(data, "\x1F\x8B", 2) == 0) {
+		return Compression::Gzip;
+	}
+	if (size >= 4 && memcmp(data, "\x28\xB5\x2F\xFD", 4) == 0) {
+		return Compression::Zstd;
+	}
+	return Compression::None;
+}
+
+#ifdef AZ_JSON_WITH_ZLIB
+
+struct GzipSource::Stream
+{
+	BlockSource& input;
+	std::vector<char> buffer;
+	z_stream state;
+	bool input_finished = false;
+	// the data may consist of several concatenated members
+	bool member_finished = true;
+
+	explicit Stream(BlockSource& input)
+		: input(input), buffer(input.getBlockSize())
+	{
+		memset(&state, 0, sizeof(state));
+		// detects gzip or zlib header automatically
+		if (inflateInit2(&state, 15 + 32) != Z_OK) {
+			throw Error("unable to initialize gzip decompression");
+		}
+	}
+	~Stream() {
+		inflateEnd(&state);
+	}
+};
+
+GzipSource::GzipSource(BlockSource& input, std::size_t block_size /*= 1 << 16*/)
+	: BlockSource(block_size), stream(new Stream(input))
+{
+}
+
+GzipSource::~GzipSource()
+{
+}
+
+bool GzipSource::isSupported()
+{
+	return true;
+}
+
+std::size_t GzipSource::readBlock(char* buffer, std::size_t size)
+{
+	auto& state = stream->state;
+	state.next_out = reinterpret_cast<Bytef*>(buffer);
+	state.avail_out = uInt(size);
+	while (state.avail_out > 0) {
+		if (state.avail_in == 0 && !stream->input_finished) {
+			state.next_in = reinterpret_cast<Bytef*>(stream->buffer.data());
+			state.avail_in = uInt(stream->input.readBlock(stream->buffer.data(), stream->buffer.size()));
+			stream->input_finished = state.avail_in == 0;
+		}
+		if (state.avail_in == 0 && stream->input_finished && stream->member_finished) {
+			break;
+		}
+		auto available = state.avail_out;
+		auto result = inflate(&state, Z_NO_FLUSH);
+		if (result == Z_STREAM_END) {
+			stream->member_finished = true;
+			inflateReset(&state);
+		}
+		else if (result == Z_OK || result == Z_BUF_ERROR) {
+			stream->member_finished = false;
+			if (state.avail_in == 0 && stream->input_finished && state.avail_out == available) {
+				throw Error("unexpected end of gzip data");
+			}
+		}
+		else {
+			throw Error("malformed gzip data");
+		}
+	}
+	return size - state.avail_out;
+}
+
+#else
+
+struct GzipSource::Stream
+{
+};
+
+GzipSource::GzipSource(BlockSource&, std::size_t block_size /*= 1 << 16*/)
+	: BlockSource(block_size)
+{
+	throw Error("gzip input is not supported");
+}
+
+GzipSource::~GzipSource()
+{
+}
+
+bool GzipSource::isSupported()
+{
+	return false;
+}
+
+std::size_t GzipSource::readBlock(char*, std::size_t)
+{
+	return 0;
+}
+
+#endif
+
+#ifdef AZ_JSON_WITH_ZSTD
+
+struct ZstdSource::Stream
+{
+	BlockSource& input;
+	std::vector<char> buffer;
+	ZSTD_DStream* state;
+	ZSTD_inBuffer pending = {nullptr, 0, 0};
+	bool input_finished = false;
+	// a non-zero hint means that the current frame is not complete yet
+	std::size_t hint = 0;
+
+	explicit Stream(BlockSource& input)
+		: input(input), buffer(ZSTD_DStreamInSize()), state(ZSTD_createDStream())
+	{
+		if (!state || ZSTD_isError(ZSTD_initDStream(state))) {
+			ZSTD_freeDStream(state);
+			throw Error("unable to initialize zstd decompression");
+		}
+	}
+	~Stream() {
+		ZSTD_freeDStream(state);
+	}
+};
+
+ZstdSource::ZstdSource(BlockSource& input, std::size_t block_size /*= 1 << 16*/)
+	: BlockSource(block_size), stream(new Stream(input))
+{
+}
+
+ZstdSource::~ZstdSource()
+{
+}
+
+bool ZstdSource::isSupported()
+{
+	return true;
+}
+
+std::size_t ZstdSource::readBlock(char* buffer, std::size_t size)
+{
+	auto& pending = stream->pending;
+	ZSTD_outBuffer output = {buffer, size, 0};
+	while (output.pos < output.size) {
+		if (pending.pos == pending.size && !stream->input_finished) {
+			pending.src = stream->buffer.data();
+			pending.size = stream->input.readBlock(stream->buffer.data(), stream->buffer.size());
+			pending.pos = 0;
+			stream->input_finished = pending.size == 0;
+		}
+		if (pending.pos == pending.size && stream->input_finished && stream->hint == 0) {
+			break;
+		}
+		auto produced = output.pos;
+		stream->hint = ZSTD_decompressStream(stream->state, &output, &pending);
+		if (ZSTD_isError(stream->hint)) {
+			throw Error("malformed zstd data");
+		}
+		if (pending.pos == pending.size && stream->input_finished && output.pos == produced && stream->hint != 0) {
+			throw Error("unexpected end of zstd data");
+		}
+	}
+	return output.pos;
+}
+
+#else
+
+struct ZstdSource::Stream
+{
+};
+
+ZstdSource::ZstdSource(BlockSource&, std::size_t block_size /*= 1 << 16*/)
+	: BlockSource(block_size)
+{
+	throw Error("zstd input is not supported");
+}
+
+ZstdSource::~ZstdSource()
+{
+}
+
+bool ZstdSource::isSupported()
+{
+	return false;
+}
+
+std::size_t ZstdSource::readBlock(char*, std::size_t)
+{
+	return 0;
+}
+
+#endif
+
+} /* namespace json */
+} /* namespace az */
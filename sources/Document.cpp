@@ -0,0 +1,77 @@
+#include <az/json/Document.h>
+
+namespace az {
+namespace json {
+
+Document::Document(const Arena::Options& options /*= {}*/)
+	: arena(options)
+{
+}
+
+Document::~Document()
+{
+	clear();
+}
+
+Reader::Options Document::prepare(Reader::Options options)
+{
+	clear();
+	options.memory_resource = &arena;
+	return options;
+}
+
+Document& Document::parse(const char* text, std::size_t size, Reader::Options options /*= {}*/)
+{
+	Reader(root, prepare(options)).parse(text, text + size);
+	return *this;
+}
+
+Document& Document::parse(const std::string& text, Reader::Options options /*= {}*/)
+{
+	Reader(root, prepare(options)).parse(text);
+	return *this;
+}
+
+Document& Document::parse(std::istream& stream, Reader::Options options /*= {}*/)
+{
+	Reader(root, prepare(options)).parse(stream);
+	return *this;
+}
+
+Document& Document::parseFile(const std::string& path, Reader::Options options /*= {}*/)
+{
+	Reader(root, prepare(options)).parseFile(path);
+	return *this;
+}
+
+const Value& Document::getRoot() const
+{
+	return root;
+}
+
+Value& Document::modifyRoot()
+{
+	sealed = false;
+	return root;
+}
+
+const Arena& Document::getArena() const
+{
+	return arena;
+}
+
+void Document::clear()
+{
+	if (sealed) {
+		// nothing of the tree is kept out of the arena, so the values are not destroyed one by one
+		root.abandon();
+	}
+	else {
+		root.reset();
+	}
+	arena.release();
+	sealed = true;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -1,29 +1,41 @@
-#include <az/json/Error.h>
-
-namespace az {
-namespace json {
-
-Error::Error(const std::string& reason, int line /*= -1*/, int column /*= -1*/)
-{
-	context.line = line;
-	context.column = column;
-	context.reason = reason;
-}
-
-char const* Error::what() const noexcept
-{
-	return context.reason.c_str();
-}
-
-int Error::line() const
-{
-	return context.line;
-}
-
-int Error::column() const
-{
-	return context.column;
-}
-
-} /* namespace json */
-} /* namespace az */
+#include <az/json/Error.h>
+
+namespace az {
+namespace json {
+
+Error::Error(const std::string& reason, int line /*= -1*/, int column /*= -1*/, int64_t offset /*= -1*/, Code code /*= Code::Generic*/)
+{
+	context.code = code;
+	context.line = line;
+	context.column = column;
+	context.offset = offset;
+	context.reason = reason;
+}
+
+char const* Error::what() const noexcept
+{
+	return context.reason.c_str();
+}
+
+int Error::line() const
+{
+	return context.line;
+}
+
+int Error::column() const
+{
+	return context.column;
+}
+
+int64_t Error::offset() const
+{
+	return context.offset;
+}
+
+Error::Code Error::code() const
+{
+	return context.code;
+}
+
+} /* namespace json */
+} /* namespace az */
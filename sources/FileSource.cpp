@@ -0,0 +1,57 @@
+#include <az/json/FileSource.h>
+#include <algorithm>
+#include <cstring>
+
+namespace az {
+namespace json {
+
+FileSource::FileSource(const std::string& path, std::size_t block_size /*= 1 << 16*/)
+	: BlockSource(block_size), path(path)
+{
+	file = std::fopen(path.c_str(), "rb");
+	if (!file) {
+		throw Error("unable to open file " + path);
+	}
+	// the blocks are large enough, so there is no need to buffer them once more
+	std::setvbuf(file, nullptr, _IONBF, 0);
+}
+
+FileSource::~FileSource()
+{
+	std::fclose(file);
+}
+
+std::size_t FileSource::readBlock(char* buffer, std::size_t size)
+{
+	std::size_t count = 0;
+	if (!peeked.empty()) {
+		count = std::min(size, peeked.size());
+		std::memcpy(buffer, peeked.data(), count);
+		peeked.erase(0, count);
+	}
+	return count + readFile(buffer + count, size - count);
+}
+
+std::size_t FileSource::peek(char* buffer, std::size_t size)
+{
+	if (peeked.size() < size) {
+		const auto offset = peeked.size();
+		peeked.resize(size);
+		peeked.resize(offset + readFile(&peeked[offset], size - offset));
+	}
+	const auto count = std::min(size, peeked.size());
+	std::memcpy(buffer, peeked.data(), count);
+	return count;
+}
+
+std::size_t FileSource::readFile(char* buffer, std::size_t size)
+{
+	auto count = std::fread(buffer, 1, size, file);
+	if (count < size && std::ferror(file)) {
+		throw Error("unable to read file " + path);
+	}
+	return count;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,101 @@
+#include <az/json/MappedFile.h>
+#include <az/json/Error.h>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace az {
+namespace json {
+
+#ifndef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+	: path(path)
+{
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw Error("unable to open file " + path);
+	}
+	struct stat status;
+	if (::fstat(file, &status) != 0) {
+		::close(file);
+		throw Error("unable to get status of file " + path);
+	}
+	length = std::size_t(status.st_size);
+#ifdef __linux__
+	modification_time = int64_t(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+#else
+	modification_time = int64_t(status.st_mtime) * 1000000000;
+#endif
+	if (length > 0) {
+		void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapping == MAP_FAILED) {
+			::close(file);
+			throw Error("unable to map file " + path);
+		}
+		address = static_cast<const char*>(mapping);
+	}
+	::close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (address) {
+		::munmap(const_cast<char*>(address), length);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+	: path(path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw Error("unable to open file " + path);
+	}
+	content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	address = content.data();
+	length = content.size();
+	struct _stat64 status;
+	if (_stat64(path.c_str(), &status) == 0) {
+		modification_time = int64_t(status.st_mtime) * 1000000000;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+}
+
+#endif
+
+const char* MappedFile::data() const
+{
+	return address;
+}
+
+std::size_t MappedFile::size() const
+{
+	return length;
+}
+
+int64_t MappedFile::getModificationTime() const
+{
+	return modification_time;
+}
+
+const std::string& MappedFile::getPath() const
+{
+	return path;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,49 @@
+#include <az/json/MemoryResource.h>
+#include <new>
+
+namespace az {
+namespace json {
+namespace {
+
+class NewDeleteResource final : public MemoryResource
+{
+protected:
+	void* doAllocate(std::size_t size, std::size_t) override {
+		return ::operator new(size);
+	}
+	void doDeallocate(void* memory, std::size_t, std::size_t) override {
+		::operator delete(memory);
+	}
+};
+
+thread_local MemoryResource* current = nullptr;
+
+} /* namespace */
+
+MemoryResource* MemoryResource::getDefault()
+{
+	// it is never destroyed, so values which are destroyed at exit still may release their memory
+	static MemoryResource* resource = new NewDeleteResource();
+	return resource;
+}
+
+MemoryResource* MemoryResource::getCurrent()
+{
+	return current ? current : getDefault();
+}
+
+MemoryResource::Scope::Scope(MemoryResource* resource)
+	: previous(current)
+{
+	if (resource) {
+		current = resource;
+	}
+}
+
+MemoryResource::Scope::~Scope()
+{
+	current = previous;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,536 @@
+#include <az/json/Value.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AZ_JSON_OBJECT_SSE2
+#endif
+
+namespace az {
+namespace json {
+
+const std::size_t Object::flat_size;
+const std::size_t Object::hashed_size;
+const std::size_t Object::npos;
+
+namespace {
+
+bool isEqual(const Object::key_type& key, const char* other, std::size_t size)
+{
+	return key.size() == size && std::memcmp(key.data(), other, size) == 0;
+}
+
+// compares keys in the same way as std::string does
+int compareKeys(const Object::key_type& key, const char* other, std::size_t size)
+{
+	const int order = std::char_traits<char>::compare(key.data(), other, std::min(key.size(), size));
+	if (order != 0) {
+		return order;
+	}
+	return key.size() < size ? -1 : (key.size() > size ? 1 : 0);
+}
+
+uint8_t getHead(const char* key, std::size_t size)
+{
+	return size > 0 ? uint8_t(key[0]) : 0;
+}
+
+struct Seed {
+	uint64_t first;
+	uint64_t second;
+};
+
+Seed makeSeed()
+{
+	Seed seed = {0, 0};
+	try {
+		std::random_device device;
+		seed.first = uint64_t(device()) << 32 | device();
+		seed.second = uint64_t(device()) << 32 | device();
+	}
+	catch (const std::exception&) {
+		// the clock and an address are still unknown to the author of the text
+	}
+	seed.first ^= uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+	seed.second ^= uint64_t(reinterpret_cast<std::uintptr_t>(&seed));
+	return seed;
+}
+
+// a random key of the process makes collisions of crafted keys unpredictable
+const Seed& getSeed()
+{
+	static const Seed seed = makeSeed();
+	return seed;
+}
+
+uint64_t rotate(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+void mix(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+	v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+	v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+	v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+	v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+}
+
+// SipHash-1-3
+uint32_t hashKey(const char* key, std::size_t size)
+{
+	const auto& seed = getSeed();
+	uint64_t v0 = 0x736f6d6570736575ull ^ seed.first;
+	uint64_t v1 = 0x646f72616e646f6dull ^ seed.second;
+	uint64_t v2 = 0x6c7967656e657261ull ^ seed.first;
+	uint64_t v3 = 0x7465646279746573ull ^ seed.second;
+	const auto blocks = size & ~std::size_t(7);
+	for (std::size_t position = 0; position < blocks; position += 8) {
+		uint64_t block;
+		std::memcpy(&block, key + position, sizeof(block));
+		v3 ^= block;
+		mix(v0, v1, v2, v3);
+		v0 ^= block;
+	}
+	uint64_t last = uint64_t(size) << 56;
+	for (std::size_t position = blocks; position < size; position++) {
+		last |= uint64_t(uint8_t(key[position])) << (8 * (position - blocks));
+	}
+	v3 ^= last;
+	mix(v0, v1, v2, v3);
+	v0 ^= last;
+	v2 ^= 0xff;
+	mix(v0, v1, v2, v3);
+	mix(v0, v1, v2, v3);
+	mix(v0, v1, v2, v3);
+	const auto hash = v0 ^ v1 ^ v2 ^ v3;
+	return uint32_t(hash ^ (hash >> 32));
+}
+
+bool isLessKey(const Object::value_type& left, const Object::value_type& right)
+{
+	return left.first < right.first;
+}
+
+// members of an object in the order of their keys
+std::vector<const Object::value_type*> getSortedMembers(const Object& object)
+{
+	std::vector<const Object::value_type*> sorted;
+	sorted.reserve(object.size());
+	for (const auto& member : object) {
+		sorted.push_back(&member);
+	}
+	if (object.getOrder() != Object::Order::Sorted) {
+		std::sort(sorted.begin(), sorted.end(), [](const Object::value_type* left, const Object::value_type* right) {
+			return left->first < right->first;
+		});
+	}
+	return sorted;
+}
+
+// objects are sorted rarely, so a single lock serves all of them
+std::mutex& getSortingMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+} /* namespace */
+
+Object::Object(const Object& other)
+	: members((other.sort(), other.members)), index(other.index), order(other.order), lookup(other.lookup)
+{
+	std::copy(std::begin(other.heads), std::end(other.heads), heads);
+}
+
+Object::Object(Object&& other) noexcept
+	: members(std::move(other.members)), index(std::move(other.index)), order(other.order), lookup(other.lookup),
+	unsorted(other.unsorted.load(std::memory_order_relaxed))
+{
+	std::copy(std::begin(other.heads), std::end(other.heads), heads);
+	other.unsorted.store(false, std::memory_order_relaxed);
+}
+
+Object& Object::operator=(const Object& other)
+{
+	if (this != &other) {
+		other.sort();
+		members = other.members;
+		std::copy(std::begin(other.heads), std::end(other.heads), heads);
+		index = other.index;
+		order = other.order;
+		lookup = other.lookup;
+		unsorted.store(false, std::memory_order_relaxed);
+	}
+	return *this;
+}
+
+Object& Object::operator=(Object&& other)
+{
+	if (this != &other) {
+		members = std::move(other.members);
+		std::copy(std::begin(other.heads), std::end(other.heads), heads);
+		index = std::move(other.index);
+		order = other.order;
+		lookup = other.lookup;
+		unsorted.store(other.unsorted.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		other.unsorted.store(false, std::memory_order_relaxed);
+	}
+	return *this;
+}
+
+Object::const_iterator Object::find(const std::string& key) const
+{
+	sort();
+	const auto position = locate(key.data(), key.size());
+	return position == npos ? members.end() : members.begin() + position;
+}
+
+Object::const_iterator Object::find(const char* key, std::size_t size) const
+{
+	sort();
+	const auto position = locate(key, size);
+	return position == npos ? members.end() : members.begin() + position;
+}
+
+std::size_t Object::count(const std::string& key) const
+{
+	sort();
+	return locate(key.data(), key.size()) == npos ? 0 : 1;
+}
+
+const Value& Object::at(const std::string& key) const
+{
+	sort();
+	const auto position = locate(key.data(), key.size());
+	if (position == npos) {
+		throw std::out_of_range("object has no member " + key);
+	}
+	return members[position].second;
+}
+
+Value& Object::operator[](const std::string& key)
+{
+	const auto position = locate(key.data(), key.size());
+	return position == npos ? insert(key.data(), key.size()) : members[position].second;
+}
+
+Value& Object::operator[](std::string&& key)
+{
+	return (*this)[static_cast<const std::string&>(key)];
+}
+
+bool Object::emplace(std::string key, Value value)
+{
+	if (locate(key.data(), key.size()) != npos) {
+		return false;
+	}
+	insert(key.data(), key.size()) = std::move(value);
+	return true;
+}
+
+void Object::clear()
+{
+	members.clear();
+	std::fill(index.begin(), index.end(), Slot{0, 0});
+	unsorted.store(false, std::memory_order_relaxed);
+}
+
+void Object::reserve(std::size_t size)
+{
+	members.reserve(size);
+	if (!isIndexed(size)) {
+		return;
+	}
+	if (index.empty()) {
+		indexMembers(size);
+	}
+	else {
+		growIndex(size);
+	}
+}
+
+bool Object::operator==(const Object& other) const
+{
+	sort();
+	other.sort();
+	if (members.size() != other.members.size()) {
+		return false;
+	}
+	if (order == Order::Sorted && other.order == Order::Sorted) {
+		return members == other.members;
+	}
+	for (const auto& member : members) {
+		const auto position = other.locate(member.first.data(), member.first.size());
+		if (position == npos || other.members[position].second != member.second) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Object::operator!=(const Object& other) const
+{
+	return !(*this == other);
+}
+
+bool Object::operator<(const Object& other) const
+{
+	sort();
+	other.sort();
+	if (order == Order::Sorted && other.order == Order::Sorted) {
+		return std::lexicographical_compare(members.begin(), members.end(), other.members.begin(), other.members.end());
+	}
+	const auto left = getSortedMembers(*this);
+	const auto right = getSortedMembers(other);
+	return std::lexicographical_compare(left.begin(), left.end(), right.begin(), right.end(),
+		[](const value_type* left, const value_type* right) { return *left < *right; });
+}
+
+bool Object::isIndexed(std::size_t size) const
+{
+	if (lookup == Lookup::Hashed) {
+		return size > 0;
+	}
+	return size > (order == Order::Sorted ? hashed_size : flat_size);
+}
+
+std::size_t Object::locate(const char* key, std::size_t size) const
+{
+	if (!index.empty()) {
+		return probe(key, size, hashKey(key, size));
+	}
+	if (members.size() <= flat_size) {
+		return scan(key, size);
+	}
+	const auto position = lowerBound(key, size);
+	return position < members.size() && isEqual(members[position].first, key, size) ? position : npos;
+}
+
+std::size_t Object::scan(const char* key, std::size_t size) const
+{
+	const auto head = getHead(key, size);
+#ifdef AZ_JSON_OBJECT_SSE2
+	static_assert(flat_size == 16, "the first bytes of keys are compared by a single block");
+	// keys are compared only if their first bytes are the same
+	const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(heads));
+	auto mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(char(head)))));
+	mask &= (1u << members.size()) - 1;
+	for (std::size_t position = 0; mask != 0; position++, mask >>= 1) {
+		if ((mask & 1) && isEqual(members[position].first, key, size)) {
+			return position;
+		}
+	}
+#else
+	for (std::size_t position = 0; position < members.size(); position++) {
+		if (heads[position] == head && isEqual(members[position].first, key, size)) {
+			return position;
+		}
+	}
+#endif
+	return npos;
+}
+
+std::size_t Object::lowerBound(const char* key, std::size_t size) const
+{
+	std::size_t low = 0;
+	std::size_t high = members.size();
+	while (low < high) {
+		const auto middle = low + (high - low) / 2;
+		if (compareKeys(members[middle].first, key, size) < 0) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+std::size_t Object::probe(const char* key, std::size_t size, uint32_t hash) const
+{
+	const auto mask = index.size() - 1;
+	for (auto slot = hash & mask; index[slot].position != 0; slot = (slot + 1) & mask) {
+		// keys are compared only if their hashes are the same
+		const auto position = index[slot].position - 1;
+		if (index[slot].hash == hash && isEqual(members[position].first, key, size)) {
+			return position;
+		}
+	}
+	return npos;
+}
+
+Value& Object::insert(const char* key, std::size_t size)
+{
+	const auto head = getHead(key, size);
+	const auto hash = index.empty() ? 0 : hashKey(key, size);
+	value_type member(key_type(key, size, members.get_allocator()), Value());
+	std::size_t position = members.size();
+	if (order == Order::Sorted && index.empty()) {
+		position = lowerBound(key, size);
+		members.insert(members.begin() + position, std::move(member));
+		if (members.size() <= flat_size) {
+			std::memmove(heads + position + 1, heads + position, members.size() - 1 - position);
+		}
+	}
+	else {
+		// an indexed object finds members by hashes, so a sorted one appends them and keeps their positions in the index
+		if (order == Order::Sorted && !members.empty() && compareKeys(members.back().first, key, size) > 0) {
+			unsorted.store(true, std::memory_order_relaxed);
+		}
+		members.push_back(std::move(member));
+	}
+	if (members.size() <= flat_size) {
+		heads[position] = head;
+	}
+	if (!index.empty()) {
+		growIndex(members.size());
+		place({uint32_t(position + 1), hash});
+	}
+	else if (isIndexed(members.size())) {
+		indexMembers(members.size());
+	}
+	return members[position].second;
+}
+
+void Object::indexHeads()
+{
+	for (std::size_t position = 0; position < members.size() && position < flat_size; position++) {
+		heads[position] = getHead(members[position].first.data(), members[position].first.size());
+	}
+}
+
+void Object::indexMembers(std::size_t size)
+{
+	index.clear();
+	growIndex(size);
+	for (std::size_t position = 0; position < members.size(); position++) {
+		const auto& key = members[position].first;
+		place({uint32_t(position + 1), hashKey(key.data(), key.size())});
+	}
+}
+
+void Object::growIndex(std::size_t size)
+{
+	// the table is kept at most half full
+	if (index.size() >= size * 2) {
+		return;
+	}
+	std::size_t slots = 64;
+	while (slots < size * 4) {
+		slots *= 2;
+	}
+	auto slotted = std::move(index);
+	index.assign(slots, Slot{0, 0});
+	for (const auto& slot : slotted) {
+		if (slot.position != 0) {
+			place(slot);
+		}
+	}
+}
+
+void Object::place(Slot slot)
+{
+	const auto mask = index.size() - 1;
+	auto position = slot.hash & mask;
+	while (index[position].position != 0) {
+		position = (position + 1) & mask;
+	}
+	index[position] = slot;
+}
+
+void Object::sortMembers() const
+{
+	std::lock_guard<std::mutex> lock(getSortingMutex());
+	if (!unsorted.load(std::memory_order_relaxed)) {
+		return;
+	}
+	// the storage of the object is not constant, the order of its members is not a part of its value
+	auto& object = const_cast<Object&>(*this);
+#ifdef AZ_JSON_STABLE_MEMBERS
+	object.members.sortNodes(isLessKey);
+#else
+	std::sort(object.members.begin(), object.members.end(), isLessKey);
+#endif
+	object.indexHeads();
+	std::fill(object.index.begin(), object.index.end(), Slot{0, 0});
+	for (std::size_t position = 0; position < members.size(); position++) {
+		const auto& key = members[position].first;
+		object.place({uint32_t(position + 1), hashKey(key.data(), key.size())});
+	}
+	unsorted.store(false, std::memory_order_release);
+}
+
+Value& Object::append(const std::string& key)
+{
+	members.emplace_back(key_type(key.data(), key.size(), members.get_allocator()), Value());
+	return members.back().second;
+}
+
+void Object::settle()
+{
+	if (order == Order::Sorted) {
+		if (!std::is_sorted(members.begin(), members.end(), isLessKey)) {
+			std::stable_sort(members.begin(), members.end(), isLessKey);
+		}
+		// equal keys follow each other in the order of appending, so the last one is kept
+		std::size_t kept = 0;
+		for (std::size_t position = 0; position < members.size(); position++) {
+			if (position + 1 < members.size() && members[position].first == members[position + 1].first) {
+				continue;
+			}
+			if (kept != position) {
+				members[kept] = std::move(members[position]);
+			}
+			kept++;
+		}
+		members.erase(members.begin() + kept, members.end());
+		unsorted.store(false, std::memory_order_relaxed);
+		index.clear();
+		indexHeads();
+		if (isIndexed(members.size())) {
+			indexMembers(members.size());
+		}
+		return;
+	}
+	// a duplicate key keeps the position of its first appearance with the last value
+	auto appended = std::move(members);
+	members.clear();
+	members.reserve(appended.size());
+	index.clear();
+	if (!isIndexed(appended.size())) {
+		for (auto& member : appended) {
+			const auto position = scan(member.first.data(), member.first.size());
+			if (position != npos) {
+				members[position].second = std::move(member.second);
+			}
+			else {
+				heads[members.size()] = getHead(member.first.data(), member.first.size());
+				members.push_back(std::move(member));
+			}
+		}
+		return;
+	}
+	// the index is sized for all appended members at once, so every key is hashed once and never rehashed
+	growIndex(appended.size());
+	for (auto& member : appended) {
+		const auto hash = hashKey(member.first.data(), member.first.size());
+		const auto position = probe(member.first.data(), member.first.size(), hash);
+		if (position != npos) {
+			members[position].second = std::move(member.second);
+		}
+		else {
+			members.push_back(std::move(member));
+			place({uint32_t(members.size()), hash});
+		}
+	}
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -150,26 +150,50 @@ const Value& Path::resolve(const Value& root) const
 	const Value* node = &root;
 	for (const auto& argument : arguments) {
 		if (argument.type == Argument::Type::Key) {
-			if (!node->isObject() || !node->has(argument.key.c_str())) {
-				// Error: unable to resolve path (object value expected at position...)
-				return Value::null;
-			}
-			node = &((*node)[argument.key]);
+			// Error: unable to resolve path (object value expected at position...)
+			node = node->find(argument.key);
 		}
 		else if (argument.type == Argument::Type::Index) {
-			if (!node->isArray() || !node->has(argument.index)) {
-				// Error: unable to resolve path (array value expected at position...)
-				return Value::null;
-			}
-			node = &((*node)[argument.index]);
+			// Error: unable to resolve path (array value expected at position...)
+			node = node->find(argument.index);
 		}
 		else {
 			return Value::null;
 		}
+		if (!node) {
+			return Value::null;
+		}
 	}
 	return *node;
 }
 
+Tape::View Path::resolve(const Tape::View& root) const
+{
+	if (arguments.empty()) {
+		return {};
+	}
+	if (arguments.front().type == Argument::Type::Root) {
+		return root;
+	}
+
+	auto node = root;
+	for (const auto& argument : arguments) {
+		if (argument.type == Argument::Type::Key) {
+			node = node.find(argument.key);
+		}
+		else if (argument.type == Argument::Type::Index) {
+			node = node.find(argument.index);
+		}
+		else {
+			return {};
+		}
+		if (!node) {
+			return {};
+		}
+	}
+	return node;
+}
+
 Value& Path::make(Value& root) const
 {
 	Value* node = &root;
@@ -188,26 +212,29 @@ Value& Path::make(Value& root) const
 	return *node;
 }
 
+std::string Path::keyToString(const std::string& key)
+{
+	if (std::all_of(key.begin(), key.end(), Path::Argument::isKeySymbol)) {
+		return '.' + key;
+	}
+	return ".'" + key + '\'';
+}
+
+std::string Path::indexToString(Value::Index index)
+{
+	return '[' + std::to_string(index) + ']';
+}
+
 std::string Path::asString() const
 {
 	std::string output;
 	for (const auto& argument : arguments) {
 		switch (argument.type) {
 			case Path::Argument::Type::Key:
-				output += '.';
-				if (std::all_of(argument.key.begin(), argument.key.end(), Path::Argument::isKeySymbol)) {
-					output += argument.key;
-				}
-				else {
-					output += '\'';
-					output += argument.key;
-					output += '\'';
-				}
+				output += keyToString(argument.key);
 				break;
 			case Path::Argument::Type::Index:
-				output += '[';
-				output += std::to_string(argument.index);
-				output += ']';
+				output += indexToString(argument.index);
 				break;
 			default:
 				output += '.';
@@ -0,0 +1,110 @@
+#include <az/json/ReadAheadSource.h>
+#include <algorithm>
+
+namespace az {
+namespace json {
+
+ReadAheadSource::ReadAheadSource(BlockSource& input, const Options& options /*= {}*/)
+	: input(input),
+	buffers(std::max<uint32_t>(options.blocks, 1), std::vector<char>(std::max<std::size_t>(options.block_size, 1))),
+	sizes(buffers.size())
+{
+	thread = std::thread(&ReadAheadSource::produce, this);
+}
+
+ReadAheadSource::~ReadAheadSource()
+{
+	stopping = true;
+	notify();
+	thread.join();
+}
+
+template<class Predicate>
+void ReadAheadSource::waitFor(Predicate predicate)
+{
+	if (!predicate()) {
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, predicate);
+	}
+}
+
+void ReadAheadSource::notify()
+{
+	// the lock guarantees that the other side is either not checking its condition or already waits
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+	}
+	condition.notify_all();
+}
+
+void ReadAheadSource::produce()
+{
+	uint64_t block = 0;
+	while (true) {
+		waitFor([&] {
+			return stopping || block - consumed.load(std::memory_order_acquire) < buffers.size();
+		});
+		if (stopping) {
+			return;
+		}
+		auto slot = std::size_t(block % buffers.size());
+		try {
+			sizes[slot] = input.readBlock(buffers[slot].data(), buffers[slot].size());
+		}
+		catch (...) {
+			failure = std::current_exception();
+			sizes[slot] = 0;
+		}
+		produced.store(++block, std::memory_order_release);
+		notify();
+		if (sizes[slot] == 0) {
+			return; // an empty block marks the end of the text
+		}
+	}
+}
+
+void ReadAheadSource::acquireBlock()
+{
+	started = true;
+	auto block = consumed.load(std::memory_order_relaxed);
+	if (holding) {
+		holding = false;
+		consumed.store(++block, std::memory_order_release);
+		notify();
+	}
+	waitFor([&] {
+		return produced.load(std::memory_order_acquire) > block;
+	});
+	auto slot = std::size_t(block % buffers.size());
+	if (sizes[slot] == 0) {
+		current = last = nullptr;
+		if (failure) {
+			std::rethrow_exception(failure);
+		}
+		return;
+	}
+	holding = true;
+	current = buffers[slot].data();
+	last = current + sizes[slot];
+}
+
+void ReadAheadSource::skipCharacter()
+{
+	if (current && ++current >= last) {
+		acquireBlock();
+	}
+}
+
+std::char_traits<char>::int_type ReadAheadSource::getCharacter() const
+{
+	if (!started) {
+		const_cast<ReadAheadSource*>(this)->acquireBlock();
+	}
+	if (current < last) {
+		return std::char_traits<char>::to_int_type(*current);
+	}
+	return std::char_traits<char>::eof();
+}
+
+} /* namespace json */
+} /* namespace az */
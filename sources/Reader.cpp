@@ -1,32 +1,290 @@
 #include <az/json/Reader.h>
+#include <az/json/FileSource.h>
+#include <az/json/ReadAheadSource.h>
+#include <az/json/CompressedSource.h>
+#include <az/json/Path.h>
 #include <algorithm>
 #include <istream>
 #include <vector>
+#include <memory>
+#include <limits>
 #include <cstring>
+#include <cerrno>
+#include <cstdlib>
 
 namespace az {
 namespace json {
 
-void Source::skipLexeme()
+namespace {
+
+// estimates heap memory which is taken by a string value
+std::size_t getStringMemory(std::size_t size)
 {
-	for (auto letter : lexeme) {
-		position.column++;
-		if (letter == '\n') {
-			position.column = 1;
-			position.line++;
+	return size > Value::small_capacity ? sizeof(Value::Text) + size + 1 : 0;
+}
+
+// estimates heap memory which is taken by a member of an object with its key
+std::size_t getMemberMemory(std::size_t key_size)
+{
+	return sizeof(Value::Object::value_type) + (key_size >= sizeof(Value::Text) ? key_size + 1 : 0);
+}
+
+// aborts a string in the sink if the text is broken in the middle of it
+struct StreamGuard {
+	StringSink* sink = nullptr;
+	~StreamGuard() {
+		if (sink) {
+			sink->abort();
+		}
+	}
+};
+
+// keeps lexemes of the source again once a string which is not kept is read
+struct KeepGuard {
+	Source* source = nullptr;
+	~KeepGuard() {
+		if (source) {
+			source->keepLexeme(true);
+		}
+	}
+};
+
+// checks that a number is written as JSON does, so it is written back as it is,
+// and is short enough to be kept inside a value and to be decoded without overflows
+bool isPlainNumber(const std::string& lexeme)
+{
+	if (lexeme.size() > Value::small_capacity) {
+		return false;
+	}
+	auto letter = lexeme.begin();
+	const auto end = lexeme.end();
+	auto skipDigits = [&letter, &end]() {
+		const auto first = letter;
+		while (letter != end && isdigit(*letter)) {
+			letter++;
+		}
+		return std::size_t(letter - first);
+	};
+	if (letter != end && *letter == '-') {
+		letter++;
+	}
+	// leading zeros are not allowed
+	if (letter != end && *letter == '0') {
+		letter++;
+	}
+	else if (skipDigits() == 0) {
+		return false;
+	}
+	if (letter != end && *letter == '.') {
+		letter++;
+		if (skipDigits() == 0) {
+			return false;
+		}
+	}
+	if (letter != end && (*letter == 'e' || *letter == 'E')) {
+		letter++;
+		if (letter != end && (*letter == '+' || *letter == '-')) {
+			letter++;
+		}
+		// shorter exponents keep the number far from the limits of double
+		const auto exponent = skipDigits();
+		if (exponent == 0 || exponent > 2) {
+			return false;
+		}
+	}
+	return letter == end;
+}
+
+// checks that an integer is converted by parsing without overflows, so validation rejects the same numbers
+bool isIntegerInRange(const std::string& lexeme, bool hexadecimal)
+{
+	auto letter = lexeme.begin();
+	bool negative = false;
+	if (*letter == '-' || *letter == '+') {
+		negative = (*letter == '-');
+		letter++;
+	}
+	if (hexadecimal) {
+		letter += 2;
+	}
+	while (letter != lexeme.end() && *letter == '0') {
+		letter++;
+	}
+	const std::string limit = hexadecimal ? (negative ? "8000000000000000" : "7fffffffffffffff") :
+		(negative ? "9223372036854775808" : "9223372036854775807");
+	const auto digits = std::size_t(lexeme.end() - letter);
+	if (digits != limit.size()) {
+		return digits < limit.size();
+	}
+	// hexadecimal digits are compared regardless of their case
+	for (std::size_t index = 0; index < digits; index++) {
+		const auto digit = char(tolower(letter[index]));
+		if (digit != limit[index]) {
+			return digit < limit[index];
+		}
+	}
+	return true;
+}
+
+// checks that a real number is converted by parsing without overflows and underflows,
+// only numbers near the limits of double are converted to tell it
+bool isRealInRange(const std::string& lexeme)
+{
+	auto letter = lexeme.begin();
+	const auto end = lexeme.end();
+	if (*letter == '-' || *letter == '+') {
+		letter++;
+	}
+	if (isalpha(*letter)) {
+		// infinity and NaN are recognized by their first letters as strtod does
+		std::string keyword;
+		for (; letter != end && keyword.size() < 3; letter++) {
+			keyword.push_back(char(tolower(*letter)));
+		}
+		return keyword == "inf" || keyword == "nan";
+	}
+	// the number is below 10 to the power of the magnitude and not below a tenth of that
+	int64_t magnitude = 0;
+	bool digits = false;
+	bool significant = false;
+	for (; letter != end && isdigit(*letter); letter++) {
+		digits = true;
+		significant = significant || *letter != '0';
+		magnitude += significant ? 1 : 0;
+	}
+	if (letter != end && *letter == '.') {
+		for (letter++; letter != end && isdigit(*letter); letter++) {
+			digits = true;
+			if (!significant) {
+				significant = *letter != '0';
+				magnitude -= significant ? 0 : 1;
+			}
+		}
+	}
+	if (!digits) {
+		return false;
+	}
+	if (letter != end) {
+		letter++;
+		const bool negative = (*letter == '-');
+		if (*letter == '-' || *letter == '+') {
+			letter++;
+		}
+		int64_t exponent = 0;
+		for (; letter != end; letter++) {
+			exponent = std::min<int64_t>(exponent * 10 + (*letter - '0'), 1000000);
 		}
+		magnitude += negative ? -exponent : exponent;
 	}
+	if (!significant || (magnitude >= -305 && magnitude <= 308)) {
+		return true;
+	}
+	if (magnitude > 310 || magnitude < -400) {
+		return false;
+	}
+	errno = 0;
+	std::strtod(lexeme.c_str(), nullptr);
+	return errno != ERANGE;
+}
+
+} /* namespace */
+
+void Source::skipLexeme()
+{
+	position = next;
 	lexeme.clear();
 }
 
 Source& Source::operator++()
 {
-	lexeme.push_back(getCharacter());
+	const auto character = getCharacter();
+	if (keeping) {
+		lexeme.push_back(char(character));
+	}
+	next.offset++;
+	next.column++;
+	if (character == '\n') {
+		next.column = 1;
+		next.line++;
+	}
 	skipCharacter();
 	return *this;
 }
 
-class FileSource : public Source
+SegmentedSource::SegmentedSource(const Segment* segments, std::size_t count)
+	: segment(segments), last(segments + count)
+{
+	// trailing empty segments are dropped, so the last segment is known for getBuffer
+	while (last != segment && last[-1].size == 0) {
+		last--;
+	}
+	findSegment();
+}
+
+void SegmentedSource::findSegment()
+{
+	for (; segment < last; ++segment) {
+		if (segment->size > 0) {
+			current = segment->data;
+			end = current + segment->size;
+			return;
+		}
+	}
+	current = end = nullptr;
+}
+
+bool SegmentedSource::getBuffer(const char*& text, std::size_t& size) const
+{
+	// only the rest of the last segment is contiguous
+	if (segment + 1 < last) {
+		return false;
+	}
+	text = current;
+	size = std::size_t(end - current);
+	return true;
+}
+
+BlockSource::BlockSource(std::size_t block_size /*= 1 << 16*/)
+	: block_size(std::max<std::size_t>(block_size, 1))
+{
+}
+
+void BlockSource::fetchBlock()
+{
+	if (!started) {
+		// the buffer is not needed when the blocks are read by another source
+		buffer.resize(block_size);
+		started = true;
+	}
+	current = 0;
+	size = readBlock(buffer.data(), buffer.size());
+}
+
+void BlockSource::skipCharacter()
+{
+	if (++current >= size) {
+		fetchBlock();
+	}
+}
+
+std::char_traits<char>::int_type BlockSource::getCharacter() const
+{
+	if (!started) {
+		// the first block is read only on demand since readBlock is not available in the constructor
+		const_cast<BlockSource*>(this)->fetchBlock();
+	}
+	if (current < size) {
+		return std::char_traits<char>::to_int_type(buffer[current]);
+	}
+	return std::char_traits<char>::eof();
+}
+
+std::size_t BlockSource::getBlockSize() const
+{
+	return block_size;
+}
+
+class CFileSource : public Source
 {
 	std::FILE* file;
 	std::char_traits<char>::int_type character;
@@ -35,7 +293,7 @@ class FileSource : public Source
 		character = std::fgetc(file);
 	}
 public:
-	explicit FileSource(std::FILE* file)
+	explicit CFileSource(std::FILE* file)
 		: file(file) 
 	{
 		character = std::fgetc(file);
@@ -76,6 +334,14 @@ public:
 		}
 		return std::char_traits<char>::eof();
 	}
+	bool getBuffer(const char*& text, std::size_t& size) const override {
+		if (source) {
+			text = source;
+			size = strlen(source);
+			return true;
+		}
+		return false;
+	}
 };
 
 Reader& Reader::withNoThrows(bool v /*= true*/)
@@ -84,6 +350,68 @@ Reader& Reader::withNoThrows(bool v /*= true*/)
 	return *this;
 }
 
+Reader& Reader::withUtf8Validation(bool v /*= true*/)
+{
+	options.utf8 = v;
+	return *this;
+}
+
+Reader& Reader::withReadAhead(bool v /*= true*/)
+{
+	options.read_ahead = v;
+	return *this;
+}
+
+Reader& Reader::withExactSizing(bool v /*= true*/)
+{
+	options.exact_sizing = v;
+	return *this;
+}
+
+Reader& Reader::withStringSink(StringSink& sink, std::size_t threshold /*= 1 << 20*/, const std::vector<std::string>& paths /*= {}*/)
+{
+	options.string_sink = &sink;
+	options.string_threshold = threshold;
+	options.string_paths = paths;
+	return *this;
+}
+
+Reader& Reader::withShapeCaching(bool v /*= true*/)
+{
+	options.shape_caching = v;
+	return *this;
+}
+
+Reader& Reader::withInsertionOrder(bool v /*= true*/)
+{
+	options.insertion_order = v;
+	return *this;
+}
+
+Reader& Reader::withLazyNumbers(bool v /*= true*/)
+{
+	options.lazy_numbers = v;
+	return *this;
+}
+
+Reader& Reader::withLimits(const Limits& v)
+{
+	options.limits = v;
+	return *this;
+}
+
+Reader& Reader::withCancellation(const Cancellation& v)
+{
+	options.cancellation = &v;
+	return *this;
+}
+
+Reader& Reader::withMemoryResource(MemoryResource* v)
+{
+	options.memory_resource = v;
+	return *this;
+}
+
 Reader& Reader::strictly(bool v /*= true*/)
 {
 	options.strictly = v;
@@ -95,7 +423,31 @@ Reader::Reader(Value& root, const Options& options /*= {}*/)
 {
 }
 
-Reader::Token Reader::nextToken(Source& source) const
+Reader::Reader(Tape& tape, const Options& options /*= {}*/)
+	: root(unused), tape(&tape), options(options)
+{
+}
+
+bool Reader::skipLexeme(Source& source, bool finishing /*= false*/)
+{
+	if (validating) {
+		const auto& lexeme = source.getLexeme();
+		validator.feed(lexeme.data(), lexeme.size());
+		if (finishing) {
+			validator.finish();
+		}
+		if (validator.isMalformed()) {
+			auto offset = source.getPosition().offset;
+			auto size = validator.getOffset() > offset ? validator.getOffset() - offset : 0;
+			putEncodingError(source, lexeme.data(), std::min(size, lexeme.size()));
+			return false;
+		}
+	}
+	source.skipLexeme();
+	return true;
+}
+
+Reader::Token Reader::nextToken(Source& source, bool streamable /*= false*/)
 {
 	enum class State {
 		Begin,
@@ -118,8 +470,30 @@ Reader::Token Reader::nextToken(Source& source) const
 	} state = State::Begin;
 
 	uint8_t unicode_size = 0;
+	char quote = 0;
+	// a string value is streamed to the sink if it is longer than the threshold or it is at one of the paths
+	std::size_t flush_size = std::numeric_limits<std::size_t>::max();
+	std::size_t streamed = 0;
+	StreamGuard guard;
+	KeepGuard keeper;
+	// false while a string has only escaped new lines which are skipped
+	bool content = false;
 
-	for (source.skipLexeme() ;; ++source) {
+	if (!skipLexeme(source)) {
+		return Token::Unknown;
+	}
+	if (options.cancellation && --countdown == 0) {
+		countdown = options.cancellation->getInterval();
+		if (options.cancellation->isCancelled()) {
+			putError("parsing is cancelled", source, Error::Code::Cancelled);
+			return Token::Unknown;
+		}
+	}
+	for (;; ++source) {
+		if (source.getPosition().offset + source.getLexemeSize() > limits.bytes) {
+			putError("maximum size of the text is exceeded", source, Error::Code::Limit);
+			return Token::Unknown;
+		}
 		auto character = source.getCharacter();
 
 		switch (state) {
@@ -148,6 +522,20 @@ Reader::Token Reader::nextToken(Source& source) const
 					case '"':
 					case '\'':
 						state = State::String;
+						quote = char(character);
+						// a validated string is only checked, so its characters are not kept
+						if (dropping_strings && !validating) {
+							source.keepLexeme(false);
+							keeper.source = &source;
+						}
+						if (streamable && options.string_sink) {
+							if (std::find(string_paths.begin(), string_paths.end(), path) != string_paths.end()) {
+								flush_size = 1;
+							}
+							else if (options.string_threshold) {
+								flush_size = options.string_threshold + 1;
+							}
+						}
 						break;
 					case '-':
 					case '+':
@@ -177,22 +565,56 @@ Reader::Token Reader::nextToken(Source& source) const
 							return Token::Unknown;
 						}
 				}
-				source.skipLexeme();
+				if (!skipLexeme(source)) {
+					return Token::Unknown;
+				}
 				break;
 
 			case State::String: // "" or ''
-				if (character == '\\') {
+				if (streamed + source.getLexemeSize() - 1 > limits.string_length) {
+					putError("maximum length of a string is exceeded", source, Error::Code::Limit);
+					return Token::Unknown;
+				}
+				if (source.getLexeme().size() >= flush_size) {
+					if (streamed == 0) {
+						options.string_sink->open(path);
+						guard.sink = options.string_sink;
+					}
+					if (!streamString(source, streamed)) {
+						return Token::Unknown;
+					}
+					flush_size = 1 << 16;
+				}
+				if (character == std::char_traits<char>::eof()) {
+					return Token::Unknown;
+				}
+				else if (character == '\\') {
 					state = State::EscapedChar;
 				}
-				else if (character == source.getLexeme().front()) {
+				else if (character == quote) {
+					if (streamed > 0) {
+						if (!streamString(source, streamed)) {
+							return Token::Unknown;
+						}
+						// the sink is closed by the parser
+						guard.sink = nullptr;
+						++source;
+						return Token::StreamedString;
+					}
 					++source;
+					empty_string = !content;
 					return Token::String;
 				}
+				else {
+					content = true;
+				}
 				break;
 			case State::EscapedChar:
+				content = content || character != '\n';
 				if (character == 'u') {
 					state = State::UnicodeChar;
 					unicode_size = 0;
+					break;
 				}
 				else if (!strchr("\"\'\\/bfnrt\n", character)) {
 					return Token::Unknown;
@@ -276,6 +698,10 @@ Reader::Token Reader::nextToken(Source& source) const
 				}
 				break;
 			case State::Identifier:
+				if (source.getLexeme().size() > limits.string_length) {
+					putError("maximum length of a string is exceeded", source, Error::Code::Limit);
+					return Token::Unknown;
+				}
 				if (!isalnum(character) && character != '_') {
 					return Token::Identifier;
 				}
@@ -292,12 +718,18 @@ Reader::Token Reader::nextToken(Source& source) const
 				}
 				break;
 			case State::SingleComment:
-				if (character == '\n') {
+				if (character == std::char_traits<char>::eof()) {
+					return Token::End;
+				}
+				else if (character == '\n') {
 					state = State::Begin;
 				}
 				break;
 			case State::PluralComment:
-				if (character == '/' && source.getLexeme().back() == '*') {
+				if (character == std::char_traits<char>::eof()) {
+					return Token::Unknown;
+				}
+				else if (character == '/' && source.getLexeme().back() == '*') {
 					state = State::Begin;
 				}
 				break;
@@ -312,11 +744,10 @@ Reader::Token Reader::nextToken(Source& source) const
 					for (const auto& whitespace : whitespaces) {
 						if (memcmp(whitespace.data(), sequence.data(), sequence.length()) == 0) {
 							state = State::Begin;
-							source.skipLexeme();
 							break;
 						}
 					}
-					if (state != State::Begin) {
+					if (state != State::Begin || !skipLexeme(source)) {
 						return Token::Unknown;
 					}
 				}
@@ -330,40 +761,137 @@ Reader::Token Reader::nextToken(Source& source) const
 	return Token::End;
 }
 
-bool Reader::parseObject(Source& source, Value& value)
+bool Reader::parseObject(Source& source, Value* value)
+{
+	if (!value) {
+		return parseMembers(source, nullptr);
+	}
+	value->reset(Value::Type::Object);
+	auto& object = value->ownObject();
+	object.order = options.insertion_order ? Object::Order::Insertion : Object::Order::Sorted;
+	// members are appended as they are read and sorted out at once, unless spans have to know replaced members
+	bool parsed = false;
+	try {
+		parsed = parseMembers(source, value);
+	}
+	catch (...) {
+		if (!spans) {
+			object.settle();
+		}
+		throw;
+	}
+	if (!spans) {
+		object.settle();
+	}
+	return parsed;
+}
+
+bool Reader::parseMembers(Source& source, Value* value)
 {
-	value = Value(Value::Type::Object);
 	auto token = nextToken(source);
 	if (token == Token::ObjectEnd) {
 		return true;
 	}
+	const auto slot = openContainer();
+	if (value && sizing == Sizing::Replaying && slot < sizes.size()) {
+		value->ownObject().members.reserve(sizes[slot]);
+	}
+	uint64_t members = 0;
+	ShapeMatch match;
 	for (;; token = nextToken(source)) {
 		std::string id;
-		switch (token) {
-			case Token::ObjectEnd:
-				return true;
-			case Token::Identifier:
-				id = source.getLexeme();
-				break;
-			case Token::String:
-				id = unescapeString(source.getLexeme());
-				break;
-			default:
-				putError("identifier, string or } were expected", source);
-				return false;
+		std::size_t id_size = 0;
+		// a key is taken from the shape of previous objects if it is written in the same way
+		const std::string* key = nullptr;
+		if (value && options.shape_caching && (token == Token::Identifier || token == Token::String)) {
+			key = matchShape(match, members, source.getLexeme());
+		}
+		if (key) {
+			id_size = key->size();
+		}
+		else {
+			key = &id;
+			switch (token) {
+				case Token::ObjectEnd:
+					learnShape(match);
+					return true;
+				case Token::Identifier:
+					if (value) {
+						id = source.getLexeme();
+						learnKey(match, source.getLexeme(), id);
+					}
+					else if (taping) {
+						taping->addString(source.getLexeme().data(), source.getLexeme().size());
+					}
+					id_size = source.getLexeme().size();
+					break;
+				case Token::String:
+					if (value) {
+						id = unescapeString(source.getLexeme());
+						id_size = id.size();
+						learnKey(match, source.getLexeme(), id);
+					}
+					else if (taping) {
+						const auto& lexeme = source.getLexeme();
+						const auto offset = taping->strings.size();
+						unescapeText(lexeme.data() + 1, lexeme.data() + lexeme.size() - 1, taping->strings);
+						id_size = taping->addString(offset);
+					}
+					else if (!empty_string) {
+						id_size = source.getLexemeSize() - 2;
+					}
+					break;
+				default:
+					putError("identifier, string or } were expected", source);
+					return false;
+			}
 		}
-		if (id.empty()) {
+		if (id_size == 0) {
 			putError("empty object name", source);
 			return false;
 		}
+		if (++members > limits.elements) {
+			putError("maximum number of elements is exceeded", source, Error::Code::Limit);
+			return false;
+		}
+		if (!useMemory(getMemberMemory(id_size), source)) {
+			return false;
+		}
 		if (nextToken(source) != Token::Assignment) {
 			putError("assignment was expected", source);
 			return false;
 		}
-		if (!parseValue(nextToken(source), source, value[id])) {
+		const auto path_size = path.size();
+		Value* member = nullptr;
+		if (value) {
+			if (options.string_sink) {
+				path += Path::keyToString(*key);
+			}
+			if (!spans) {
+				member = &value->ownObject().append(*key);
+			}
+			else {
+				// the reference does not escape the reader, so the object is still shared by copies
+				auto& object = value->ownObject();
+				const auto count = object.size();
+				member = &object[*key];
+				if (object.size() == count) {
+					// the previous member with the same key is replaced
+					for (auto& child : spans->children) {
+						child.live = child.live && child.key != *key;
+					}
+				}
+			}
+		}
+		const auto children = spans ? spans->children.size() : 0;
+		if (!parseValue(nextToken(source, member != nullptr), source, member)) {
 			putError("value was expected", source);
 			return false;
 		}
+		if (spans && spans->children.size() > children) {
+			spans->children.back().key = *key;
+		}
+		path.resize(path_size);
 		token = nextToken(source);
 		if (token != Token::Next) {
 			break;
@@ -373,31 +901,122 @@ bool Reader::parseObject(Source& source, Value& value)
 		putError("'}' or ',' were expected", source);
 		return false;
 	}
+	learnShape(match);
 	return true;
 }
 
-bool Reader::parseArray(Source& source, Value& value)
+const std::string* Reader::matchShape(ShapeMatch& match, uint64_t member, const std::string& lexeme)
 {
-	value = Value(Value::Type::Array);
-	auto token = nextToken(source);
+	if (member == 0) {
+		match.shape = no_shape;
+		for (std::size_t shape = 0; shape < shapes.size(); shape++) {
+			if (shapes[shape].lexemes.front() == lexeme) {
+				match.shape = shape;
+				break;
+			}
+		}
+		match.learning = (match.shape == no_shape);
+	}
+	if (match.shape != no_shape) {
+		const auto& shape = shapes[match.shape];
+		if (member < shape.lexemes.size() && shape.lexemes[member] == lexeme) {
+			return &shape.keys[member];
+		}
+		// a later shape may have the same keys so far (earlier ones differ from them already),
+		// for example records which differ only by their last keys
+		for (auto other = match.shape + 1; other < shapes.size(); other++) {
+			const auto& candidate = shapes[other];
+			if (member < candidate.lexemes.size() && candidate.lexemes[member] == lexeme &&
+				std::equal(shape.lexemes.begin(), shape.lexemes.begin() + member, candidate.lexemes.begin())) {
+				match.shape = other;
+				return &candidate.keys[member];
+			}
+		}
+		// the object differs from all shapes, so it is learned as a new one starting from the matched keys
+		match.learned.lexemes.assign(shape.lexemes.begin(), shape.lexemes.begin() + member);
+		match.learned.keys.assign(shape.keys.begin(), shape.keys.begin() + member);
+		match.shape = no_shape;
+		match.learning = true;
+	}
+	return nullptr;
+}
+
+void Reader::learnKey(ShapeMatch& match, const std::string& lexeme, const std::string& key)
+{
+	if (match.learning) {
+		match.learned.lexemes.push_back(lexeme);
+		match.learned.keys.push_back(key);
+		match.learning = match.learned.lexemes.size() <= max_shape_size;
+	}
+}
+
+void Reader::learnShape(ShapeMatch& match)
+{
+	// the cache is not changed once it is full, so the keys are not moved while they are used
+	if (match.learning && !match.learned.lexemes.empty() && shapes.size() < shapes.capacity()) {
+		shapes.push_back(std::move(match.learned));
+	}
+}
+
+bool Reader::parseArray(Source& source, Value* value)
+{
+	if (value) {
+		*value = Value(Value::Type::Array);
+	}
+	// a path of an element is known before its token is read
+	const auto path_size = path.size();
+	if (value && options.string_sink) {
+		path += Path::indexToString(0);
+	}
+	auto token = nextToken(source, value != nullptr);
 	if (token == Token::ArrayEnd) {
+		path.resize(path_size);
 		return true;
 	}
-	for (;; token = nextToken(source)) {
+	const auto slot = openContainer();
+	// the array is allocated at once if its size is known from the first pass
+	const uint32_t presized = (value && sizing == Sizing::Replaying && slot < sizes.size()) ? sizes[slot] : 0;
+	if (presized > 0) {
+		value->reserve(presized);
+	}
+	uint64_t elements = 0;
+	for (;; token = nextToken(source, value != nullptr)) {
 		if (token == Token::ArrayEnd) {
+			path.resize(path_size);
 			return true;
 		}
-		Value array_value;
-		if (!parseValue(token, source, array_value)) {
+		if (++elements > limits.elements) {
+			putError("maximum number of elements is exceeded", source, Error::Code::Limit);
+			return false;
+		}
+		if (!useMemory(sizeof(Value), source)) {
+			return false;
+		}
+		const auto children = spans ? spans->children.size() : 0;
+		if (!value) {
+			if (!parseValue(token, source, nullptr)) {
+				putError("value was expected", source);
+				return false;
+			}
+		}
+		// the element is constructed in the array first and then filled in place, so it is not copied afterwards
+		else if (!parseValue(token, source, &value->addElement())) {
 			putError("value was expected", source);
 			return false;
 		}
-		value.append(std::move(array_value));
+		if (spans && spans->children.size() > children) {
+			spans->children.back().index = uint32_t(elements - 1);
+		}
 		token = nextToken(source);
 		if (token != Token::Next) {
 			break;
 		}
+		if (value && options.string_sink) {
+			path.resize(path_size);
+			path += Path::indexToString(Value::Index(elements));
+		}
 	}
+	path.resize(path_size);
 	if (token != Token::ArrayEnd) {
 		putError("']' or ',' were expected", source);
 		return false;
@@ -405,60 +1024,696 @@ bool Reader::parseArray(Source& source, Value& value)
 	return true;
 }
 
-bool Reader::parseValue(Token token, Source& source, Value& value)
+bool Reader::parseValue(Token token, Source& source, Value* value)
 {
+	if (++usage.values > limits.values) {
+		if (token == Token::StreamedString) {
+			options.string_sink->abort();
+		}
+		putError("maximum number of values is exceeded", source, Error::Code::Limit);
+		return false;
+	}
+	if (!value) {
+		return validateValue(token, source);
+	}
+	// a bracket is read together with the whitespace before it
+	auto begin = source.getPosition().offset;
+	if (token == Token::ArrayBegin || token == Token::ObjectBegin) {
+		begin += source.getLexeme().size() - 1;
+	}
 	switch (token) {
 		case Token::String:
-			value = unescapeString(source.getLexeme());
+			*value = unescapeString(source.getLexeme());
+			if (!useMemory(getStringMemory(value->size()), source)) {
+				return false;
+			}
 			break;
-		case Token::Integer:
-		case Token::Hex: {
-			const int base = (token == Token::Hex ? 16 : 10);
-			value = int64_t(std::stoll(source.getLexeme(), nullptr, base));
+		case Token::StreamedString:
+			*value = options.string_sink->close();
 			break;
-		}
+		case Token::Integer:
+		case Token::Hex:
 		case Token::Real:
-			value = std::stod(source.getLexeme());
+			// hexadecimal numbers are not written as JSON does, so they are always decoded
+			if ((options.lazy_numbers || raw_text) && isPlainNumber(source.getLexeme())) {
+				const auto& lexeme = source.getLexeme();
+				value->assignDigits(token == Token::Real ? Value::Type::Real : Value::Type::Integer, lexeme.data(), lexeme.size());
+			}
+			else if (!parseNumber(token, source, *value)) {
+				return false;
+			}
 			break;
 		case Token::Identifier: {
 			const auto& lexeme = source.getLexeme();
 			if (lexeme == "false") {
-				value = false;
+				*value = false;
 			}
 			else if (lexeme == "true") {
-				value = true;
+				*value = true;
 			}
 			else if (lexeme == "NaN" || lexeme == "Infinity") {
-				value = strtod(lexeme.c_str(), nullptr);
+				*value = strtod(lexeme.c_str(), nullptr);
 			}
-			else if (lexeme != "null") {
-				value = lexeme;
+			else if (lexeme == "null") {
+				value->reset(); // a duplicate key replaces the previous value
+			}
+			else {
+				*value = lexeme;
+				if (!useMemory(getStringMemory(lexeme.size()), source)) {
+					return false;
+				}
 			}
 			break;
 		}
 		case Token::ArrayBegin:
-			return parseArray(source, value);
 		case Token::ObjectBegin:
-			return parseObject(source, value);
+			if (!parseContainer(token, source, value)) {
+				return false;
+			}
+			break;
+		default:
+			putError("value was expected", source);
+			return false;
+	}
+	// a streamed string is not kept in the text as a whole
+	if (raw_text && token != Token::StreamedString) {
+		raw_text->add(*value, begin, source.getPosition().offset + source.getLexemeSize() - begin);
+	}
+	return true;
+}
+
+bool Reader::validateValue(Token token, Source& source)
+{
+	switch (token) {
+		case Token::String: {
+			const auto& lexeme = source.getLexeme();
+			if (taping) {
+				// the string is unescaped straight into the buffer of the tape
+				const auto offset = taping->strings.size();
+				unescapeText(lexeme.data() + 1, lexeme.data() + lexeme.size() - 1, taping->strings);
+				return useMemory(getStringMemory(taping->addString(offset)), source);
+			}
+			return useMemory(getStringMemory(source.getLexemeSize() - 2), source);
+		}
+		case Token::Integer:
+		case Token::Hex:
+		case Token::Real: {
+			if (!taping) {
+				// numbers are checked without converting them, but the same numbers are rejected as by parsing
+				const auto& lexeme = source.getLexeme();
+				if (!(token == Token::Real ? isRealInRange(lexeme) : isIntegerInRange(lexeme, token == Token::Hex))) {
+					putError("malformed number", source);
+					return false;
+				}
+				return true;
+			}
+			Value number;
+			if (!parseNumber(token, source, number)) {
+				return false;
+			}
+			if (number.isReal()) {
+				taping->addReal(number.asReal());
+			}
+			else {
+				taping->addInteger(number.asInteger());
+			}
+			return true;
+		}
+		case Token::Identifier: {
+			const auto& lexeme = source.getLexeme();
+			if (lexeme != "false" && lexeme != "true" && lexeme != "NaN" && lexeme != "Infinity" && lexeme != "null") {
+				if (taping) {
+					taping->addString(lexeme.data(), lexeme.size());
+				}
+				return useMemory(getStringMemory(lexeme.size()), source);
+			}
+			if (taping) {
+				if (lexeme == "null") {
+					taping->addNull();
+				}
+				else if (lexeme == "NaN" || lexeme == "Infinity") {
+					taping->addReal(strtod(lexeme.c_str(), nullptr));
+				}
+				else {
+					taping->addBool(lexeme == "true");
+				}
+			}
+			return true;
+		}
+		case Token::ArrayBegin:
+		case Token::ObjectBegin:
+			return parseContainer(token, source, nullptr);
 		default:
 			putError("value was expected", source);
 			return false;
 	}
+}
+
+bool Reader::parseNumber(Token token, Source& source, Value& value)
+{
+	try {
+		if (token == Token::Real) {
+			value = std::stod(source.getLexeme());
+		}
+		else {
+			const int base = (token == Token::Hex ? 16 : 10);
+			value = int64_t(std::stoll(source.getLexeme(), nullptr, base));
+		}
+	}
+	catch (const std::logic_error&) {
+		putError("malformed number", source);
+		return false;
+	}
+	return true;
+}
+
+bool Reader::parseContainer(Token token, Source& source, Value* value)
+{
+	if (usage.depth >= limits.depth) {
+		putError("maximum depth is exceeded", source, Error::Code::Limit);
+		return false;
+	}
+	if (!useMemory(token == Token::ArrayBegin ? sizeof(Value::Array) : sizeof(Value::Object), source)) {
+		return false;
+	}
+	// a span of the container is recorded within the span of its parent
+	auto parent = spans;
+	const auto parent_begin = spans_begin;
+	if (parent) {
+		parent->children.emplace_back();
+		spans = &parent->children.back();
+		spans_begin = source.getPosition().offset;
+		spans->begin = spans_begin - parent_begin;
+	}
+	// children of a container on a tape are added after its header which is completed once they are parsed
+	const auto header = taping ? taping->openContainer(token == Token::ArrayBegin ? Value::Type::Array : Value::Type::Object) : 0;
+	usage.depth++;
+	bool parsed = (token == Token::ArrayBegin) ? parseArray(source, value) : parseObject(source, value);
+	usage.depth--;
+	if (parsed && taping) {
+		taping->closeContainer(header);
+	}
+	if (parent) {
+		spans->size = source.getPosition().offset + source.getLexemeSize() - spans_begin;
+		spans = parent;
+		spans_begin = parent_begin;
+	}
+	return parsed;
+}
+
+bool Reader::streamString(Source& source, std::size_t& streamed)
+{
+	const auto& lexeme = source.getLexeme();
+	chunk.clear();
+	// the opening quote is a part of the first chunk only
+	unescapeText(lexeme.data() + (streamed == 0 ? 1 : 0), lexeme.data() + lexeme.size(), chunk);
+	streamed += lexeme.size();
+	if (!skipLexeme(source)) {
+		return false;
+	}
+	if (!chunk.empty()) {
+		options.string_sink->write(chunk.data(), chunk.size());
+	}
+	return true;
+}
+
+bool Reader::useMemory(std::size_t size, const Source& source)
+{
+	usage.memory += size;
+	if (usage.memory > limits.memory) {
+		putError("memory budget is exceeded", source, Error::Code::Limit);
+		return false;
+	}
 	return true;
 }
 
+bool Reader::prepareSource(Source& source)
+{
+	validating = false;
+	usage = Usage();
+	path.clear();
+	if (shapes.size() == max_shapes || !options.shape_caching) {
+		shapes.clear();
+	}
+	shapes.reserve(max_shapes);
+	string_paths.clear();
+	if (options.string_sink) {
+		for (const auto& string_path : options.string_paths) {
+			string_paths.push_back(Path(string_path).asString());
+		}
+	}
+	countdown = options.cancellation ? options.cancellation->getInterval() : 0;
+	limits = options.limits;
+	limits.bytes = limits.bytes ? limits.bytes : std::numeric_limits<uint64_t>::max();
+	limits.depth = limits.depth ? limits.depth : std::numeric_limits<uint32_t>::max();
+	limits.string_length = limits.string_length ? limits.string_length : std::numeric_limits<uint64_t>::max();
+	limits.elements = limits.elements ? limits.elements : std::numeric_limits<uint64_t>::max();
+	limits.values = limits.values ? limits.values : std::numeric_limits<uint64_t>::max();
+	limits.memory = limits.memory ? limits.memory : std::numeric_limits<uint64_t>::max();
+
+	const char* text = nullptr;
+	std::size_t size = 0;
+	bool buffered = (options.utf8 || options.limits.bytes) && source.getBuffer(text, size);
+	if (buffered && size > limits.bytes) {
+		// a text in memory is rejected before parsing
+		putError("maximum size of the text is exceeded", source, Error::Code::Limit);
+		return false;
+	}
+	if (options.utf8) {
+		if (buffered) {
+			// a text in memory is checked as a whole before parsing
+			auto offset = Utf8Validator::validate(text, size);
+			if (offset != Utf8Validator::npos) {
+				putEncodingError(source, text, offset);
+				return false;
+			}
+		}
+		else {
+			validator = Utf8Validator();
+			validating = true;
+		}
+	}
+	return true;
+}
+
+void Reader::finishSource(Source& source)
+{
+	if (source.getPosition().offset + source.getLexemeSize() > limits.bytes) {
+		putError("maximum size of the text is exceeded", source, Error::Code::Limit);
+	}
+	else if (options.strictly && nextToken(source) != Token::End) {
+		putError("expected end of file", source);
+	}
+	else if (validating) {
+		skipLexeme(source, true);
+	}
+}
+
+std::size_t Reader::openContainer()
+{
+	switch (sizing) {
+		case Sizing::Replaying:
+			return next_size < sizes.size() ? next_size++ : sizes.size();
+		default:
+			return 0;
+	}
+}
+
+void Reader::measureSource(Source& source)
+{
+	const char* text = nullptr;
+	std::size_t size = 0;
+	if (!source.getBuffer(text, size)) {
+		return; // a source which is not kept in memory can not be read twice
+	}
+	// the first pass only counts elements between brackets and commas, skipping strings and comments,
+	// and leaves checking the text to the second one, so sizes of a malformed text may be wrong
+	std::vector<std::size_t> slots;
+	const std::size_t unknown = std::numeric_limits<std::size_t>::max();
+	const auto depth = options.limits.depth ? options.limits.depth : std::numeric_limits<uint32_t>::max();
+	const char* const end = text + size;
+	const char* letter = text;
+	// an element begins with anything but a space, a comment or a closing bracket after an opening bracket or a comma
+	bool beginning = false;
+	while (letter != end) {
+		const char character = *letter++;
+		switch (character) {
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+				continue;
+			case '/':
+				if (letter != end && *letter == '/') {
+					letter = std::find(letter, end, '\n');
+					continue;
+				}
+				if (letter != end && *letter == '*') {
+					const char closing[] = "*/";
+					letter = std::search(letter + 1, end, closing, closing + 2);
+					letter = (letter == end) ? end : letter + 2;
+					continue;
+				}
+				break;
+			case char(0xEF):
+			case char(0xE2):
+				// the byte order mark and separators of lines and paragraphs are spaces
+				if (end - letter > 1 && ((character == char(0xEF) && letter[0] == char(0xBB) && letter[1] == char(0xBF)) ||
+					(character == char(0xE2) && letter[0] == char(0x80) && (letter[1] == char(0xA8) || letter[1] == char(0xA9))))) {
+					letter += 2;
+					continue;
+				}
+				break;
+			default:
+				break;
+		}
+		if (slots.empty() && character != '[' && character != '{') {
+			break;
+		}
+		if (beginning && character != ']' && character != '}') {
+			// slots are taken in the order of the first elements as they are by parsing
+			if (slots.back() == unknown) {
+				slots.back() = sizes.size();
+				sizes.push_back(0);
+			}
+			sizes[slots.back()]++;
+		}
+		beginning = false;
+		if (character == '[' || character == '{') {
+			if (slots.size() == depth) {
+				break;
+			}
+			slots.push_back(unknown);
+			beginning = true;
+		}
+		else if (character == ']' || character == '}') {
+			slots.pop_back();
+			if (slots.empty()) {
+				break;
+			}
+		}
+		else if (character == ',') {
+			beginning = true;
+		}
+		else if (character == '"' || character == '\'') {
+			while (letter != end && *letter != character) {
+				letter += (*letter == '\\' && end - letter > 1) ? 2 : 1;
+			}
+			if (letter == end) {
+				break;
+			}
+			letter++;
+		}
+	}
+	sizing = Sizing::Replaying;
+	next_size = 0;
+}
+
+void Reader::read(Source& source, Value* value)
+{
+	MemoryResource::Scope scope(options.memory_resource);
+	errors.clear();
+	sizes.clear();
+	sizing = Sizing::None;
+	try {
+		if (value && options.exact_sizing) {
+			measureSource(source);
+		}
+		if (prepareSource(source) && parseValue(nextToken(source, value != nullptr), source, value)) {
+			finishSource(source);
+		}
+	}
+	catch (const Error& error) {
+		if (!errors.empty()) {
+			throw; // it has been already reported
+		}
+		// the source has failed to provide the text
+		putError(error.what(), source, error.code());
+	}
+}
+
 Reader& Reader::parse(Source& source)
 {
-	root.reset();
+	if (!tape) {
+		root.reset();
+		read(source, &root);
+		return *this;
+	}
+	// the text is parsed as it is validated, adding values to the tape on the way
+	tape->clear();
+	taping = tape;
+	try {
+		read(source, nullptr);
+	}
+	catch (...) {
+		taping = nullptr;
+		tape->clear();
+		throw;
+	}
+	taping = nullptr;
+	if (hasErrors()) {
+		tape->clear();
+	}
+	return *this;
+}
+
+bool Reader::rejectTape()
+{
+	if (!tape) {
+		return false;
+	}
 	errors.clear();
-	if (parseValue(nextToken(source), source, root)) {
-		if (options.strictly && nextToken(source) != Token::End) {
-			putError("expected end of file", source);
+	putError("the text can not be parsed into a tape in this way");
+	return true;
+}
+
+Reader& Reader::parse(const std::string& text, SourceMap& map)
+{
+	map.clear();
+	if (rejectTape()) {
+		return *this;
+	}
+	IterableSource<const char*> source(text.data(), text.data() + text.size());
+	spans = &map.root;
+	spans_begin = 0;
+	try {
+		parse(source);
+	}
+	catch (const Error&) {
+		spans = nullptr;
+		map.clear();
+		throw;
+	}
+	spans = nullptr;
+	if (hasErrors()) {
+		map.clear();
+	}
+	return *this;
+}
+
+bool Reader::reparseSpan(const std::string& text, std::size_t begin, std::size_t size, uint32_t depth, SourceMap::Span& span, Value* target)
+{
+	IterableSource<const char*> source(text.data() + begin, text.data() + begin + size);
+	SourceMap::Span holder;
+	Value value;
+	errors.clear();
+	sizing = Sizing::None;
+	spans = &holder;
+	spans_begin = 0;
+	// a failure is not reported, the enclosing container is tried instead
+	const auto no_throws = options.no_throws;
+	options.no_throws = true;
+	bool parsed = prepareSource(source);
+	if (parsed) {
+		usage.depth = depth;
+		parsed = parseValue(nextToken(source), source, &value);
+	}
+	options.no_throws = no_throws;
+	spans = nullptr;
+	// the container has to take exactly the whole span, so the rest of the text is parsed as before
+	if (!parsed || holder.children.size() != 1 || holder.children.front().begin != 0 || holder.children.front().size != size) {
+		errors.clear();
+		return false;
+	}
+	span.size = size;
+	span.children = std::move(holder.children.front().children);
+	if (target) {
+		*target = std::move(value);
+	}
+	return true;
+}
+
+Reader& Reader::reparse(std::string& text, const std::vector<SourceMap::Edit>& edits, SourceMap& map)
+{
+	if (rejectTape()) {
+		return *this;
+	}
+	MemoryResource::Scope scope(options.memory_resource);
+	for (const auto& edit : edits) {
+		if (edit.offset > text.size() || edit.removed > text.size() - edit.offset) {
+			errors.clear();
+			putError("edit is out of range");
+			return *this;
+		}
+		// containers which enclose the edit from the root one with their offsets from the beginning of the text
+		std::vector<std::pair<SourceMap::Span*, std::size_t>> path;
+		auto span = &map.root;
+		std::size_t begin = 0;
+		for (;;) {
+			auto& children = span->children;
+			auto child = std::upper_bound(children.begin(), children.end(), edit.offset - begin,
+				[](std::size_t offset, const SourceMap::Span& span) { return offset < span.begin; });
+			if (child == children.begin()) {
+				break;
+			}
+			--child;
+			const auto child_begin = begin + child->begin;
+			// brackets of the container must stay untouched
+			if (edit.offset <= child_begin || edit.offset + edit.removed >= child_begin + child->size) {
+				break;
+			}
+			span = &*child;
+			begin = child_begin;
+			path.emplace_back(span, begin);
+		}
+		text.replace(edit.offset, edit.removed, edit.inserted);
+		const auto delta = std::ptrdiff_t(edit.inserted.size()) - std::ptrdiff_t(edit.removed);
+
+		auto level = path.size();
+		for (; level > 0; level--) {
+			// a value of the container is replaced only if it has not been replaced by a duplicate key
+			Value* target = &root;
+			for (std::size_t index = 1; index < level && target; index++) {
+				const auto& step = *path[index].first;
+				if (!step.live) {
+					target = nullptr;
+				}
+				else if (target->isArray()) {
+					target = &(*target)[Value::Index(step.index)];
+				}
+				else {
+					target = &(*target)[step.key];
+				}
+			}
+			auto& edited = *path[level - 1].first;
+			if (target && !edited.live) {
+				target = nullptr;
+			}
+			if (reparseSpan(text, path[level - 1].second, edited.size + delta, uint32_t(level - 1), edited, target)) {
+				break;
+			}
+		}
+		if (level == 0) {
+			parse(text, map);
+			if (hasErrors()) {
+				return *this;
+			}
+			continue;
+		}
+		// the containers after the edited one are moved
+		for (std::size_t index = 0; index + 1 < level; index++) {
+			auto parent = path[index].first;
+			auto child = path[index + 1].first;
+			parent->size += delta;
+			for (auto sibling = child + 1; sibling != parent->children.data() + parent->children.size(); ++sibling) {
+				sibling->begin += delta;
+			}
 		}
 	}
 	return *this;
 }
 
+Reader& Reader::validate(Source& source)
+{
+	// nothing is built from strings, so they are checked without keeping them
+	dropping_strings = true;
+	try {
+		read(source, nullptr);
+	}
+	catch (...) {
+		dropping_strings = false;
+		throw;
+	}
+	dropping_strings = false;
+	return *this;
+}
+
+Reader& Reader::validate(const char* text)
+{
+	CStringSource source(text);
+	return validate(source);
+}
+
+Reader& Reader::validate(const std::string& text)
+{
+	IterableSource<const char*> source(text.data(), text.data() + text.size());
+	return validate(source);
+}
+
+Reader& Reader::validate(std::istream& stream)
+{
+	StreamSource source(stream);
+	return validate(source);
+}
+
+Reader& Reader::validate(const Segment* segments, std::size_t count)
+{
+	SegmentedSource source(segments, count);
+	return validate(source);
+}
+
+void Reader::parseRecords(const MappedFile& file, const RecordIndex& index, uint64_t first, uint64_t count, bool array)
+{
+	MemoryResource::Scope scope(options.memory_resource);
+	if (rejectTape()) {
+		return;
+	}
+	root.reset(array ? Value::Type::Array : Value::Type::Null);
+	errors.clear();
+	sizing = Sizing::None;
+	if (first >= index.getRecords() || index.getRecords() - first < count) {
+		putError("record is out of range");
+		return;
+	}
+	// the source is limited to the records, so nothing else is read or validated
+	auto begin = index.locate(file.data(), file.size(), first);
+	auto end = index.locate(file.data(), file.size(), first + count);
+	IterableSource<const char*> source(file.data() + begin, file.data() + end);
+	if (!prepareSource(source)) {
+		return;
+	}
+	if (array) {
+		root.reserve(Value::Index(count));
+	}
+	for (uint64_t record = 0; record < count; record++) {
+		if (!parseValue(nextToken(source, true), source, array ? &root.addElement() : &root)) {
+			return;
+		}
+	}
+	finishSource(source);
+}
+
+Reader& Reader::parseRecord(const MappedFile& file, const RecordIndex& index, uint64_t record)
+{
+	parseRecords(file, index, record, 1, false);
+	return *this;
+}
+
+Reader& Reader::parseRecords(const MappedFile& file, const RecordIndex& index, uint64_t first, uint64_t count)
+{
+	parseRecords(file, index, first, count, true);
+	return *this;
+}
+
+Reader& Reader::parse(const char* text, std::size_t size, RawText& raw)
+{
+	raw.clear();
+	if (rejectTape()) {
+		return *this;
+	}
+	raw.text = text;
+	IterableSource<const char*> source(text, text + size);
+	raw_text = &raw;
+	try {
+		parse(source);
+	}
+	catch (const Error&) {
+		raw_text = nullptr;
+		raw.clear();
+		throw;
+	}
+	raw_text = nullptr;
+	if (hasErrors()) {
+		raw.clear();
+	}
+	return *this;
+}
+
+Reader& Reader::parse(const std::string& text, RawText& raw)
+{
+	return parse(text.data(), text.size(), raw);
+}
+
 Reader& Reader::parse(const char* text)
 {
 	CStringSource source(text);
@@ -467,7 +1722,7 @@ Reader& Reader::parse(const char* text)
 
 Reader& Reader::parse(const std::string& text)
 {
-	IterableSource<std::string::const_iterator> source(text.begin(), text.end());
+	IterableSource<const char*> source(text.data(), text.data() + text.size());
 	return parse(source);
 }
 
@@ -479,18 +1734,79 @@ Reader& Reader::parse(std::istream& stream)
 
 Reader& Reader::parse(std::FILE* file)
 {
-	FileSource source(file);
+	CFileSource source(file);
+	return parse(source);
+}
+
+Reader& Reader::parse(const Segment* segments, std::size_t count)
+{
+	SegmentedSource source(segments, count);
+	return parse(source);
+}
+
+Reader& Reader::parseFile(const std::string& path)
+{
+	std::unique_ptr<FileSource> file;
+	std::unique_ptr<BlockSource> decompressor;
+	try {
+		file.reset(new FileSource(path));
+		// the magic bytes are taken from the source itself, since a pipe can not be opened twice
+		char magic[4] = {};
+		switch (detectCompression(magic, file->peek(magic, sizeof(magic)))) {
+		case Compression::Gzip:
+			decompressor.reset(new GzipSource(*file));
+			break;
+		case Compression::Zstd:
+			decompressor.reset(new ZstdSource(*file));
+			break;
+		case Compression::None:
+			break;
+		}
+	}
+	catch (const Error& error) {
+		root.reset();
+		if (tape) {
+			tape->clear();
+		}
+		errors.clear();
+		putError(error.what());
+		return *this;
+	}
+	BlockSource& source = decompressor ? *decompressor : *file;
+	if (options.read_ahead) {
+		// the decompression is done by the background thread as well
+		ReadAheadSource ahead(source);
+		return parse(ahead);
+	}
 	return parse(source);
 }
 
-void Reader::putError(const std::string& reason, const Source& source)
+void Reader::putError(const std::string& reason, const Source& source, Error::Code code /*= Error::Code::Syntax*/)
 {
-	putError(reason, source.getPosition().line, source.getPosition().column);
+	const auto& position = source.getPosition();
+	putError(reason, position.line, position.column, int64_t(position.offset), code);
+}
+
+void Reader::putEncodingError(const Source& source, const char* text, std::size_t size)
+{
+	// locates a malformed sequence placed after the given text
+	auto position = source.getPosition();
+	for (std::size_t index = 0; index < size; index++) {
+		position.column++;
+		if (text[index] == '\n') {
+			position.column = 1;
+			position.line++;
+		}
+	}
+	putError("malformed UTF-8 sequence", position.line, position.column, int64_t(position.offset + size), Error::Code::Encoding);
 }
 
-void Reader::putError(const std::string& reason, int line, int column)
+void Reader::putError(const std::string& reason, int line, int column, int64_t offset, Error::Code code)
 {
-	errors.push_back(Error(reason, line, column));
+	if (!errors.empty()) {
+		return; // keep the original error instead of its consequences
+	}
+	errors.push_back(Error(reason, line, column, offset, code));
 	if (!options.no_throws) {
 		throw errors.back();
 	}
@@ -541,15 +1857,18 @@ std::string Reader::unescapeString(const std::string& string)
 {
 	std::string unescaped;
 	unescaped.reserve(string.length());
+	unescapeText(string.data() + 1, string.data() + string.length() - 1, unescaped);
+	return unescaped;
+}
+
+void Reader::unescapeText(const char* begin, const char* end, std::string& unescaped)
+{
 	std::string unicode;
 
 	enum class State {
 		Regular, Escaped, Unicode
 	} state = State::Regular;
 
-	auto begin = std::next(string.begin());
-	auto end = std::prev(string.end());
-
 	for (auto letter = begin; letter != end; letter++) {
 		switch (state) {
 			case State::Regular:
@@ -591,7 +1910,6 @@ std::string Reader::unescapeString(const std::string& string)
 				break;
 		}
 	}
-	return unescaped;
 }
 
 Value parse(const std::string& text)
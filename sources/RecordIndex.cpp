@@ -0,0 +1,206 @@
+#include <az/json/RecordIndex.h>
+#include <az/json/Error.h>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <thread>
+
+namespace az {
+namespace json {
+
+namespace {
+
+const char signature[4] = {'A', 'Z', 'J', 'I'};
+
+// a smallest piece of the text worth scanning in a separate thread
+const std::size_t minimum_chunk = 1 << 20;
+
+bool isBlank(const char* begin, const char* end)
+{
+	return std::all_of(begin, end, [](char letter) {
+		return isspace(static_cast<unsigned char>(letter)) != 0;
+	});
+}
+
+std::size_t findLineEnd(const char* text, std::size_t size, std::size_t offset)
+{
+	auto found = static_cast<const char*>(memchr(text + offset, '\n', size - offset));
+	return found ? std::size_t(found - text) : size;
+}
+
+template<class T>
+void writeField(std::ostream& stream, const T& field)
+{
+	stream.write(reinterpret_cast<const char*>(&field), sizeof(field));
+}
+
+template<class T>
+void readField(std::istream& stream, T& field)
+{
+	stream.read(reinterpret_cast<char*>(&field), sizeof(field));
+}
+
+} /* namespace */
+
+const uint32_t RecordIndex::version;
+
+RecordIndex RecordIndex::build(const char* text, std::size_t size, const Options& options /*= {}*/)
+{
+	RecordIndex index;
+	index.file_size = size;
+	index.sampling = std::max<uint32_t>(options.sampling, 1);
+
+	std::size_t threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+	threads = std::max<std::size_t>(1, std::min(threads, size / minimum_chunk + 1));
+
+	// every thread collects the records which start inside its own piece of the text
+	std::vector<std::vector<uint64_t>> chunks(threads);
+	auto scan = [&](std::size_t chunk) {
+		std::size_t begin = size * chunk / threads;
+		std::size_t end = size * (chunk + 1) / threads;
+		if (begin > 0) {
+			begin = findLineEnd(text, size, begin - 1) + 1;
+		}
+		while (begin < end) {
+			auto line_end = findLineEnd(text, size, begin);
+			if (!isBlank(text + begin, text + line_end)) {
+				chunks[chunk].push_back(begin);
+			}
+			begin = line_end + 1;
+		}
+	};
+	std::vector<std::thread> workers;
+	for (std::size_t chunk = 1; chunk < threads; chunk++) {
+		workers.emplace_back(scan, chunk);
+	}
+	scan(0);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	for (const auto& chunk : chunks) {
+		for (auto offset : chunk) {
+			if (index.records % index.sampling == 0) {
+				index.offsets.push_back(offset);
+			}
+			index.records++;
+		}
+	}
+	return index;
+}
+
+RecordIndex RecordIndex::build(const MappedFile& file, const Options& options /*= {}*/)
+{
+	auto index = build(file.data(), file.size(), options);
+	index.file_time = file.getModificationTime();
+	return index;
+}
+
+void RecordIndex::save(const std::string& path) const
+{
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	stream.write(signature, sizeof(signature));
+	writeField(stream, version);
+	writeField(stream, file_size);
+	writeField(stream, file_time);
+	writeField(stream, sampling);
+	writeField(stream, records);
+	uint64_t count = offsets.size();
+	writeField(stream, count);
+	stream.write(reinterpret_cast<const char*>(offsets.data()), std::streamsize(count * sizeof(uint64_t)));
+	if (!stream) {
+		throw Error("unable to save index into " + path);
+	}
+}
+
+RecordIndex RecordIndex::load(const std::string& path, const MappedFile& file)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream) {
+		throw Error("unable to open index " + path);
+	}
+	char file_signature[sizeof(signature)] = {};
+	uint32_t file_version = 0;
+	stream.read(file_signature, sizeof(file_signature));
+	readField(stream, file_version);
+	if (!stream || memcmp(file_signature, signature, sizeof(signature)) != 0) {
+		throw Error("invalid index " + path);
+	}
+	if (file_version != version) {
+		throw Error("unsupported version of index " + path);
+	}
+
+	RecordIndex index;
+	uint64_t count = 0;
+	readField(stream, index.file_size);
+	readField(stream, index.file_time);
+	readField(stream, index.sampling);
+	readField(stream, index.records);
+	readField(stream, count);
+	// every record takes at least one byte of the file
+	if (!stream || index.sampling == 0 || index.records > index.file_size ||
+		count != (index.records + index.sampling - 1) / index.sampling) {
+		throw Error("invalid index " + path);
+	}
+	if (index.file_size != file.size() || index.file_time != file.getModificationTime()) {
+		throw Error("index " + path + " is outdated for " + file.getPath());
+	}
+	// the offsets are not allocated before the index is known to hold all of them
+	const auto position = stream.tellg();
+	stream.seekg(0, std::ios::end);
+	const auto end = stream.tellg();
+	stream.seekg(position);
+	if (position < 0 || end < position || uint64_t(end - position) / sizeof(uint64_t) < count) {
+		throw Error("invalid index " + path);
+	}
+	index.offsets.resize(std::size_t(count));
+	stream.read(reinterpret_cast<char*>(index.offsets.data()), std::streamsize(count * sizeof(uint64_t)));
+	if (!stream) {
+		throw Error("invalid index " + path);
+	}
+	// records are located inside the file in the order of their offsets
+	for (std::size_t offset = 0; offset < index.offsets.size(); offset++) {
+		if (index.offsets[offset] >= file.size() || (offset > 0 && index.offsets[offset] <= index.offsets[offset - 1])) {
+			throw Error("invalid index " + path);
+		}
+	}
+	return index;
+}
+
+uint64_t RecordIndex::getRecords() const
+{
+	return records;
+}
+
+uint32_t RecordIndex::getSampling() const
+{
+	return sampling;
+}
+
+std::size_t RecordIndex::skipRecord(const char* text, std::size_t size, std::size_t offset)
+{
+	for (offset = findLineEnd(text, size, offset) + 1; offset < size; ) {
+		auto line_end = findLineEnd(text, size, offset);
+		if (!isBlank(text + offset, text + line_end)) {
+			return offset;
+		}
+		offset = line_end + 1;
+	}
+	return size;
+}
+
+std::size_t RecordIndex::locate(const char* text, std::size_t size, uint64_t record) const
+{
+	if (record >= records) {
+		return size;
+	}
+	std::size_t offset = std::size_t(offsets[record / sampling]);
+	for (auto skip = record % sampling; skip > 0; skip--) {
+		offset = skipRecord(text, size, offset);
+	}
+	return offset;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,447 @@
+#include <az/json/Tape.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace az {
+namespace json {
+
+namespace {
+
+int64_t getInteger(const uint64_t* entry)
+{
+	int64_t integer;
+	std::memcpy(&integer, entry + 1, sizeof(integer));
+	return integer;
+}
+
+double getReal(const uint64_t* entry)
+{
+	double real;
+	std::memcpy(&real, entry + 1, sizeof(real));
+	return real;
+}
+
+} /* namespace */
+
+void Tape::clear()
+{
+	entries.clear();
+	strings.clear();
+}
+
+Tape::View Tape::getRoot() const
+{
+	return entries.empty() ? View() : View(entries.data(), strings.data());
+}
+
+std::size_t Tape::getMemory() const
+{
+	return entries.capacity() * sizeof(uint64_t) + strings.capacity();
+}
+
+void Tape::addNull()
+{
+	entries.push_back(makeEntry(Value::Type::Null, 0));
+}
+
+void Tape::addBool(bool value)
+{
+	entries.push_back(makeEntry(Value::Type::Bool, value ? 1 : 0));
+}
+
+void Tape::addInteger(int64_t value)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	entries.push_back(makeEntry(Value::Type::Integer, 0));
+	entries.push_back(bits);
+}
+
+void Tape::addReal(double value)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	entries.push_back(makeEntry(Value::Type::Real, 0));
+	entries.push_back(bits);
+}
+
+std::size_t Tape::addString(std::size_t offset)
+{
+	const auto size = strings.size() - offset;
+	// a zero after every string lets them be read as C strings
+	strings.push_back('\0');
+	entries.push_back(makeEntry(Value::Type::String, offset));
+	entries.push_back(size);
+	return size;
+}
+
+std::size_t Tape::addString(const char* data, std::size_t size)
+{
+	const auto offset = strings.size();
+	strings.append(data, size);
+	return addString(offset);
+}
+
+std::size_t Tape::openContainer(Value::Type type)
+{
+	const auto header = entries.size();
+	entries.push_back(makeEntry(type, 0));
+	entries.resize(header + (type == Value::Type::Array ? array_header : object_header));
+	return header;
+}
+
+void Tape::closeContainer(std::size_t header)
+{
+	const auto end = entries.size();
+	const bool object = Value::Type(entries[header] >> type_shift) == Value::Type::Object;
+	const auto first = header + (object ? object_header : array_header);
+	if (object) {
+		entries[header + 1] = mergeMembers(header);
+	}
+	else {
+		// children are counted by skipping them
+		uint64_t children = 0;
+		for (auto entry = first; entry != end; entry = std::size_t(getNext(&entries[entry]) - entries.data())) {
+			children++;
+		}
+		entries[header + 1] = children;
+		entries[header + 2] = end - header;
+		// the positions are collected by another pass, since the entries move as they grow
+		if (children > index_stride) {
+			entries.reserve(end + (children + index_stride - 1) / index_stride);
+			auto entry = first;
+			for (uint64_t element = 0; element < children; element++) {
+				if (element % index_stride == 0) {
+					entries.push_back(entry - header);
+				}
+				entry = std::size_t(getNext(&entries[entry]) - entries.data());
+			}
+		}
+	}
+	entries[header] |= uint64_t(entries.size() - header);
+}
+
+uint64_t Tape::mergeMembers(std::size_t header)
+{
+	members.clear();
+	for (auto entry = header + object_header; entry != entries.size(); entry = std::size_t(getNext(&entries[entry + 2]) - entries.data())) {
+		members.push_back(entry);
+	}
+	// small objects are checked pair by pair, since repeated keys are rare
+	if (members.size() <= index_stride) {
+		bool repeated = false;
+		for (std::size_t member = 1; member < members.size() && !repeated; member++) {
+			for (std::size_t previous = 0; previous < member && !repeated; previous++) {
+				repeated = isSameKey(members[previous], members[member]);
+			}
+		}
+		if (!repeated) {
+			return members.size();
+		}
+	}
+
+	// members of the same key follow each other in the order of the text once they are sorted by keys
+	order.resize(members.size());
+	for (std::size_t member = 0; member < order.size(); member++) {
+		order[member] = member;
+	}
+	std::sort(order.begin(), order.end(), [this](std::size_t left, std::size_t right) {
+		const auto left_key = &entries[members[left]];
+		const auto right_key = &entries[members[right]];
+		if (left_key[1] != right_key[1]) {
+			return left_key[1] < right_key[1];
+		}
+		const auto compared = std::memcmp(strings.data() + (*left_key & payload_mask), strings.data() + (*right_key & payload_mask), std::size_t(left_key[1]));
+		return compared != 0 ? compared < 0 : left < right;
+	});
+	// the first member of a key takes the value of the last one, the others are dropped
+	std::vector<std::size_t> values(members.size(), members.size());
+	bool repeated = false;
+	for (std::size_t begin = 0, end; begin < order.size(); begin = end) {
+		for (end = begin + 1; end < order.size() && isSameKey(members[order[begin]], members[order[end]]); end++) {
+			repeated = true;
+		}
+		values[order[begin]] = order[end - 1];
+	}
+	if (!repeated) {
+		return members.size();
+	}
+
+	// the values are moved around, so the members are put together in another buffer
+	merged.clear();
+	for (std::size_t member = 0; member < members.size(); member++) {
+		if (values[member] == members.size()) {
+			continue;
+		}
+		const auto key = entries.begin() + std::ptrdiff_t(members[member]);
+		const uint64_t* value = entries.data() + members[values[member]] + 2;
+		merged.insert(merged.end(), key, key + 2);
+		merged.insert(merged.end(), value, getNext(value));
+	}
+	entries.resize(header + object_header);
+	entries.insert(entries.end(), merged.begin(), merged.end());
+	return uint64_t(std::count_if(values.begin(), values.end(), [this](std::size_t value) {
+		return value != members.size();
+	}));
+}
+
+bool Tape::isSameKey(std::size_t left, std::size_t right) const
+{
+	return entries[left + 1] == entries[right + 1] &&
+		std::memcmp(strings.data() + (entries[left] & payload_mask), strings.data() + (entries[right] & payload_mask), std::size_t(entries[left + 1])) == 0;
+}
+
+const char* Tape::View::getTypeString() const
+{
+	return Value::getTypeString(getType());
+}
+
+bool Tape::View::empty() const
+{
+	switch (getType()) {
+		case Value::Type::String:
+		case Value::Type::Array:
+		case Value::Type::Object:
+			return entry[1] == 0;
+		default:
+			return isNull();
+	}
+}
+
+uint32_t Tape::View::size() const
+{
+	switch (getType()) {
+		case Value::Type::Bool:
+			return sizeof(bool);
+		case Value::Type::Integer:
+			return sizeof(int64_t);
+		case Value::Type::Real:
+			return sizeof(double);
+		case Value::Type::String:
+		case Value::Type::Array:
+		case Value::Type::Object:
+			return uint32_t(entry[1]);
+		default:
+			return 0;
+	}
+}
+
+bool Tape::View::isNegative() const
+{
+	switch (getType()) {
+		case Value::Type::Real:
+			return std::signbit(getReal(entry));
+		case Value::Type::Integer:
+			return getInteger(entry) < 0;
+		default:
+			return false;
+	}
+}
+
+bool Tape::View::asBool() const
+{
+	switch (getType()) {
+		case Value::Type::Bool:
+			return getPayload() != 0;
+		case Value::Type::Integer:
+			return getInteger(entry) != 0;
+		case Value::Type::Real: {
+			const auto real = getReal(entry);
+			return !(std::isnan(real) || real == 0);
+		}
+		case Value::Type::String:
+			if (!empty()) {
+				auto compare = [](char left, char right) {
+					return std::tolower(left) == right;
+				};
+				const auto data = getStringData();
+				return !std::equal(data, data + getStringSize(), std::begin("false"), compare);
+			}
+			return false;
+		default:
+			return false;
+	}
+}
+
+int64_t Tape::View::asInteger() const
+{
+	switch (getType()) {
+		case Value::Type::Bool:
+			return int64_t(getPayload());
+		case Value::Type::Integer:
+			return getInteger(entry);
+		case Value::Type::Real:
+			return int64_t(getReal(entry));
+		case Value::Type::String:
+			return std::strtoll(getStringData(), nullptr, 10);
+		default:
+			return 0;
+	}
+}
+
+double Tape::View::asReal() const
+{
+	switch (getType()) {
+		case Value::Type::Bool:
+			return double(getPayload());
+		case Value::Type::Integer:
+			return double(getInteger(entry));
+		case Value::Type::Real:
+			return getReal(entry);
+		case Value::Type::String:
+			return std::strtod(getStringData(), nullptr);
+		default:
+			return 0;
+	}
+}
+
+std::string Tape::View::asString() const
+{
+	switch (getType()) {
+		case Value::Type::String:
+			return std::string(getStringData(), getStringSize());
+		case Value::Type::Array:
+		case Value::Type::Object:
+			return {};
+		default:
+			// scalars are written in the same way as values do
+			return toValue().asString();
+	}
+}
+
+const char* Tape::View::getStringData() const
+{
+	return isString() ? strings + getPayload() : nullptr;
+}
+
+std::size_t Tape::View::getStringSize() const
+{
+	return isString() ? std::size_t(entry[1]) : 0;
+}
+
+Tape::View Tape::View::find(const char* key, std::size_t size) const
+{
+	if (!isObject()) {
+		return {};
+	}
+	const auto end = entry + getPayload();
+	for (auto member = entry + object_header; member != end; ) {
+		const auto value = member + 2;
+		if (member[1] == size && std::memcmp(strings + (*member & payload_mask), key, size) == 0) {
+			return View(value, strings);
+		}
+		member = getNext(value);
+	}
+	return {};
+}
+
+Tape::View Tape::View::find(const char* key) const
+{
+	return find(key, std::strlen(key));
+}
+
+Tape::View Tape::View::find(const std::string& key) const
+{
+	return find(key.data(), key.size());
+}
+
+Tape::View Tape::View::find(Value::Index index) const
+{
+	if (!isArray() || index >= entry[1]) {
+		return {};
+	}
+	auto element = entry + array_header;
+	if (entry[1] > index_stride) {
+		const auto positions = entry + entry[2];
+		element = entry + positions[index / index_stride];
+	}
+	for (auto skipped = index % index_stride; skipped > 0; skipped--) {
+		element = getNext(element);
+	}
+	return View(element, strings);
+}
+
+Tape::View Tape::View::find(int index) const
+{
+	return find(Value::Index(index));
+}
+
+bool Tape::View::has(const char* key) const
+{
+	return bool(find(key));
+}
+
+bool Tape::View::has(const std::string& key) const
+{
+	return bool(find(key));
+}
+
+bool Tape::View::has(Value::Index index) const
+{
+	return isArray() && index < entry[1];
+}
+
+bool Tape::View::has(int index) const
+{
+	return has(Value::Index(index));
+}
+
+Value Tape::View::toValue() const
+{
+	switch (getType()) {
+		case Value::Type::Bool:
+			return asBool();
+		case Value::Type::Integer:
+			return getInteger(entry);
+		case Value::Type::Real:
+			return getReal(entry);
+		case Value::Type::String:
+			return std::string(getStringData(), getStringSize());
+		case Value::Type::Array: {
+			Value array(Value::Type::Array);
+			array.reserve(Value::Index(size()));
+			for (auto element : *this) {
+				array.append(element.toValue());
+			}
+			return array;
+		}
+		case Value::Type::Object: {
+			Value object(Value::Type::Object);
+			object.reserve(Value::Index(size()));
+			for (auto member = begin(); member != end(); ++member) {
+				object[member.key()] = member.value().toValue();
+			}
+			return object;
+		}
+		default:
+			return nullptr;
+	}
+}
+
+Tape::Iterator Tape::View::begin() const
+{
+	if (isArray()) {
+		return Iterator(entry + array_header, strings, false);
+	}
+	if (isObject()) {
+		return Iterator(entry + object_header, strings, true);
+	}
+	return {};
+}
+
+Tape::Iterator Tape::View::end() const
+{
+	if (isArray()) {
+		return Iterator(entry + entry[2], strings, false);
+	}
+	if (isObject()) {
+		return Iterator(entry + getPayload(), strings, true);
+	}
+	return {};
+}
+
+} /* namespace json */
+} /* namespace az */
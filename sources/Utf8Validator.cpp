@@ -0,0 +1,323 @@
+#include <az/json/Utf8Validator.h>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AZ_JSON_UTF8_SSE2
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define AZ_JSON_UTF8_SSSE3
+#endif
+
+namespace az {
+namespace json {
+
+namespace {
+
+// checks whether the next 16 bytes are all ASCII characters
+inline bool isAsciiBlock(const uint8_t* text)
+{
+#ifdef AZ_JSON_UTF8_SSE2
+	return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text))) == 0;
+#else
+	uint64_t words[2];
+	memcpy(words, text, sizeof(words));
+	return ((words[0] | words[1]) & 0x8080808080808080ull) == 0;
+#endif
+}
+
+// finds the beginning of a sequence which may cross the given position
+std::size_t findSequenceBoundary(const uint8_t* text, std::size_t position)
+{
+	std::size_t boundary = position;
+	while (boundary > 0 && position - boundary < 3 && (text[boundary - 1] & 0xC0) == 0x80) {
+		boundary--;
+	}
+	if (boundary > 0 && text[boundary - 1] >= 0xC0) {
+		boundary--;
+	}
+	return boundary;
+}
+
+#ifdef AZ_JSON_UTF8_SSSE3
+
+// based on "Validating UTF-8 In Less Than One Instruction Per Byte" by John Keiser and Daniel Lemire
+
+const uint8_t TOO_SHORT = 1 << 0; // 11______ 0_______
+const uint8_t TOO_LONG = 1 << 1; // 0_______ 10______
+const uint8_t OVERLONG_3 = 1 << 2; // 11100000 100_____
+const uint8_t TOO_LARGE = 1 << 3; // 11110100 1001____
+const uint8_t SURROGATE = 1 << 4; // 11101101 101_____
+const uint8_t OVERLONG_2 = 1 << 5; // 1100000_ 10______
+const uint8_t TOO_LARGE_1000 = 1 << 6; // 11110101 1000____
+const uint8_t OVERLONG_4 = 1 << 6; // 11110000 1000____
+const uint8_t TWO_CONTS = 1 << 7; // 10______ 10______
+const uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+__attribute__((target("ssse3")))
+inline __m128i checkBlock(__m128i input, __m128i previous)
+{
+	const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+	const __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+	const __m128i byte_1_high = _mm_shuffle_epi8(_mm_setr_epi8(
+		// 0_______ ________ <ASCII in byte 1>
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		// 10______ ________ <continuation in byte 1>
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+		// 1100____ ________ <two byte lead in byte 1>
+		TOO_SHORT | OVERLONG_2,
+		// 1101____ ________ <two byte lead in byte 1>
+		TOO_SHORT,
+		// 1110____ ________ <three byte lead in byte 1>
+		TOO_SHORT | OVERLONG_3 | SURROGATE,
+		// 1111____ ________ <four+ byte lead in byte 1>
+		char(TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4)
+	), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble_mask));
+	const __m128i byte_1_low = _mm_shuffle_epi8(_mm_setr_epi8(
+		// ____0000 ________
+		char(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+		// ____0001 ________
+		char(CARRY | OVERLONG_2),
+		// ____001_ ________
+		char(CARRY), char(CARRY),
+		// ____0100 ________
+		char(CARRY | TOO_LARGE),
+		// ____0101 ________
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		// ____011_ ________
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000), char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		// ____1___ ________
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000), char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000), char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		// ____1101 ________
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+		char(CARRY | TOO_LARGE | TOO_LARGE_1000), char(CARRY | TOO_LARGE | TOO_LARGE_1000)
+	), _mm_and_si128(prev1, nibble_mask));
+	const __m128i byte_2_high = _mm_shuffle_epi8(_mm_setr_epi8(
+		// ________ 0_______ <ASCII in byte 2>
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		// ________ 1000____
+		char(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+		// ________ 1001____
+		char(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+		// ________ 101_____
+		char(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+		char(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+		// ________ 11______
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+	), _mm_and_si128(_mm_srli_epi16(input, 4), nibble_mask));
+	const __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+	// the third and the fourth bytes of long sequences must be continuations
+	const __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+	const __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+	const __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xE0 - 0x80)));
+	const __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xF0 - 0x80)));
+	const __m128i must_be_continuation = _mm_and_si128(
+		_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(char(0x80)));
+	return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+__attribute__((target("ssse3")))
+inline __m128i checkIncomplete(__m128i input)
+{
+	// the last three bytes must not start a sequence that is longer than the rest of the block
+	const __m128i max_value = _mm_setr_epi8(
+		-1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+	return _mm_subs_epu8(input, max_value);
+}
+
+// returns an offset of the first block where an error is found or the end of the full blocks
+__attribute__((target("ssse3")))
+std::size_t findMalformedBlock(const uint8_t* text, std::size_t size)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i previous = zero;
+	__m128i incomplete = zero;
+	std::size_t position = 0;
+	for (; position + 16 <= size; position += 16) {
+		__m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+		__m128i error;
+		if (_mm_movemask_epi8(input) == 0) {
+			error = incomplete;
+			incomplete = zero;
+		}
+		else {
+			error = checkBlock(input, previous);
+			incomplete = checkIncomplete(input);
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF) {
+			break;
+		}
+		previous = input;
+	}
+	return position;
+}
+
+#endif
+
+} /* namespace */
+
+const std::size_t Utf8Validator::npos;
+
+int Utf8Validator::getSequenceLength(const uint8_t* sequence, std::size_t available)
+{
+	// based on the table of well-formed byte sequences of RFC 3629
+
+	const uint8_t lead = sequence[0];
+	if (lead < 0x80) {
+		return 1;
+	}
+	int length = 0;
+	uint8_t lower = 0x80, upper = 0xBF;
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		length = 2;
+	}
+	else if (lead >= 0xE0 && lead <= 0xEF) {
+		length = 3;
+		if (lead == 0xE0) {
+			lower = 0xA0; // overlong
+		}
+		else if (lead == 0xED) {
+			upper = 0x9F; // surrogate
+		}
+	}
+	else if (lead >= 0xF0 && lead <= 0xF4) {
+		length = 4;
+		if (lead == 0xF0) {
+			lower = 0x90; // overlong
+		}
+		else if (lead == 0xF4) {
+			upper = 0x8F; // greater than U+10FFFF
+		}
+	}
+	else {
+		return 0;
+	}
+	for (int index = 1; index < length; index++) {
+		if (std::size_t(index) >= available) {
+			return -1;
+		}
+		if (sequence[index] < lower || sequence[index] > upper) {
+			return 0;
+		}
+		lower = 0x80;
+		upper = 0xBF;
+	}
+	return length;
+}
+
+std::size_t Utf8Validator::validateScalar(const uint8_t* text, std::size_t size, std::size_t& incomplete)
+{
+	std::size_t position = 0;
+	while (position < size) {
+		if (position + 16 <= size && isAsciiBlock(text + position)) {
+			position += 16;
+			continue;
+		}
+		if (text[position] < 0x80) {
+			position++;
+			continue;
+		}
+		int length = getSequenceLength(text + position, size - position);
+		if (length == 0) {
+			return position;
+		}
+		if (length < 0) {
+			incomplete = position;
+			break;
+		}
+		position += length;
+	}
+	return npos;
+}
+
+std::size_t Utf8Validator::validateBlocks(const uint8_t* text, std::size_t size, std::size_t& incomplete)
+{
+	std::size_t position = 0;
+#ifdef AZ_JSON_UTF8_SSSE3
+	if (__builtin_cpu_supports("ssse3")) {
+		// the blocks before the found one are well-formed, so the rest is checked
+		// byte by byte to find an exact offset of an error or an unfinished sequence
+		position = findSequenceBoundary(text, findMalformedBlock(text, size));
+	}
+#endif
+	std::size_t malformed = validateScalar(text + position, size - position, incomplete);
+	if (incomplete != npos) {
+		incomplete += position;
+	}
+	return malformed != npos ? position + malformed : npos;
+}
+
+std::size_t Utf8Validator::validate(const char* text, std::size_t size)
+{
+	std::size_t incomplete = npos;
+	std::size_t malformed = validateBlocks(reinterpret_cast<const uint8_t*>(text), size, incomplete);
+	return malformed != npos ? malformed : incomplete;
+}
+
+bool Utf8Validator::feed(const char* text, std::size_t size)
+{
+	if (isMalformed()) {
+		return false;
+	}
+	auto data = reinterpret_cast<const uint8_t*>(text);
+	std::size_t position = 0;
+	if (pending_size > 0) {
+		// completes a sequence started at the end of the previous piece
+		const std::size_t start = offset - pending_size;
+		while (position < size && pending_size < sizeof(pending)) {
+			pending[pending_size++] = data[position++];
+			int length = getSequenceLength(pending, pending_size);
+			if (length == 0) {
+				malformed = start;
+				return false;
+			}
+			if (length > 0) {
+				pending_size = 0;
+				break;
+			}
+		}
+	}
+	if (pending_size == 0) {
+		std::size_t incomplete = npos;
+		std::size_t found = validateBlocks(data + position, size - position, incomplete);
+		if (found != npos) {
+			malformed = offset + position + found;
+			return false;
+		}
+		if (incomplete != npos) {
+			pending_size = uint8_t(size - position - incomplete);
+			memcpy(pending, data + position + incomplete, pending_size);
+		}
+	}
+	offset += size;
+	return true;
+}
+
+bool Utf8Validator::finish()
+{
+	if (!isMalformed() && pending_size > 0) {
+		malformed = offset - pending_size;
+	}
+	return !isMalformed();
+}
+
+bool Utf8Validator::isMalformed() const
+{
+	return malformed != npos;
+}
+
+std::size_t Utf8Validator::getOffset() const
+{
+	return malformed;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -1,692 +1,1050 @@
-#include <az/json/Value.h>
-#include <sstream>
-#include <iomanip>
-#include <cmath>
-#include <cstring>
-#include <limits>
-#include <algorithm>
-#include <az/json/Writer.h>
-#include <az/json/Reader.h>
-
-namespace az {
-namespace json {
-
-const Value Value::null;
-
-void Value::reset(Type type /*= Type::Null*/)
-{
-	switch (this->type) {
-		case Type::String:
-			delete any.string_;
-			break;
-		case Type::Array:
-			delete any.array_;
-			break;
-		case Type::Object:
-			delete any.object_;
-			break;
-		default:
-			break;
-	}
-	any = {};
-	this->type = Type::Null;
-
-	switch (type) {
-		case Type::String:
-			any.string_ = new String();
-			break;
-		case Type::Array:
-			any.array_ = new Array();
-			break;
-		case Type::Object:
-			any.object_ = new Object();
-			break;
-		default:
-			break;
-	}
-	this->type = type;
-}
-
-void Value::assign(bool val)
-{
-	reset(Type::Bool);
-	any.bool_ = val;
-}
-
-void Value::assign(int val)
-{
-	reset(Type::Integer);
-	any.integer_ = val;
-}
-
-void Value::assign(int64_t val)
-{
-	reset(Type::Integer);
-	any.integer_ = val;
-}
-
-void Value::assign(uint64_t val)
-{
-	assign(int64_t(val));
-}
-
-void Value::assign(float val)
-{
-	reset(Type::Real);
-	any.real_ = val;
-}
-
-void Value::assign(double val)
-{
-	reset(Type::Real);
-	any.real_ = val;
-}
-
-void Value::assign(const wchar_t* wide_string)
-{
-	reset(Type::String);
-	for (const wchar_t* wide_char = wide_string; *wide_char != 0; wide_char++) {
-		any.string_->append(Reader::convertUnicode(*wide_char));
-	}
-}
-
-void Value::assign(const std::wstring& wide_string)
-{
-	assign(wide_string.c_str());
-}
-
-void Value::assign(const char* string)
-{
-	reset(Type::String);
-	any.string_->assign(string);
-}
-
-void Value::assign(std::string&& string)
-{
-	reset(Type::String);
-	any.string_->assign(string);
-}
-
-void Value::assign(const std::string& string)
-{
-	reset(Type::String);
-	any.string_->assign(string);
-}
-
-void Value::assign(const Array& arr)
-{
-	reset(Type::Array);
-	any.array_->assign(arr.begin(), arr.end());
-}
-
-void Value::assign(const Object& obj)
-{
-	reset(Type::Object);
-	*any.object_ = obj;
-}
-
-void Value::assign(const Value& other)
-{
-	reset(other.type);
-	switch (type) {
-		case Type::String:
-			*any.string_ = *other.any.string_;
-			break;
-		case Type::Array:
-			*any.array_ = *other.any.array_;
-			break;
-		case Type::Object:
-			*any.object_ = *other.any.object_;
-			break;
-		default:
-			any = other.any;
-	}
-}
-
-void Value::assign(Value&& other) noexcept
-{
-	reset();
-	swap(other);
-}
-
-Value::Value(std::initializer_list<Value> list)
-{
-	bool is_object = std::all_of(list.begin(), list.end(), [](const Value& value) {
-		return value.isArray() && value.size() == 2 && value[0].isString();
-	});
-	if (!is_object) {
-		reset(Type::Array);
-		any.array_->assign(
-			std::make_move_iterator(list.begin()),
-			std::make_move_iterator(list.end())
-		);
-	} else {
-		reset(Type::Object);
-		for (auto& pair : list) {
-			any.object_->emplace(std::move(*pair[0].any.string_), std::move(pair[1]));
-		}
-	}
-}
-
-Value& Value::operator=(const Value& other)
-{
-	assign(other);
-	return *this;
-}
-
-Value& Value::operator=(Value&& other) noexcept
-{
-	assign(other);
-	return *this;
-}
-
-void Value::swap(Value& other)
-{
-	std::swap(type, other.type);
-	std::swap(any, other.any);
-}
-
-bool Value::empty() const
-{
-	switch (type) {
-		case Type::String:
-			return any.string_->empty();
-		case Type::Array:
-			return any.array_->empty();
-		case Type::Object:
-			return any.object_->empty();
-		default:
-			return type == Type::Null;
-	}
-}
-
-Value::Type Value::getType() const
-{
-	return type;
-}
-
-const char* Value::getTypeString(Value::Type type)
-{
-	switch (type) {
-		case Type::Null:
-			return "null";
-		case Type::Bool:
-			return "bool";
-		case Type::Real:
-			return "real";
-		case Type::Integer:
-			return "integer";
-		case Type::String:
-			return "string";
-		case Type::Array:
-			return "array";
-		case Type::Object:
-			return "object";
-		default:
-			return "unknown";
-	}
-}
-
-const char* Value::getTypeString() const
-{
-	return getTypeString(type);
-}
-
-std::wstring Value::asWideString() const
-{
-	std::wstring wide_string;
-	auto byte_string = asString();
-	const char* begin = byte_string.c_str();
-	const char* end = begin + byte_string.size();
-	while (begin < end) {
-		uint32_t unicode = 0;
-		begin += Writer::convertUnicode(begin, end, unicode);
-		wide_string += wchar_t(unicode);
-	}
-	return wide_string;
-}
-
-std::string Value::asString() const
-{
-	switch (type) {
-		case Type::String:
-			return *any.string_;
-		case Type::Array:
-		case Type::Object:
-			// throw Error();
-			return {};
-		default: {
-			return stringify();
-		}
-	}
-}
-
-int64_t Value::asInteger() const
-{
-	switch (type) {
-		case Type::Bool:
-			return any.bool_;
-		case Type::Integer:
-			return any.integer_;
-		case Type::Real:
-			return int64_t(any.real_);
-		case Type::String:
-			return std::strtoll(any.string_->c_str(), nullptr, 10);
-		default:
-			// throw Error();
-			return 0;
-	}
-}
-
-double Value::asReal() const
-{
-	switch (type) {
-		case Type::Bool:
-			return double(any.bool_);
-		case Type::Integer:
-			return double(any.integer_);
-		case Type::Real:
-			return any.real_;
-		case Type::String:
-			return std::strtod(any.string_->c_str(), nullptr);
-		default:
-			// throw Error();
-			return 0;
-	}
-}
-
-bool Value::asBool() const
-{
-	switch (type) {
-		case Type::Bool:
-			return any.bool_;
-		case Type::Integer:
-			return any.integer_ != 0;
-		case Type::Real:
-			return std::isnan(any.real_) || any.real_ == 0 ?
-				false : true;
-		case Type::String:
-			if (!any.string_->empty()) {
-				auto compare = [](char left, char right) {
-					return std::tolower(left) == right;
-				};
-				return std::equal(any.string_->begin(), any.string_->end(), std::begin("false"), compare) ?
-					false : true;
-			}
-			return false;
-		default:
-			// throw Error();
-			return false;
-	}
-}
-
-bool Value::operator==(const Value& other) const
-{
-	if (type != other.type) {
-		return false;
-	}
-	switch (type) {
-		case Type::Null:
-			return true;
-		case Type::Bool:
-			return any.bool_ == other.any.bool_;
-		case Type::Integer:
-			return any.integer_ == other.any.integer_;
-		case Type::Real:
-			return any.real_ == other.any.real_;
-		case Type::String:
-			return *any.string_ == *other.any.string_;
-		case Type::Array:
-			return *any.array_ == *other.any.array_;
-		case Type::Object:
-			return *any.object_ == *other.any.object_;
-		default:
-			// throw Error
-			return false;
-	}
-}
-
-bool Value::operator!=(const Value& other) const
-{
-	return !(*this == other);
-}
-
-bool Value::operator<(const Value& other) const
-{
-	if (type != other.type) {
-		return type < other.type;
-	}
-	switch (type) {
-		case Type::Null:
-			return false;
-		case Type::Bool:
-			return any.bool_ < other.any.bool_;
-		case Type::Integer:
-			return any.integer_ < other.any.integer_;
-		case Type::Real:
-			return any.real_ < other.any.real_;
-		case Type::String:
-			return *any.string_ < *other.any.string_;
-		case Type::Array:
-			return *any.array_ < *other.any.array_;
-		case Type::Object:
-			return *any.object_ < *other.any.object_;
-		default:
-			// throw Error
-			return false;
-	}
-}
-
-bool Value::operator>(const Value& other) const
-{
-	return other < *this;
-}
-
-bool Value::operator<=(const Value& other) const
-{
-	return !(other < *this);
-}
-
-bool Value::operator>=(const Value& other) const
-{
-	return !(*this < other);
-}
-
-Value& Value::operator[](const char* key)
-{
-	return (*this)[std::string(key)];
-}
-
-Value& Value::operator[](const std::string& key)
-{
-	if (!isObject()) {
-		reset(Type::Object);
-	}
-	return (*any.object_)[key];
-}
-
-const Value& Value::operator[](const char* key) const
-{
-	return (*this)[std::string(key)];
-}
-
-const Value& Value::operator[](const std::string& key) const
-{
-	if (has(key)) {
-		return any.object_->at(key);
-	}
-	return null;
-}
-
-Value Value::get(const std::string& key, const Value& default_value /*= Value::null*/) const
-{
-	if (has(key)) {
-		return (*this)[key];
-	}
-	return default_value;
-}
-
-Value Value::get(Index index, const Value& default_value /*= Value::null*/) const
-{
-	if (has(index)) {
-		return (*this)[index];
-	}
-	return default_value;
-}
-
-Value& Value::operator[](Index index)
-{
-	if (!isArray()) {
-		reset(Type::Array);
-	}
-	if (any.array_->size() <= index) {
-		any.array_->resize(index + 1);
-	}
-	return any.array_->at(index);
-}
-
-Value& Value::operator[](int index)
-{
-	return (*this)[Index(index)];
-}
-
-const Value& Value::operator[](Index index) const
-{
-	if (has(index)) {
-		return any.array_->at(index);
-	}
-	return null;
-}
-
-const Value& Value::operator[](int index) const
-{
-	return (*this)[Index(index)];
-}
-
-Value& Value::append(Value&& other)
-{
-	if (!isArray()) {
-		reset(Type::Array);
-	}
-	any.array_->push_back(other);
-	return any.array_->back();
-}
-
-Value& Value::append(const Value& other)
-{
-	if (!isArray()) {
-		reset(Type::Array);
-	}
-	any.array_->push_back(other);
-	return any.array_->back();
-}
-
-void Value::append(std::initializer_list<Value> values)
-{
-	if (!isArray()) {
-		reset(Type::Array);
-	}
-	for (auto& value : values) {
-		any.array_->push_back(std::move(value));
-	}
-}
-
-std::string Value::stringify(bool pretty) const
-{
-	std::stringstream stream;
-	Writer(stream).pretty(pretty).write(*this);
-	return stream.str();
-}
-
-bool Value::isNull() const
-{
-	return type == Type::Null;
-}
-
-bool Value::isBool() const
-{
-	return type == Type::Bool;
-}
-
-bool Value::isInteger() const
-{
-	return type == Type::Integer;
-}
-
-bool Value::isReal() const
-{
-	return type == Type::Real;
-}
-
-bool Value::isString() const
-{
-	return type == Type::String;
-}
-
-bool Value::isArray() const
-{
-	return type == Type::Array;
-}
-
-bool Value::isObject() const
-{
-	return type == Type::Object;
-}
-
-bool Value::isNegative() const
-{
-	switch (type) {
-		case Type::Real:
-			return std::signbit(any.real_);
-		case Type::Integer:
-			return any.integer_ < 0;
-		default:
-			return false;
-	}
-}
-
-uint32_t Value::size() const
-{
-	switch (type) {
-		case Type::Bool:
-			return sizeof(any.bool_);
-		case Type::Integer:
-			return sizeof(any.integer_);
-		case Type::Real:
-			return sizeof(any.real_);
-		case Type::String:
-			return any.string_->size();
-		case Type::Array:
-			return any.array_->size();
-		case Type::Object:
-			return any.object_->size();
-		default:
-			return 0;
-	}
-}
-
-bool Value::has(const std::string& name) const
-{
-	return isObject() ? any.object_->count(name) > 0 : false;
-}
-
-bool Value::has(Index index) const
-{
-	return isArray() ? index < any.array_->size() : false;
-}
-
-const Value::Array& Value::getArray() const
-{
-	if (isArray()) {
-		return *any.array_;
-	}
-	throw Error("value is not an array");
-}
-
-const Value::Object& Value::getObject() const
-{
-	if (isObject()) {
-		return *any.object_;
-	}
-	throw Error("value is not an object");
-}
-
-Iterator Value::begin() const
-{
-	if (isArray()) {
-		return Iterator(any.array_->begin());
-	}
-	if (isObject()) {
-		return Iterator(any.object_->begin());
-	}
-	if (isNull()) {
-		return Iterator();
-	}
-	throw std::runtime_error("bad type");
-}
-
-Iterator Value::end() const
-{
-	if (isArray()) {
-		return Iterator(any.array_->end());
-	}
-	if (isObject()) {
-		return Iterator(any.object_->end());
-	}
-	if (isNull()) {
-		return Iterator();
-	}
-	throw std::runtime_error("bad type");
-}
-
-Value& Value::convert(Type type)
-{
-	if (this->type != type) {
-		switch (type) {
-			case Type::Bool:
-				*this = asBool();
-				break;
-			case Type::Integer:
-				*this = asInteger();
-				break;
-			case Type::Real:
-				*this = asReal();
-				break;
-			case Type::String:
-				*this = asString();
-				break;
-			case Type::Array: {
-				Value old_value;
-				swap(old_value);
-				if (old_value.type == Type::Object) {
-					for (auto& kv : *old_value.any.object_) {
-						this->append(std::move(kv.second));
-					}
-				} else {
-					this->append(std::move(old_value));
-				}
-				break;
-			}
-			case Type::Object: {
-				Value old_value;
-				swap(old_value);
-				if (old_value.type == Type::Array) {
-					for (Index id = 0; id < old_value.size(); id++) {
-						(*this)["id" + std::to_string(id)].swap(old_value[id]);
-					}
-				} else {
-					(*this)[getTypeString(old_value.type)].swap(old_value);
-				}
-				break;
-			}
-			default:
-				reset();
-		}
-	}
-	return *this;
-}
-
-Value Value::convert(Type type) const
-{
-	return Value(*this).convert(type);
-}
-
-} /* namespace json */
-} /* namespace az */
-
-namespace std
-{
-
-ostream& operator<<(ostream& stream, const az::json::Value::Type& type)
-{
-	stream << az::json::Value::getTypeString(type);
-	return stream;
-}
-
-ostream& operator<<(ostream& stream, const az::json::Value& value)
-{
-	az::json::Writer(stream).pretty().write(value);
-	return stream;
-}
-
+#include <az/json/Value.h>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <az/json/Writer.h>
+#include <az/json/Reader.h>
+
+namespace az {
+namespace json {
+namespace {
+
+// a deque of stable arrays has no capacity, so it is not reserved
+template<class Element, class Allocator>
+void reserveElements(std::vector<Element, Allocator>& array, std::size_t size)
+{
+	array.reserve(size);
+}
+
+template<class Element, class Allocator>
+void reserveElements(std::deque<Element, Allocator>&, std::size_t)
+{
+}
+
+template<class Element, class Allocator>
+std::size_t getCapacity(const std::vector<Element, Allocator>& array)
+{
+	return array.capacity();
+}
+
+template<class Element, class Allocator>
+std::size_t getCapacity(const std::deque<Element, Allocator>& array)
+{
+	return array.size();
+}
+
+// the storage is taken from the current resource
+template<class Shared, class... Args>
+Shared* makeShared(Args&&... args)
+{
+	const auto resource = MemoryResource::getCurrent();
+	const auto memory = resource->allocate(sizeof(Shared), alignof(Shared));
+	try {
+		return new (memory) Shared(resource, std::forward<Args>(args)...);
+	}
+	catch (...) {
+		resource->deallocate(memory, sizeof(Shared), alignof(Shared));
+		throw;
+	}
+}
+
+template<class Shared>
+void retainShared(Shared* shared)
+{
+	shared->owners.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<class Shared>
+void releaseShared(Shared* shared)
+{
+	// the last owner deletes the storage once the others are done with it
+	if (shared->owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		const auto resource = shared->resource;
+		shared->~Shared();
+		resource->deallocate(shared, sizeof(Shared), alignof(Shared));
+	}
+}
+
+template<class Shared>
+void unshareStorage(Shared*& shared)
+{
+	if (shared->owners.load(std::memory_order_acquire) != 1) {
+		// the copy is taken from the same resource, so it keeps sharing its elements and members
+		MemoryResource::Scope scope(shared->resource);
+		auto copy = makeShared<Shared>(shared->data);
+		releaseShared(shared);
+		shared = copy;
+	}
+}
+
+} /* namespace */
+
+// the payload is the first member, so a string kept inside the value starts at its address
+static_assert(std::is_standard_layout<Value>::value && sizeof(Value) == 16, "Value takes 16 bytes");
+
+const Value Value::null;
+const std::size_t Value::small_capacity;
+const uint8_t Value::long_string;
+
+void Value::reset(Type type /*= Type::Null*/)
+{
+	switch (this->type) {
+		case Type::String:
+			if (small_size == long_string) {
+				releaseShared(any.string_);
+			}
+			break;
+		case Type::Array:
+			releaseShared(any.array_);
+			break;
+		case Type::Object:
+			releaseShared(any.object_);
+			break;
+		default:
+			break;
+	}
+	std::memset(getSmall(), 0, small_capacity + 1);
+	small_size = 0;
+	this->type = Type::Null;
+
+	switch (type) {
+		case Type::Array:
+			any.array_ = makeShared<Shared<Array>>();
+			break;
+		case Type::Object:
+			any.object_ = makeShared<Shared<Object>>();
+			break;
+		default:
+			break;
+	}
+	this->type = type;
+}
+
+void Value::assign(bool val)
+{
+	reset(Type::Bool);
+	any.bool_ = val;
+}
+
+void Value::assign(int val)
+{
+	reset(Type::Integer);
+	any.integer_ = val;
+}
+
+void Value::assign(int64_t val)
+{
+	reset(Type::Integer);
+	any.integer_ = val;
+}
+
+void Value::assign(uint64_t val)
+{
+	assign(int64_t(val));
+}
+
+void Value::assign(float val)
+{
+	reset(Type::Real);
+	any.real_ = val;
+}
+
+void Value::assign(double val)
+{
+	reset(Type::Real);
+	any.real_ = val;
+}
+
+void Value::assign(const wchar_t* wide_string)
+{
+	std::string string;
+	for (const wchar_t* wide_char = wide_string; *wide_char != 0; wide_char++) {
+		string.append(Reader::convertUnicode(*wide_char));
+	}
+	assign(std::move(string));
+}
+
+void Value::assign(const std::wstring& wide_string)
+{
+	assign(wide_string.c_str());
+}
+
+void Value::assign(const char* string)
+{
+	assignString(string, std::strlen(string));
+}
+
+void Value::assign(std::string&& string)
+{
+	assignString(string.data(), string.size());
+}
+
+void Value::assign(const std::string& string)
+{
+	assignString(string.data(), string.size());
+}
+
+void Value::assignString(const char* data, std::size_t size)
+{
+	reset(Type::String);
+	if (size <= small_capacity) {
+		std::memcpy(getSmall(), data, size);
+		small_size = uint8_t(size);
+	}
+	else {
+		any.string_ = makeShared<Shared<Text>>(data, size);
+		small_size = long_string;
+	}
+}
+
+const char* Value::getStringData() const
+{
+	return small_size == long_string ? any.string_->data.data() : getSmall();
+}
+
+std::size_t Value::getStringSize() const
+{
+	return small_size == long_string ? any.string_->data.size() : small_size;
+}
+
+void Value::assignDigits(Type type, const char* data, std::size_t size)
+{
+	reset(type);
+	// the digits are followed by a zero which is left by the reset
+	std::memcpy(getSmall(), data, size);
+	small_size = uint8_t(size);
+}
+
+bool Value::getDigits(const char*& data, std::size_t& size) const
+{
+	if ((type != Type::Integer && type != Type::Real) || small_size == 0) {
+		return false;
+	}
+	data = getSmall();
+	size = small_size;
+	return true;
+}
+
+int64_t Value::getInteger() const
+{
+	return small_size == 0 ? any.integer_ : std::strtoll(getSmall(), nullptr, 10);
+}
+
+double Value::getReal() const
+{
+	return small_size == 0 ? any.real_ : std::strtod(getSmall(), nullptr);
+}
+
+void Value::assign(const Array& arr)
+{
+	reset(Type::Array);
+	any.array_->data.assign(arr.begin(), arr.end());
+}
+
+void Value::assign(const Object& obj)
+{
+	reset(Type::Object);
+	copyMembers(obj, any.object_->data, false);
+}
+
+void Value::assign(Object&& obj)
+{
+	reset(Type::Object);
+	any.object_->data = std::move(obj);
+}
+
+void Value::assign(const Value& other)
+{
+	if (this == &other) {
+		return;
+	}
+	// the storage is shared before this value is released, since the other value may be a part of this one
+	Value copy(nullptr);
+	const auto resource = other.getResource();
+	if (resource && resource != MemoryResource::getCurrent()) {
+		// storage of another resource is not shared, so a value never outlives the resource of its storage
+		copy = other.clone();
+	}
+	else {
+		copy.copySmall(other);
+		copy.retain();
+		// the storage may be modified through references which are kept by the caller of the other value
+		if (copy.isLeaked()) {
+			copy.unshare();
+		}
+	}
+	swap(copy);
+}
+
+void Value::retain()
+{
+	switch (type) {
+		case Type::String:
+			if (small_size == long_string) {
+				retainShared(any.string_);
+			}
+			break;
+		case Type::Array:
+			retainShared(any.array_);
+			break;
+		case Type::Object:
+			retainShared(any.object_);
+			break;
+		default:
+			break;
+	}
+}
+
+bool Value::isLeaked() const
+{
+	const auto storage = getStorage();
+	return storage && storage->leaked;
+}
+
+void Value::unshare()
+{
+	if (type == Type::Array) {
+		unshareStorage(any.array_);
+	}
+	else if (type == Type::Object) {
+		unshareStorage(any.object_);
+	}
+}
+
+void Value::copyMembers(const Object& from, Object& to, bool deep)
+{
+	// copies of the keys are made by the allocator of the object instead of the one of the original keys
+	from.sort();
+	to.members.clear();
+	to.order = from.order;
+	to.lookup = from.lookup;
+	to.members.reserve(from.members.size());
+	for (const auto& member : from.members) {
+		Object::key_type key(member.first.data(), member.first.size(), to.members.get_allocator());
+		to.members.emplace_back(std::move(key), deep ? member.second.clone() : member.second);
+	}
+	std::copy(std::begin(from.heads), std::end(from.heads), to.heads);
+	to.index.assign(from.index.begin(), from.index.end());
+}
+
+MemoryResource* Value::getResource() const
+{
+	const auto storage = getStorage();
+	return storage ? storage->resource : nullptr;
+}
+
+Value::Storage* Value::getStorage() const
+{
+	switch (type) {
+		case Type::String:
+			return small_size == long_string ? any.string_ : nullptr;
+		case Type::Array:
+			return any.array_;
+		case Type::Object:
+			return any.object_;
+		default:
+			return nullptr;
+	}
+}
+
+Value::Object& Value::ownObject()
+{
+	unshareStorage(any.object_);
+	any.object_->span = 0;
+	return any.object_->data;
+}
+
+Value::Object& Value::leakObject()
+{
+	auto& object = ownObject();
+	any.object_->leaked = true;
+	return object;
+}
+
+Value Value::clone() const
+{
+	Value copy;
+	switch (type) {
+		case Type::String:
+			copy.assignString(getStringData(), getStringSize());
+			break;
+		case Type::Array: {
+			copy.reset(Type::Array);
+			auto& array = copy.any.array_->data;
+			reserveElements(array, any.array_->data.size());
+			for (const auto& element : any.array_->data) {
+				array.push_back(element.clone());
+			}
+			break;
+		}
+		case Type::Object:
+			copy.reset(Type::Object);
+			copyMembers(any.object_->data, copy.any.object_->data, true);
+			break;
+		default:
+			copy.copySmall(*this);
+	}
+	return copy;
+}
+
+void Value::assign(Value&& other) noexcept
+{
+	// the other value may be a part of this one, so it is taken before this one is released
+	Value taken(nullptr);
+	taken.swap(other);
+	swap(taken);
+}
+
+Value::Value(std::initializer_list<Value> list)
+{
+	bool is_object = std::all_of(list.begin(), list.end(), [](const Value& value) {
+		return value.isArray() && value.size() == 2 && value[0].isString();
+	});
+	if (!is_object) {
+		reset(Type::Array);
+		any.array_->data.assign(
+			std::make_move_iterator(list.begin()),
+			std::make_move_iterator(list.end())
+		);
+	} else {
+		reset(Type::Object);
+		for (auto& pair : list) {
+			any.object_->data.emplace(pair[0].asString(), std::move(pair[1]));
+		}
+	}
+}
+
+Value& Value::operator=(const Value& other)
+{
+	assign(other);
+	return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept
+{
+	assign(std::move(other));
+	return *this;
+}
+
+void Value::swap(Value& other)
+{
+	char small[small_capacity + 1];
+	std::memcpy(small, getSmall(), sizeof(small));
+	std::memcpy(getSmall(), other.getSmall(), sizeof(small));
+	std::memcpy(other.getSmall(), small, sizeof(small));
+	std::swap(type, other.type);
+	std::swap(small_size, other.small_size);
+}
+
+void Value::copySmall(const Value& other)
+{
+	std::memcpy(getSmall(), other.getSmall(), small_capacity + 1);
+	type = other.type;
+	small_size = other.small_size;
+}
+
+bool Value::empty() const
+{
+	switch (type) {
+		case Type::String:
+			return getStringSize() == 0;
+		case Type::Array:
+			return any.array_->data.empty();
+		case Type::Object:
+			return any.object_->data.empty();
+		default:
+			return type == Type::Null;
+	}
+}
+
+Value::Type Value::getType() const
+{
+	return type;
+}
+
+const char* Value::getTypeString(Value::Type type)
+{
+	switch (type) {
+		case Type::Null:
+			return "null";
+		case Type::Bool:
+			return "bool";
+		case Type::Real:
+			return "real";
+		case Type::Integer:
+			return "integer";
+		case Type::String:
+			return "string";
+		case Type::Array:
+			return "array";
+		case Type::Object:
+			return "object";
+		default:
+			return "unknown";
+	}
+}
+
+const char* Value::getTypeString() const
+{
+	return getTypeString(type);
+}
+
+std::wstring Value::asWideString() const
+{
+	std::wstring wide_string;
+	auto byte_string = asString();
+	const char* begin = byte_string.c_str();
+	const char* end = begin + byte_string.size();
+	while (begin < end) {
+		uint32_t unicode = 0;
+		begin += Writer::convertUnicode(begin, end, unicode);
+		wide_string += wchar_t(unicode);
+	}
+	return wide_string;
+}
+
+std::string Value::asString() const
+{
+	switch (type) {
+		case Type::String:
+			return std::string(getStringData(), getStringSize());
+		case Type::Array:
+		case Type::Object:
+			// throw Error();
+			return {};
+		default: {
+			return stringify();
+		}
+	}
+}
+
+int64_t Value::asInteger() const
+{
+	switch (type) {
+		case Type::Bool:
+			return any.bool_;
+		case Type::Integer:
+			return getInteger();
+		case Type::Real:
+			return int64_t(getReal());
+		case Type::String:
+			return std::strtoll(getStringData(), nullptr, 10);
+		default:
+			// throw Error();
+			return 0;
+	}
+}
+
+double Value::asReal() const
+{
+	switch (type) {
+		case Type::Bool:
+			return double(any.bool_);
+		case Type::Integer:
+			return double(getInteger());
+		case Type::Real:
+			return getReal();
+		case Type::String:
+			return std::strtod(getStringData(), nullptr);
+		default:
+			// throw Error();
+			return 0;
+	}
+}
+
+bool Value::asBool() const
+{
+	switch (type) {
+		case Type::Bool:
+			return any.bool_;
+		case Type::Integer:
+			return getInteger() != 0;
+		case Type::Real: {
+			const auto real = getReal();
+			return std::isnan(real) || real == 0 ?
+				false : true;
+		}
+		case Type::String:
+			if (getStringSize() != 0) {
+				auto compare = [](char left, char right) {
+					return std::tolower(left) == right;
+				};
+				const auto data = getStringData();
+				return std::equal(data, data + getStringSize(), std::begin("false"), compare) ?
+					false : true;
+			}
+			return false;
+		default:
+			// throw Error();
+			return false;
+	}
+}
+
+bool Value::operator==(const Value& other) const
+{
+	if (type != other.type) {
+		return false;
+	}
+	switch (type) {
+		case Type::Null:
+			return true;
+		case Type::Bool:
+			return any.bool_ == other.any.bool_;
+		case Type::Integer:
+			return getInteger() == other.getInteger();
+		case Type::Real:
+			return getReal() == other.getReal();
+		case Type::String:
+			return getStringSize() == other.getStringSize() &&
+				std::memcmp(getStringData(), other.getStringData(), getStringSize()) == 0;
+		case Type::Array:
+			return any.array_ == other.any.array_ || any.array_->data == other.any.array_->data;
+		case Type::Object:
+			return any.object_ == other.any.object_ || any.object_->data == other.any.object_->data;
+		default:
+			// throw Error
+			return false;
+	}
+}
+
+bool Value::operator!=(const Value& other) const
+{
+	return !(*this == other);
+}
+
+bool Value::operator<(const Value& other) const
+{
+	if (type != other.type) {
+		return type < other.type;
+	}
+	switch (type) {
+		case Type::Null:
+			return false;
+		case Type::Bool:
+			return any.bool_ < other.any.bool_;
+		case Type::Integer:
+			return getInteger() < other.getInteger();
+		case Type::Real:
+			return getReal() < other.getReal();
+		case Type::String:
+		{
+			// the same order as std::string has
+			const auto size = std::min(getStringSize(), other.getStringSize());
+			const auto order = std::char_traits<char>::compare(getStringData(), other.getStringData(), size);
+			return order < 0 || (order == 0 && getStringSize() < other.getStringSize());
+		}
+		case Type::Array:
+			return any.array_->data < other.any.array_->data;
+		case Type::Object:
+			return any.object_->data < other.any.object_->data;
+		default:
+			// throw Error
+			return false;
+	}
+}
+
+bool Value::operator>(const Value& other) const
+{
+	return other < *this;
+}
+
+bool Value::operator<=(const Value& other) const
+{
+	return !(other < *this);
+}
+
+bool Value::operator>=(const Value& other) const
+{
+	return !(*this < other);
+}
+
+Value& Value::operator[](const char* key)
+{
+	if (isObject()) {
+		// the key is copied only to insert a new member
+		auto& object = leakObject();
+		const auto position = object.locate(key, std::strlen(key));
+		if (position != Object::npos) {
+			return object.members[position].second;
+		}
+	}
+	return (*this)[std::string(key)];
+}
+
+Value& Value::operator[](const std::string& key)
+{
+	if (!isObject()) {
+		reset(Type::Object);
+	}
+	return leakObject()[key];
+}
+
+const Value& Value::operator[](const char* key) const
+{
+	return lookup(key, std::strlen(key));
+}
+
+const Value& Value::operator[](const std::string& key) const
+{
+	return lookup(key.data(), key.size());
+}
+
+Value Value::get(const std::string& key, const Value& default_value /*= Value::null*/) const
+{
+	return lookup(key.data(), key.size(), default_value);
+}
+
+Value Value::get(Index index, const Value& default_value /*= Value::null*/) const
+{
+	return lookup(index, default_value);
+}
+
+const Value* Value::find(const char* key, std::size_t size) const
+{
+	if (!isObject()) {
+		return nullptr;
+	}
+	const auto& object = any.object_->data;
+	object.sort();
+	const auto position = object.locate(key, size);
+	return position == Object::npos ? nullptr : &object.members[position].second;
+}
+
+const Value* Value::find(const char* key) const
+{
+	return find(key, std::strlen(key));
+}
+
+const Value* Value::find(const std::string& key) const
+{
+	return find(key.data(), key.size());
+}
+
+const Value* Value::find(Index index) const
+{
+	return has(index) ? &any.array_->data[index] : nullptr;
+}
+
+const Value* Value::find(int index) const
+{
+	return find(Index(index));
+}
+
+const Value& Value::lookup(const char* key, std::size_t size, const Value& default_value /*= Value::null*/) const
+{
+	const auto value = find(key, size);
+	return value ? *value : default_value;
+}
+
+const Value& Value::lookup(const std::string& key, const Value& default_value /*= Value::null*/) const
+{
+	return lookup(key.data(), key.size(), default_value);
+}
+
+const Value& Value::lookup(Index index, const Value& default_value /*= Value::null*/) const
+{
+	const auto value = find(index);
+	return value ? *value : default_value;
+}
+
+Value& Value::operator[](Index index)
+{
+	if (!isArray()) {
+		reset(Type::Array);
+	}
+	auto& array = leakArray();
+	if (array.size() <= index) {
+		array.resize(index + 1);
+	}
+	return array[index];
+}
+
+Value& Value::operator[](int index)
+{
+	return (*this)[Index(index)];
+}
+
+const Value& Value::operator[](Index index) const
+{
+	return lookup(index);
+}
+
+const Value& Value::operator[](int index) const
+{
+	return (*this)[Index(index)];
+}
+
+Value& Value::append(Value&& other)
+{
+	if (!isArray()) {
+		reset(Type::Array);
+	}
+	auto& array = leakArray();
+	array.push_back(std::move(other));
+	return array.back();
+}
+
+Value& Value::append(const Value& other)
+{
+	if (!isArray()) {
+		reset(Type::Array);
+	}
+	auto& array = leakArray();
+	array.push_back(other);
+	return array.back();
+}
+
+void Value::append(std::initializer_list<Value> values)
+{
+	if (!isArray()) {
+		reset(Type::Array);
+	}
+	auto& array = ownArray();
+	reserveElements(array, array.size() + values.size());
+	for (auto& value : values) {
+		array.push_back(std::move(value));
+	}
+}
+
+void Value::reserve(Index size)
+{
+	if (isObject()) {
+		ownObject().reserve(size);
+		return;
+	}
+	if (!isArray()) {
+		reset(Type::Array);
+	}
+	reserveElements(ownArray(), size);
+}
+
+Value::Index Value::capacity() const
+{
+	if (isObject()) {
+		return Index(any.object_->data.capacity());
+	}
+	return isArray() ? Index(getCapacity(any.array_->data)) : 0;
+}
+
+void Value::shrinkToFit()
+{
+	if (isArray()) {
+		ownArray().shrink_to_fit();
+	}
+}
+
+std::string Value::stringify(bool pretty) const
+{
+	std::stringstream stream;
+	Writer(stream).pretty(pretty).write(*this);
+	return stream.str();
+}
+
+bool Value::isNull() const
+{
+	return type == Type::Null;
+}
+
+bool Value::isBool() const
+{
+	return type == Type::Bool;
+}
+
+bool Value::isInteger() const
+{
+	return type == Type::Integer;
+}
+
+bool Value::isReal() const
+{
+	return type == Type::Real;
+}
+
+bool Value::isString() const
+{
+	return type == Type::String;
+}
+
+bool Value::isArray() const
+{
+	return type == Type::Array;
+}
+
+bool Value::isObject() const
+{
+	return type == Type::Object;
+}
+
+bool Value::isNegative() const
+{
+	switch (type) {
+		case Type::Real:
+			return std::signbit(getReal());
+		case Type::Integer:
+			return getInteger() < 0;
+		default:
+			return false;
+	}
+}
+
+uint32_t Value::size() const
+{
+	switch (type) {
+		case Type::Bool:
+			return sizeof(any.bool_);
+		case Type::Integer:
+			return sizeof(any.integer_);
+		case Type::Real:
+			return sizeof(any.real_);
+		case Type::String:
+			return uint32_t(getStringSize());
+		case Type::Array:
+			return uint32_t(any.array_->data.size());
+		case Type::Object:
+			return uint32_t(any.object_->data.size());
+		default:
+			return 0;
+	}
+}
+
+bool Value::has(const char* name) const
+{
+	return find(name) != nullptr;
+}
+
+bool Value::has(const std::string& name) const
+{
+	return find(name) != nullptr;
+}
+
+bool Value::has(Index index) const
+{
+	return isArray() ? index < any.array_->data.size() : false;
+}
+
+bool Value::has(int index) const
+{
+	return has(Index(index));
+}
+
+const Value::Array& Value::getArray() const
+{
+	if (isArray()) {
+		return any.array_->data;
+	}
+	throw Error("value is not an array");
+}
+
+const Value::Object& Value::getObject() const
+{
+	if (isObject()) {
+		return any.object_->data;
+	}
+	throw Error("value is not an object");
+}
+
+Iterator Value::begin() const
+{
+	if (isArray()) {
+		return Iterator(any.array_->data.begin());
+	}
+	if (isObject()) {
+		return Iterator(any.object_->data.begin());
+	}
+	if (isNull()) {
+		return Iterator();
+	}
+	throw std::runtime_error("bad type");
+}
+
+Iterator Value::end() const
+{
+	if (isArray()) {
+		return Iterator(any.array_->data.end());
+	}
+	if (isObject()) {
+		return Iterator(any.object_->data.end());
+	}
+	if (isNull()) {
+		return Iterator();
+	}
+	throw std::runtime_error("bad type");
+}
+
+Value& Value::convert(Type type)
+{
+	if (this->type != type) {
+		switch (type) {
+			case Type::Bool:
+				*this = asBool();
+				break;
+			case Type::Integer:
+				*this = asInteger();
+				break;
+			case Type::Real:
+				*this = asReal();
+				break;
+			case Type::String:
+				*this = asString();
+				break;
+			case Type::Array: {
+				Value old_value;
+				swap(old_value);
+				if (old_value.type == Type::Object) {
+					auto& object = old_value.ownObject();
+					object.sort();
+					for (auto& kv : object.members) {
+						this->append(std::move(kv.second));
+					}
+				} else {
+					this->append(std::move(old_value));
+				}
+				break;
+			}
+			case Type::Object: {
+				Value old_value;
+				swap(old_value);
+				if (old_value.type == Type::Array) {
+					for (Index id = 0; id < old_value.size(); id++) {
+						(*this)["id" + std::to_string(id)].swap(old_value[id]);
+					}
+				} else {
+					(*this)[getTypeString(old_value.type)].swap(old_value);
+				}
+				break;
+			}
+			default:
+				reset();
+		}
+	}
+	return *this;
+}
+
+Value Value::convert(Type type) const
+{
+	return Value(*this).convert(type);
+}
+
+} /* namespace json */
+} /* namespace az */
+
+namespace std
+{
+
+ostream& operator<<(ostream& stream, const az::json::Value::Type& type)
+{
+	stream << az::json::Value::getTypeString(type);
+	return stream;
+}
+
+ostream& operator<<(ostream& stream, const az::json::Value& value)
+{
+	az::json::Writer(stream).pretty().write(value);
+	return stream;
+}
+
 }
\ No newline at end of file
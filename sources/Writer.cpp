@@ -1,256 +1,424 @@
-#include <az/json/Writer.h>
-#include <sstream>
-#include <iomanip>
-#include <algorithm>
-#include <cmath>
-#include <limits>
-#include <cstring>
-
-namespace az {
-namespace json {
-
-Writer& Writer::withIndentChar(char v)
-{
-	options.indent_char = v;
-	return *this;
-}
-
-Writer& Writer::withIndentSize(uint32_t v)
-{
-	options.indent_size = v;
-	return *this;
-}
-
-Writer& Writer::withLeftMargin(uint32_t v)
-{
-	options.left_margin = v;
-	return *this;
-}
-
-Writer& Writer::withNewLine(const std::string& v)
-{
-	options.new_line = v;
-	return *this;
-}
-
-Writer& Writer::withoutQuoting(bool v /*= true*/)
-{
-	options.quoting = !v;
-	return *this;
-}
-
-Writer& Writer::pretty(bool v /*= true*/)
-{
-	options.pretty = v;
-	return *this;
-}
-
-void Writer::write(const Value& value)
-{
-	int level = 0;
-	writeIndentation(level);
-	writeValue(value, level);
-}
-
-void Writer::writeValue(const Value& value, int level)
-{
-	switch (value.getType()) {
-		case Value::Type::Null:
-			stream << "null";
-			break;
-		case Value::Type::Bool:
-			stream << (value.asBool() ? "true" : "false");
-			break;
-		case Value::Type::Integer: {
-			if (value.isNegative()) {
-				stream << '-';
-			}
-			stream << std::abs(value.asInteger());
-			break;
-		}
-		case Value::Type::Real: {
-			if (value.isNegative()) {
-				stream << '-';
-			}
-			auto real = value.asReal();
-			if (std::isinf(real)) {
-				stream << "Infinity";
-			} else if (std::isnan(real)) {
-				stream << "NaN";
-			} else {
-				stream << std::abs(real);
-			}
-			break;
-		}
-		case Value::Type::String:
-			stream << '"';
-			escape(value.asString());
-			stream << '"';
-			break;
-		case Value::Type::Array:
-			stream << '[';
-			if (!value.empty()) {
-				auto count = value.size();
-				for (const auto& array_value : value.getArray()) {
-					writeNewLine();
-					writeIndentation(level + 1);
-					writeValue(array_value, level + 1);
-					if (--count > 0) {
-						stream << ',';
-					}
-				}
-				writeNewLine();
-				writeIndentation(level);
-			}
-			stream << ']';
-			break;
-		case Value::Type::Object:
-			stream << '{';
-			if (!value.empty()) {
-				auto count = value.size();
-				for (const auto& kv : value.getObject()) {
-					writeNewLine();
-					writeIndentation(level + 1);
-					writeIdentifier(kv.first);
-					writeValue(kv.second, level + 1);
-					if (--count > 0) {
-						stream << ',';
-					}
-				}
-				writeNewLine();
-				writeIndentation(level);
-			}
-			stream << '}';
-			break;
-		default:
-			stream << value.asString();
-	}
-}
-
-void Writer::writeNewLine()
-{
-	if (options.pretty) {
-		stream << options.new_line;
-	}
-}
-
-void Writer::writeIndentation(int level)
-{
-	if (options.pretty) {
-		stream << std::string(options.left_margin + (level * options.indent_size), options.indent_char);
-	}
-}
-
-void Writer::writeIdentifier(const std::string& id)
-{
-	if (options.quoting || !isIdentifier(id)) {
-		stream << '"';
-		escape(id);
-		stream << '"';
-	} else {
-		stream << id;
-	}
-	stream << ':';
-	if (options.pretty) {
-		stream << ' ';
-	}
-}
-
-int Writer::convertUnicode(const char* begin, const char* end, uint32_t& unicode)
-{
-	int length = 1;
-	const char* next = begin;
-	while (next < end && (next - begin < length)) {
-		auto byte = static_cast<uint8_t>(*next);
-		if (length == 1) {
-			if (byte < 0x80) {
-				unicode = byte;
-			}
-			else if (byte < 0xE0) {
-				unicode = byte & 0x1F;
-				length = 2;
-			}
-			else if (byte < 0xF0) {
-				unicode = byte & 0x0F;
-				length = 3;
-			}
-			else if (byte < 0xF8) {
-				unicode = byte & 0x07;
-				length = 4;
-			}
-		}
-		else {
-			unicode = (unicode << 6) | (byte & 0x3F);
-		}
-		next++;
-	}
-
-	return int(next - begin);
-}
-
-void Writer::escape(const char* begin, const char* end)
-{
-	while (begin < end) {
-		int length = 1;
-		auto letter = *begin;
-		switch (letter) {
-			case '"':
-			case '\'':
-			case '\\':
-			//case '/':
-				stream << '\\' << letter;
-				break;
-			case '\b':
-				stream << "\\b";
-				break;
-			case '\f':
-				stream << "\\f";
-				break;
-			case '\n':
-				stream << "\\n";
-				break;
-			case '\r':
-				stream << "\\r";
-				break;
-			case '\t':
-				stream << "\\t";
-				break;
-			default: {
-				uint32_t unicode = 0;
-				length = convertUnicode(begin, end, unicode);
-				if (unicode < 0x20 || unicode >= 0x80) {
-					auto flags = stream.flags();
-					stream << "\\u" << std::setfill('0') << std::setw(4) << std::hex << unicode;
-					stream.flags(flags);
-				}
-				else {
-					stream << letter;
-				}
-			}
-		}
-		begin += length;
-	}
-}
-
-void Writer::escape(const std::string& string)
-{
-	escape(string.c_str(), string.c_str() + string.length());
-}
-
-void Writer::escape(const char* string)
-{
-	escape(string, string + strlen(string));
-}
-
-bool Writer::isIdentifier(const std::string& id)
-{
-	if (!id.empty() && (isalpha(id.front()) || id.front() == '_')) {
-		return std::all_of(std::next(id.begin()), id.end(), [](std::string::value_type letter) { 
-			return isalnum(letter) || letter == '_'; 
-		});
-	}
-	return false;
-}
-
-} /* namespace json */
-} /* namespace az */
+#include <az/json/Writer.h>
+#include <az/json/Error.h>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <cctype>
+
+namespace az {
+namespace json {
+
+namespace {
+
+bool isDigit(char letter)
+{
+	return letter >= '0' && letter <= '9';
+}
+
+bool isSpace(char letter)
+{
+	return letter == ' ' || letter == '\t' || letter == '\n' || letter == '\r';
+}
+
+bool isWord(const char* begin, const char* end, const char* word)
+{
+	const auto size = std::strlen(word);
+	return std::size_t(end - begin) == size && std::memcmp(begin, word, size) == 0;
+}
+
+// an optional minus, an integer without leading zeros, an optional fraction and an optional exponent
+bool isPlainNumber(const char* begin, const char* end)
+{
+	auto letter = begin;
+	auto skipDigits = [&letter, end]() {
+		const auto first = letter;
+		while (letter != end && isDigit(*letter)) {
+			letter++;
+		}
+		return letter != first;
+	};
+	if (letter != end && *letter == '-') {
+		letter++;
+	}
+	if (letter != end && *letter == '0') {
+		letter++;
+	}
+	else if (!skipDigits()) {
+		return false;
+	}
+	if (letter != end && *letter == '.') {
+		letter++;
+		if (!skipDigits()) {
+			return false;
+		}
+	}
+	if (letter != end && (*letter == 'e' || *letter == 'E')) {
+		letter++;
+		if (letter != end && (*letter == '+' || *letter == '-')) {
+			letter++;
+		}
+		if (!skipDigits()) {
+			return false;
+		}
+	}
+	return letter == end;
+}
+
+// the text has been parsed, so only the extensions of JSON5 are looked for:
+// comments, other quotes, escapes and spaces, unquoted keys, other numbers and trailing commas
+bool isPlainJson(const char* text, std::size_t size)
+{
+	const auto end = text + size;
+	for (auto letter = text; letter != end; ) {
+		const auto character = *letter;
+		if (character == '"') {
+			for (letter++; *letter != '"'; letter++) {
+				if (uint8_t(*letter) < 0x20) {
+					return false;
+				}
+				if (*letter == '\\') {
+					letter++;
+					if (*letter == '\0' || !std::strchr("\"\\/bfnrtu", *letter)) {
+						return false;
+					}
+				}
+			}
+			letter++;
+		}
+		else if (character == '-' || isDigit(character)) {
+			const auto begin = letter;
+			while (letter != end && (std::isalnum(uint8_t(*letter)) || *letter == '.' || *letter == '+' || *letter == '-')) {
+				letter++;
+			}
+			if (!isPlainNumber(begin, letter)) {
+				return false;
+			}
+		}
+		else if (std::isalpha(uint8_t(character)) || character == '_') {
+			const auto begin = letter;
+			while (letter != end && (std::isalnum(uint8_t(*letter)) || *letter == '_')) {
+				letter++;
+			}
+			if (!isWord(begin, letter, "true") && !isWord(begin, letter, "false") && !isWord(begin, letter, "null")) {
+				return false;
+			}
+			// the same words are keys if they are followed by a colon
+			auto next = letter;
+			while (next != end && isSpace(*next)) {
+				next++;
+			}
+			if (next != end && *next == ':') {
+				return false;
+			}
+		}
+		else if (character == ',') {
+			auto next = ++letter;
+			while (next != end && isSpace(*next)) {
+				next++;
+			}
+			if (next == end || *next == ']' || *next == '}') {
+				return false;
+			}
+		}
+		else if (isSpace(character) || std::strchr("{}[]:", character)) {
+			letter++;
+		}
+		else {
+			return false;
+		}
+	}
+	return true;
+}
+
+} /* namespace */
+
+Writer& Writer::withIndentChar(char v)
+{
+	options.indent_char = v;
+	return *this;
+}
+
+Writer& Writer::withIndentSize(uint32_t v)
+{
+	options.indent_size = v;
+	return *this;
+}
+
+Writer& Writer::withLeftMargin(uint32_t v)
+{
+	options.left_margin = v;
+	return *this;
+}
+
+Writer& Writer::withNewLine(const std::string& v)
+{
+	options.new_line = v;
+	return *this;
+}
+
+Writer& Writer::withoutQuoting(bool v /*= true*/)
+{
+	options.quoting = !v;
+	return *this;
+}
+
+Writer& Writer::withCancellation(const Cancellation& v)
+{
+	options.cancellation = &v;
+	return *this;
+}
+
+Writer& Writer::withRawText(const RawText& v)
+{
+	options.raw_text = &v;
+	return *this;
+}
+
+Writer& Writer::pretty(bool v /*= true*/)
+{
+	options.pretty = v;
+	return *this;
+}
+
+void Writer::write(const Value& value)
+{
+	int level = 0;
+	countdown = options.cancellation ? options.cancellation->getInterval() : 0;
+	writeIndentation(level);
+	writeValue(value, level);
+}
+
+void Writer::checkCancellation()
+{
+	countdown = options.cancellation->getInterval();
+	if (options.cancellation->isCancelled()) {
+		throw Error("writing is cancelled", -1, -1, -1, Error::Code::Cancelled);
+	}
+}
+
+void Writer::writeValue(const Value& value, int level)
+{
+	if (options.cancellation && --countdown == 0) {
+		checkCancellation();
+	}
+	const char* raw = nullptr;
+	std::size_t raw_size = 0;
+	// a value is copied from the text only if it is plain JSON, which is what plain quoted writing gives as well
+	if (options.raw_text && !options.pretty && options.quoting && options.raw_text->find(value, raw, raw_size) &&
+		isPlainJson(raw, raw_size)) {
+		stream.write(raw, std::streamsize(raw_size));
+		return;
+	}
+	// a number which has not been decoded is written with its original digits
+	if (value.getDigits(raw, raw_size)) {
+		stream.write(raw, std::streamsize(raw_size));
+		return;
+	}
+	switch (value.getType()) {
+		case Value::Type::Null:
+			stream << "null";
+			break;
+		case Value::Type::Bool:
+			stream << (value.asBool() ? "true" : "false");
+			break;
+		case Value::Type::Integer: {
+			if (value.isNegative()) {
+				stream << '-';
+			}
+			stream << std::abs(value.asInteger());
+			break;
+		}
+		case Value::Type::Real: {
+			if (value.isNegative()) {
+				stream << '-';
+			}
+			auto real = value.asReal();
+			if (std::isinf(real)) {
+				stream << "Infinity";
+			} else if (std::isnan(real)) {
+				stream << "NaN";
+			} else {
+				stream << std::abs(real);
+			}
+			break;
+		}
+		case Value::Type::String:
+			stream << '"';
+			escape(value.asString());
+			stream << '"';
+			break;
+		case Value::Type::Array:
+			stream << '[';
+			if (!value.empty()) {
+				auto count = value.size();
+				for (const auto& array_value : value.getArray()) {
+					writeNewLine();
+					writeIndentation(level + 1);
+					writeValue(array_value, level + 1);
+					if (--count > 0) {
+						stream << ',';
+					}
+				}
+				writeNewLine();
+				writeIndentation(level);
+			}
+			stream << ']';
+			break;
+		case Value::Type::Object:
+			stream << '{';
+			if (!value.empty()) {
+				auto count = value.size();
+				for (const auto& kv : value.getObject()) {
+					writeNewLine();
+					writeIndentation(level + 1);
+					writeIdentifier(kv.first);
+					writeValue(kv.second, level + 1);
+					if (--count > 0) {
+						stream << ',';
+					}
+				}
+				writeNewLine();
+				writeIndentation(level);
+			}
+			stream << '}';
+			break;
+		default:
+			stream << value.asString();
+	}
+}
+
+void Writer::writeNewLine()
+{
+	if (options.pretty) {
+		stream << options.new_line;
+	}
+}
+
+void Writer::writeIndentation(int level)
+{
+	if (options.pretty) {
+		stream << std::string(options.left_margin + (level * options.indent_size), options.indent_char);
+	}
+}
+
+void Writer::writeIdentifier(const Value::Object::key_type& id)
+{
+	if (options.quoting || !isIdentifier(id.data(), id.data() + id.size())) {
+		stream << '"';
+		escape(id.data(), id.data() + id.size());
+		stream << '"';
+	} else {
+		stream << id;
+	}
+	stream << ':';
+	if (options.pretty) {
+		stream << ' ';
+	}
+}
+
+int Writer::convertUnicode(const char* begin, const char* end, uint32_t& unicode)
+{
+	int length = 1;
+	const char* next = begin;
+	while (next < end && (next - begin < length)) {
+		auto byte = static_cast<uint8_t>(*next);
+		if (length == 1) {
+			if (byte < 0x80) {
+				unicode = byte;
+			}
+			else if (byte < 0xE0) {
+				unicode = byte & 0x1F;
+				length = 2;
+			}
+			else if (byte < 0xF0) {
+				unicode = byte & 0x0F;
+				length = 3;
+			}
+			else if (byte < 0xF8) {
+				unicode = byte & 0x07;
+				length = 4;
+			}
+		}
+		else {
+			unicode = (unicode << 6) | (byte & 0x3F);
+		}
+		next++;
+	}
+
+	return int(next - begin);
+}
+
+void Writer::escape(const char* begin, const char* end)
+{
+	while (begin < end) {
+		int length = 1;
+		auto letter = *begin;
+		switch (letter) {
+			case '"':
+			case '\'':
+			case '\\':
+			//case '/':
+				stream << '\\' << letter;
+				break;
+			case '\b':
+				stream << "\\b";
+				break;
+			case '\f':
+				stream << "\\f";
+				break;
+			case '\n':
+				stream << "\\n";
+				break;
+			case '\r':
+				stream << "\\r";
+				break;
+			case '\t':
+				stream << "\\t";
+				break;
+			default: {
+				uint32_t unicode = 0;
+				length = convertUnicode(begin, end, unicode);
+				if (unicode < 0x20 || unicode >= 0x80) {
+					auto flags = stream.flags();
+					stream << "\\u" << std::setfill('0') << std::setw(4) << std::hex << unicode;
+					stream.flags(flags);
+				}
+				else {
+					stream << letter;
+				}
+			}
+		}
+		begin += length;
+	}
+}
+
+void Writer::escape(const std::string& string)
+{
+	escape(string.c_str(), string.c_str() + string.length());
+}
+
+void Writer::escape(const char* string)
+{
+	escape(string, string + strlen(string));
+}
+
+bool Writer::isIdentifier(const std::string& id)
+{
+	return isIdentifier(id.data(), id.data() + id.size());
+}
+
+bool Writer::isIdentifier(const char* begin, const char* end)
+{
+	if (begin != end && (std::isalpha(*begin) || *begin == '_')) {
+		return std::all_of(std::next(begin), end, [](char letter) { 
+			return std::isalnum(letter) || letter == '_'; 
+		});
+	}
+	return false;
+}
+
+} /* namespace json */
+} /* namespace az */
@@ -0,0 +1,89 @@
+#include <boost/test/unit_test.hpp>
+#include <az/json/Document.h>
+#include <cstring>
+
+namespace {
+
+std::string makeRecords(int count)
+{
+	std::string text = "[";
+	for (int index = 0; index < count; index++) {
+		text += "{\"id\": " + std::to_string(index) + ", \"a rather long key of the record\": \"a string which is long enough\", tags: [1, 2]},";
+	}
+	text += "null]";
+	return text;
+}
+
+} /* namespace */
+
+BOOST_AUTO_TEST_SUITE(DocumentTests)
+
+BOOST_AUTO_TEST_CASE(parse_into_arena)
+{
+	az::json::Document document;
+	document.parse(makeRecords(1000));
+	const auto& root = document.getRoot();
+	BOOST_REQUIRE_EQUAL(root.size(), 1001);
+	BOOST_CHECK_EQUAL(root[999]["id"], 999);
+	BOOST_CHECK_EQUAL(root[999]["a rather long key of the record"], "a string which is long enough");
+	BOOST_CHECK_EQUAL(root.getResource(), &document.getArena());
+	BOOST_CHECK_EQUAL(root[0]["tags"].getResource(), &document.getArena());
+	BOOST_CHECK_GT(document.getArena().getUsed(), 0);
+	BOOST_CHECK_GE(document.getArena().getReserved(), document.getArena().getUsed());
+
+	// a copy is taken out of the arena, so it outlives the document
+	az::json::Value copy = root[1];
+	BOOST_CHECK_NE(copy.getResource(), &document.getArena());
+	document.clear();
+	BOOST_CHECK_EQUAL(document.getArena().getReserved(), 0);
+	BOOST_CHECK_EQUAL(copy["a rather long key of the record"], "a string which is long enough");
+}
+
+BOOST_AUTO_TEST_CASE(parse_again)
+{
+	az::json::Document document;
+	document.parse("{'a': [1, 2, 3]}");
+	document.parse("[true]", az::json::Reader::Options());
+	BOOST_CHECK_EQUAL(document.getRoot(), az::json::Value({true}));
+	BOOST_CHECK_THROW(document.parse("[1,"), az::json::Error);
+}
+
+BOOST_AUTO_TEST_CASE(modify_document)
+{
+	az::json::Document document;
+	document.parse(makeRecords(10));
+	// values which are made out of the arena are released one by one with the document
+	document.modifyRoot()[0]["extra"] = {"a string which is made out of the arena"};
+	document.modifyRoot().append({{"object", "made out of the arena as well"}});
+	BOOST_CHECK_EQUAL(document.getRoot().size(), 12);
+	BOOST_CHECK_EQUAL(document.getRoot()[0]["extra"][0], "a string which is made out of the arena");
+}
+
+BOOST_AUTO_TEST_CASE(parse_into_huge_pages)
+{
+	az::json::Arena::Options options;
+	options.huge_pages = true;
+	az::json::Document document(options);
+	document.parse(makeRecords(100));
+	BOOST_CHECK_EQUAL(document.getRoot()[99]["id"], 99);
+	BOOST_CHECK_EQUAL(document.getArena().getReserved() % (2 << 20), 0);
+}
+
+BOOST_AUTO_TEST_CASE(allocate_aligned)
+{
+	az::json::Arena::Options options;
+	options.chunk_size = 4096;
+	az::json::Arena arena(options);
+	for (std::size_t size : {1, 3, 8, 100, 5000, 7}) {
+		for (std::size_t alignment : {1, 2, 8, 16}) {
+			auto memory = arena.allocate(size, alignment);
+			BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(memory) % alignment, 0);
+			std::memset(memory, 0xFF, size);
+		}
+	}
+	BOOST_CHECK_GE(arena.getReserved(), arena.getUsed());
+	arena.release();
+	BOOST_CHECK_EQUAL(arena.getUsed(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,20 @@
+#include <az/json/Reader.h>
+
+// every case is a literal which must not be compiled
+int main()
+{
+#if LITERAL_ERROR == 1
+	auto json = "{a: 1 b: 2}"_json;
+#elif LITERAL_ERROR == 2
+	auto json = "['unterminated]"_json;
+#elif LITERAL_ERROR == 3
+	auto json = "9223372036854775808"_json;
+#elif LITERAL_ERROR == 4
+	auto json = "'\\x41'"_json;
+#elif LITERAL_ERROR == 5
+	auto json = "[1, 2] 3"_json;
+#else
+	auto json = "[1, 2, 3]"_json;
+#endif
+	return json.size() == 3 ? 0 : 1;
+}
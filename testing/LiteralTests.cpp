@@ -0,0 +1,54 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <az/json/Reader.h>
+#include <cmath>
+
+using namespace az::json;
+
+BOOST_AUTO_TEST_SUITE(LiteralTests)
+
+BOOST_AUTO_TEST_CASE(check_at_compile_time)
+{
+	constexpr auto view = R"({
+		// JSON5 features are supported as well
+		name: 'az-json',
+		"version": [1, 0, +0x1F],
+		limits: {depth: 64, ratio: .5e1, size: -9223372036854775808,},
+		flags: [true, false, null,],
+		text: "a\"bé\
+c",
+	})"_json_view;
+
+	static_assert(view.isObject() && view.size() == 5);
+	static_assert(view["name"].asString() == "az-json");
+	static_assert(view["version"].size() == 3);
+	static_assert(view["version"][2].asInteger() == 31);
+	static_assert(view["limits"]["depth"].asInteger() == 64);
+	static_assert(view["limits"]["size"].asInteger() == INT64_MIN);
+	static_assert(view["limits"]["ratio"].isReal());
+	static_assert(view["flags"][0].asBool() && !view["flags"][1].asBool() && view["flags"][2].isNull());
+	static_assert(view["text"].asString() == "a\"b\xC3\xA9" "c");
+	static_assert(view.has("flags") && !view.has("missing"));
+
+	BOOST_CHECK_EQUAL(view["limits"]["ratio"].asReal(), 5.0);
+	BOOST_CHECK_THROW(view["missing"], Error);
+	BOOST_CHECK_THROW(view["version"][3], Error);
+}
+
+BOOST_AUTO_TEST_CASE(materialize_once)
+{
+	const Value& first = "{a: [1, 2.5, 'three'], b: {c: null}}"_json;
+	const Value& second = "{a: [1, 2.5, 'three'], b: {c: null}}"_json;
+	BOOST_CHECK_EQUAL(&first, &second);
+	BOOST_CHECK_EQUAL(first, Value({{"a", {1, 2.5, "three"}}, {"b", {{"c", nullptr}}}}));
+
+	// the same result as the runtime parsing
+	const char* texts[] = {"[Infinity, -Infinity, 1e3, 0x10, -0X1a, .5, 5., hello]", "{a: 1, a: 2}", "'\\u0041\\/'"};
+	BOOST_CHECK_EQUAL("[Infinity, -Infinity, 1e3, 0x10, -0X1a, .5, 5., hello]"_json, parse(texts[0], strlen(texts[0])));
+	BOOST_CHECK_EQUAL("{a: 1, a: 2}"_json, parse(texts[1], strlen(texts[1])));
+	BOOST_CHECK_EQUAL("'\\u0041\\/'"_json, parse(texts[2], strlen(texts[2])));
+	BOOST_CHECK(std::isnan("NaN"_json.asReal()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
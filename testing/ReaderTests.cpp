@@ -3,7 +3,32 @@
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
 #include <az/json/Reader.h>
+#include <az/json/Writer.h>
 #include <cmath>
+#include <thread>
+
+struct CollectingSink : az::json::StringSink {
+	std::vector<std::string> paths;
+	std::string text;
+	std::size_t chunks = 0;
+	std::size_t largest = 0;
+	int aborted = 0;
+	void open(const std::string& path) override {
+		paths.push_back(path);
+		text.clear();
+	}
+	void write(const char* data, std::size_t size) override {
+		text.append(data, size);
+		chunks++;
+		largest = std::max(largest, size);
+	}
+	az::json::Value close() override {
+		return "streamed:" + std::to_string(text.size());
+	}
+	void abort() override {
+		aborted++;
+	}
+};
 
 struct ReaderFixture {
 	az::json::Value json;
@@ -331,6 +356,427 @@ BOOST_FIXTURE_TEST_CASE(parse_with_unicode_whitespaces, ReaderFixture)
 	BOOST_CHECK_EQUAL(json["json"].asInteger(), 5);
 }
 
+BOOST_FIXTURE_TEST_CASE(parse_with_utf8_validation, ReaderFixture)
+{
+	reader.withUtf8Validation();
+	parse("{json:'\xC2\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80'}");
+	BOOST_REQUIRE(json.isObject());
+	BOOST_CHECK_EQUAL(json["json"].asString(), "\xC2\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80");
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_malformed_utf8_text, ReaderFixture)
+{
+	reader.withUtf8Validation();
+	BOOST_REQUIRE_THROW(reader.parse("{\n json: 'valid \xE2\x82\xAC',\n bad: 'in\xC0\xAFvalid'}"), az::json::Error);
+	auto error = reader.getLastError();
+	BOOST_CHECK_EQUAL(error.offset(), 31);
+	BOOST_CHECK_EQUAL(error.line(), 3);
+	BOOST_CHECK_EQUAL(error.column(), 10);
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_malformed_utf8_stream, ReaderFixture)
+{
+	std::istringstream stream("{\n json: 'valid \xE2\x82\xAC',\n bad: 'in\xC0\xAFvalid'}");
+	BOOST_REQUIRE_THROW(reader.withUtf8Validation().parse(stream), az::json::Error);
+	auto error = reader.getLastError();
+	BOOST_CHECK_EQUAL(error.offset(), 31);
+	BOOST_CHECK_EQUAL(error.line(), 3);
+	BOOST_CHECK_EQUAL(error.column(), 10);
+
+	std::istringstream truncated("1 // \xE2\x82");
+	BOOST_REQUIRE_NO_THROW(reader.withNoThrows().strictly().parse(truncated));
+	BOOST_REQUIRE(reader.hasErrors());
+	BOOST_CHECK_EQUAL(reader.getLastError().offset(), 5);
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_malformed_utf8_without_validation, ReaderFixture)
+{
+	parse("'in\xC0\xAFvalid'");
+	BOOST_CHECK(json.isString());
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_with_limits, ReaderFixture)
+{
+	auto check = [this](const char* text, const az::json::Reader::Limits& limits) {
+		reader.withLimits(limits);
+		BOOST_REQUIRE_THROW(reader.parse(text), az::json::Error);
+		BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Limit);
+	};
+	az::json::Reader::Limits limits;
+	limits.depth = 2;
+	parse("[[1], {a: 2}]");
+	reader.withLimits(limits);
+	parse("[[1], {a: 2}]");
+	check("[[[1]]]", limits);
+
+	limits = az::json::Reader::Limits();
+	limits.bytes = 8;
+	std::istringstream stream("[1, 2, 3, 4]");
+	reader.withLimits(limits);
+	BOOST_REQUIRE_THROW(reader.parse(stream), az::json::Error);
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Limit);
+	check("[1, 2, 3, 4]", limits);
+	parse("[1, 2]");
+
+	limits = az::json::Reader::Limits();
+	limits.string_length = 3;
+	check("'abcd'", limits);
+	check("{abcd: 1}", limits);
+	reader.withLimits(limits);
+	parse("{abc: 'def'}");
+
+	limits = az::json::Reader::Limits();
+	limits.elements = 2;
+	check("[1, 2, 3]", limits);
+	check("{a: 1, b: 2, c: 3}", limits);
+
+	limits = az::json::Reader::Limits();
+	limits.values = 3;
+	check("[1, [2]]", limits);
+
+	limits = az::json::Reader::Limits();
+	limits.memory = 256;
+	check("['a very long string which is counted as its heap memory of a string value, the memory "
+		"budget is exceeded after a few copies of it', 'a very long string which is counted as its heap memory "
+		"of a string value, the memory budget is exceeded after a few copies of it']", limits);
+	reader.withLimits(limits);
+	parse("[1, 2, 3]");
+
+	// the value stays valid after the failure
+	limits = az::json::Reader::Limits();
+	limits.elements = 2;
+	check("{a: [1, 2], b: [1, 2, 3]}", limits);
+	BOOST_CHECK(json.isObject());
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_with_cancellation, ReaderFixture)
+{
+	std::string text = "[";
+	for (int index = 0; index < 10000; index++) {
+		text += "{id: " + std::to_string(index) + "}, ";
+	}
+	text += "]";
+
+	az::json::Cancellation cancellation(16);
+	reader.withCancellation(cancellation);
+	parse(text.c_str());
+	BOOST_CHECK_EQUAL(json.size(), 10000);
+
+	cancellation.cancel();
+	BOOST_REQUIRE_THROW(reader.parse(text.c_str()), az::json::Error);
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Cancelled);
+	// the parsing is stopped within the interval of tokens
+	BOOST_CHECK_LE(reader.getLastError().offset(), 64);
+	BOOST_CHECK(json.isArray());
+
+	az::json::Cancellation expired;
+	expired.withTimeout(std::chrono::milliseconds(-1));
+	BOOST_REQUIRE_NO_THROW(reader.withNoThrows().withCancellation(expired).parse(text.c_str()));
+	BOOST_REQUIRE(reader.hasErrors());
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Cancelled);
+
+	az::json::Cancellation distant;
+	distant.withTimeout(std::chrono::hours(1));
+	reader.withNoThrows(false).withCancellation(distant);
+	parse(text.c_str());
+	BOOST_CHECK_EQUAL(json.size(), 10000);
+}
+
+BOOST_FIXTURE_TEST_CASE(validate_text, ReaderFixture)
+{
+	json = "untouched";
+	BOOST_REQUIRE_NO_THROW(reader.validate("{a: [1, 0x1F, -2.5e3, 'text', null, true, NaN], 'b': {c: {}}}"));
+	BOOST_CHECK(!reader.hasErrors());
+	BOOST_CHECK_EQUAL(json, "untouched");
+
+	BOOST_REQUIRE_THROW(reader.validate("{a: [1, 2}"), az::json::Error);
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Syntax);
+	BOOST_CHECK_EQUAL(reader.getLastError().offset(), 9);
+	BOOST_CHECK_THROW(reader.validate("{'': 1}"), az::json::Error);
+	BOOST_CHECK_THROW(reader.validate("{'\\\n': 1}"), az::json::Error);
+	BOOST_CHECK_NO_THROW(reader.validate("{'\\\na': 1}"));
+	// numbers which are out of range are rejected as they are by parsing
+	BOOST_CHECK_THROW(reader.validate("[99999999999999999999]"), az::json::Error);
+	BOOST_CHECK_THROW(reader.validate("[1e999]"), az::json::Error);
+	BOOST_CHECK_EQUAL(reader.getLastError().what(), std::string("malformed number"));
+	for (const char* number : {"9223372036854775807", "9223372036854775808", "-9223372036854775808", "-9223372036854775809",
+		"000000000000000000000000001", "0x7fffffffffffffff", "0X8000000000000000", "-0x8000000000000000", "-0x8000000000000001",
+		"0x", "1.7976931348623157e308", "1.7976931348623159e308", "17976931348623157e292", "2.2250738585072014e-308",
+		"1e-310", "4.9e-324", "1e-400", "0e99999", "0.000e-99999", "1.", ".5", "-.", "-Infinity", "+nan", "-in"}) {
+		const auto text = std::string("[") + number + "]";
+		bool parsed = true;
+		try {
+			az::json::Value value;
+			az::json::Reader(value).parse(text);
+		}
+		catch (const az::json::Error&) {
+			parsed = false;
+		}
+		bool validated = true;
+		try {
+			reader.validate(text);
+		}
+		catch (const az::json::Error&) {
+			validated = false;
+		}
+		BOOST_CHECK_MESSAGE(parsed == validated, "validation of " << number << " differs from parsing");
+	}
+
+	// positions of errors are kept after strings, which are checked without keeping them
+	BOOST_REQUIRE_THROW(reader.validate("{'a\\\nb': 'long string of text',\n x: }"), az::json::Error);
+	BOOST_CHECK_EQUAL(reader.getLastError().line(), 3);
+
+	BOOST_CHECK_NO_THROW(reader.validate("[1] garbage"));
+	BOOST_CHECK_THROW(reader.strictly().validate("[1] garbage"), az::json::Error);
+
+	az::json::Reader::Limits limits;
+	limits.depth = 1;
+	BOOST_REQUIRE_THROW(reader.withLimits(limits).validate("[[1]]"), az::json::Error);
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Limit);
+
+	std::istringstream stream("{a: 'in\xC0\xAFvalid'}");
+	BOOST_REQUIRE_NO_THROW(reader.withNoThrows().withUtf8Validation().validate(stream));
+	BOOST_REQUIRE(reader.hasErrors());
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Encoding);
+	BOOST_CHECK_EQUAL(json, "untouched");
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_with_exact_sizing, ReaderFixture)
+{
+	const char* text = "{a: [1, [2, 3], [], {b: [4, 5, 6]}], c: 'text', d: [[[7]]]}";
+	az::json::Value expected;
+	az::json::Reader(expected).parse(text);
+	reader.withExactSizing();
+	parse(text);
+	BOOST_CHECK_EQUAL(json, expected);
+	BOOST_CHECK_EQUAL(json["a"].size(), 4);
+	BOOST_CHECK_EQUAL(json["a"][3]["b"].size(), 3);
+
+	// a stream is parsed by a single pass
+	std::istringstream stream(text);
+	BOOST_REQUIRE_NO_THROW(reader.parse(stream));
+	BOOST_CHECK_EQUAL(json, expected);
+
+	// brackets and commas in strings and comments are not counted, trailing commas are not followed by elements
+	const char* tricky = "[1, '[,]', /* [,, */ [2, 3, 4, 5, 6,], // ],\n {a: \"]\\\"\", b: [7]},]";
+	az::json::Reader(expected).parse(tricky);
+	parse(tricky);
+	BOOST_CHECK_EQUAL(json, expected);
+	BOOST_CHECK_EQUAL(json.capacity(), 4);
+	BOOST_CHECK_EQUAL(json[2].capacity(), 5);
+	BOOST_CHECK_EQUAL(json[3]["b"].capacity(), 1);
+
+	// errors are reported and the part parsed so far is left as they are without the first pass
+	BOOST_CHECK_THROW(az::json::Reader(expected).parse("[1, [2, 3}"), az::json::Error);
+	BOOST_REQUIRE_THROW(reader.parse("[1, [2, 3}"), az::json::Error);
+	BOOST_CHECK_EQUAL(reader.getLastError().offset(), 9);
+	BOOST_CHECK_EQUAL(json, expected);
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_with_string_sink, ReaderFixture)
+{
+	std::string blob;
+	for (int index = 0; index < 100000; index++) {
+		blob += "line " + std::to_string(index) + "\\n\\u0041";
+	}
+	std::string expected;
+	az::json::Reader(json).parse("'" + blob + "'");
+	expected = json.asString();
+
+	CollectingSink sink;
+	reader.withStringSink(sink, 1000);
+	parse(("{id: 'short', items: [1, {blob: '" + blob + "'}]}").c_str());
+	BOOST_CHECK_EQUAL(json["id"], "short");
+	BOOST_CHECK_EQUAL(json["items"][1]["blob"], "streamed:" + std::to_string(expected.size()));
+	BOOST_REQUIRE_EQUAL(sink.paths.size(), 1);
+	BOOST_CHECK_EQUAL(sink.paths[0], ".items[1].blob");
+	BOOST_CHECK(sink.text == expected);
+	BOOST_CHECK_GT(sink.chunks, 10);
+	BOOST_CHECK_LE(sink.largest, 1 << 16);
+
+	// strings at the paths are streamed regardless of their size, keys are never streamed
+	sink.paths.clear();
+	reader.withStringSink(sink, 0, {"a.'b c'", "[1]"});
+	parse("{a: {'b c': 'x', d: 'y'}}");
+	BOOST_CHECK_EQUAL(json["a"]["b c"], "streamed:1");
+	BOOST_CHECK_EQUAL(json["a"]["d"], "y");
+	parse("['x', 'y\\tz']");
+	BOOST_CHECK_EQUAL(json[1], "streamed:3");
+	BOOST_CHECK_EQUAL(sink.text, "y\tz");
+	BOOST_CHECK_EQUAL(sink.paths.size(), 2);
+
+	reader.withStringSink(sink, 10);
+	BOOST_CHECK_THROW(reader.parse("['a long broken string"), az::json::Error);
+	BOOST_CHECK_EQUAL(sink.aborted, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_with_shape_caching, ReaderFixture)
+{
+	std::string text = "[";
+	for (int index = 0; index < 50; index++) {
+		text += "{\"id\": " + std::to_string(index) + ", name: 'n\\u0041me', \"tags\": {a: 1, \"b\": 2}},";
+	}
+	// objects which differ from the cached shapes in the middle, at the end, by quotes or by escapes
+	text += "{\"id\": 1, name: 'x', extra: true},";
+	text += "{\"id\": 2, name: 'y'},";
+	text += "{\"id\": 3, \"nam\\u0065\": 'z'},";
+	text += "{'id': 4, id: 5, \"name\": 'w', \"tags\": null},";
+	text += "{\"id\": 6, \"name\": 'v', \"tags\": {\"b\": 3, a: 4}, id: 7}]";
+
+	az::json::Value expected;
+	az::json::Reader(expected).withShapeCaching(false).parse(text);
+	parse(text.c_str());
+	BOOST_CHECK_EQUAL(json, expected);
+	BOOST_CHECK_EQUAL(json[50]["extra"], true);
+	BOOST_CHECK_EQUAL(json[52]["name"], "z");
+	BOOST_CHECK_EQUAL(json[53]["id"], 5);
+	BOOST_CHECK_EQUAL(json[54]["id"], 7);
+	BOOST_CHECK_EQUAL(json[54]["tags"]["a"], 4);
+
+	// the cache is reused by the next parsing
+	parse(text.c_str());
+	BOOST_CHECK_EQUAL(json, expected);
+
+	// records which differ only by their last keys follow their own shapes
+	text = "[";
+	for (int index = 0; index < 10; index++) {
+		text += (index % 2) ? "{id: 1, 'name': 'a', left: 2}," : "{id: 3, 'name': 'b', right: 4},";
+	}
+	text += "{id: 5, 'name': 'c', left: 6, right: 7}]";
+	az::json::Reader(expected).withShapeCaching(false).parse(text);
+	parse(text.c_str());
+	BOOST_CHECK_EQUAL(json, expected);
+	BOOST_CHECK_EQUAL(json[9]["left"], 2);
+	BOOST_CHECK_EQUAL(json[10]["right"], 7);
+}
+
+BOOST_AUTO_TEST_CASE(parse_in_insertion_order)
+{
+	const std::string text = "{\"z\": 1, \"b\": [2], \"a\": {\"y\": 3, \"x\": 4}, \"b\": 5}";
+	az::json::Value json;
+	az::json::Reader(json).withInsertionOrder().parse(text);
+
+	std::stringstream written;
+	az::json::Writer(written).write(json);
+	// a repeated key keeps the position of its first occurrence and the last value
+	BOOST_CHECK_EQUAL(written.str(), "{\"z\":1,\"b\":5,\"a\":{\"y\":3,\"x\":4}}");
+
+	az::json::Value sorted;
+	az::json::Reader(sorted).parse(text);
+	BOOST_CHECK_EQUAL(sorted.getObject().begin()->first, "a");
+	BOOST_CHECK_EQUAL(sorted["b"], 5);
+	BOOST_CHECK_EQUAL(sorted, json);
+}
+
+BOOST_AUTO_TEST_CASE(parse_large_objects)
+{
+	std::string text = "{";
+	for (int i = 0; i < 1000; i++) {
+		text += "\"" + std::to_string(i * 37 % 1000) + "\": " + std::to_string(i) + ",";
+	}
+	text += "\"0\": -1}";
+
+	for (bool insertion_order : {false, true}) {
+		az::json::Value json;
+		az::json::Reader(json).withInsertionOrder(insertion_order).parse(text);
+		BOOST_REQUIRE_EQUAL(json.size(), 1000);
+		BOOST_CHECK_EQUAL(json["0"], -1);
+		for (int i = 1; i < 1000; i++) {
+			BOOST_CHECK_EQUAL(json[std::to_string(i * 37 % 1000)], i);
+		}
+		BOOST_CHECK_EQUAL(json.getObject().begin()->first, "0");
+		BOOST_CHECK_EQUAL((json.getObject().begin() + 1)->first, insertion_order ? "37" : "1");
+	}
+}
+
+BOOST_AUTO_TEST_CASE(parse_with_memory_resource)
+{
+	struct : public az::json::MemoryResource {
+		std::size_t used = 0;
+		void* doAllocate(std::size_t size, std::size_t) override {
+			used += size;
+			return ::operator new(size);
+		}
+		void doDeallocate(void* memory, std::size_t size, std::size_t) override {
+			used -= size;
+			::operator delete(memory);
+		}
+	} resource;
+
+	az::json::Value json;
+	az::json::Reader(json).withMemoryResource(&resource).parse("{records: [{id: 1, name: 'a name which is long enough'}]}");
+	BOOST_CHECK_GT(resource.used, 0);
+	BOOST_CHECK_EQUAL(json.getResource(), &resource);
+	BOOST_CHECK_EQUAL(json["records"][0]["name"].getResource(), &resource);
+	BOOST_CHECK_EQUAL(az::json::MemoryResource::getCurrent(), az::json::MemoryResource::getDefault());
+
+	json.reset();
+	BOOST_CHECK_EQUAL(resource.used, 0);
+}
+
+BOOST_AUTO_TEST_CASE(parse_lazy_numbers)
+{
+	const std::string text = "[1, -20, 0.10, 1.5e+10, 3.14159265358, 12345678901234567, 0x1F, +7, 1e300, -0]";
+	az::json::Value json;
+	az::json::Reader(json).withLazyNumbers().parse(text);
+	BOOST_REQUIRE_EQUAL(json.size(), 10);
+	BOOST_CHECK(json[0].isInteger());
+	BOOST_CHECK_EQUAL(json[0].asInteger(), 1);
+	BOOST_CHECK(json[1].isNegative());
+	BOOST_CHECK_EQUAL(json[1].asReal(), -20.0);
+	BOOST_CHECK(json[2].isReal());
+	BOOST_CHECK_EQUAL(json[2].asReal(), 0.1);
+	BOOST_CHECK_EQUAL(json[3].asInteger(), 15000000000);
+	BOOST_CHECK_EQUAL(json[4].asReal(), 3.14159265358);
+	BOOST_CHECK_EQUAL(json[5].asInteger(), 12345678901234567);
+	BOOST_CHECK_EQUAL(json[6].asInteger(), 31);
+	BOOST_CHECK_EQUAL(json[7].asInteger(), 7);
+	BOOST_CHECK_EQUAL(json[8].asReal(), 1e300);
+	BOOST_CHECK(json[2].asBool());
+	BOOST_CHECK_EQUAL(json[2], 0.1);
+	BOOST_CHECK_LT(json[0], json[5]);
+	// digits of short JSON numbers are written as they are, the rest are decoded and formatted
+	BOOST_CHECK_EQUAL(json.stringify(false), "[1,-20,0.10,1.5e+10,3.14159265358,12345678901234567,31,7,1e+300,-0]");
+	BOOST_CHECK_EQUAL(json[2].asString(), "0.10");
+
+	// copies keep the digits, modified values are decoded
+	az::json::Value copy = json[4];
+	BOOST_CHECK_EQUAL(copy.stringify(), "3.14159265358");
+	BOOST_CHECK_EQUAL(json[4].clone().stringify(), "3.14159265358");
+	copy = copy.asReal() * 2;
+	BOOST_CHECK_EQUAL(copy.stringify(), "6.28319");
+
+	// malformed numbers are still rejected
+	BOOST_CHECK_THROW(az::json::Reader(json).withLazyNumbers().parse("[1e999]"), az::json::Error);
+
+	// a const value is decoded by several threads at once without modifying it
+	az::json::Reader(json).withLazyNumbers().parse(text);
+	const auto& shared = json;
+	std::vector<std::thread> threads;
+	std::vector<double> sums(4);
+	for (std::size_t thread = 0; thread < sums.size(); thread++) {
+		threads.emplace_back([&shared, &sums, thread]() {
+			for (int round = 0; round < 1000; round++) {
+				sums[thread] += shared[0].asReal() + shared[2].asReal() + double(shared[1].asInteger());
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (auto sum : sums) {
+		BOOST_CHECK_CLOSE(sum, 1000 * (1 + 0.1 - 20), 1e-9);
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(parse_errors_codes, ReaderFixture)
+{
+	BOOST_REQUIRE_THROW(reader.parse("[1,"), az::json::Error);
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Syntax);
+	BOOST_REQUIRE_THROW(reader.withUtf8Validation().parse("'\xC0\xAF'"), az::json::Error);
+	BOOST_CHECK(reader.getLastError().code() == az::json::Error::Code::Encoding);
+}
+
 BOOST_AUTO_TEST_CASE(parse_by_literal)
 {
 	auto json = "{json:5}"_json;
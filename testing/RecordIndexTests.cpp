@@ -0,0 +1,158 @@
+#include <boost/test/unit_test.hpp>
+#include <az/json/Reader.h>
+#include <az/json/RecordIndex.h>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+using namespace az::json;
+
+namespace {
+
+struct TemporaryFile
+{
+	std::string path;
+
+	explicit TemporaryFile(const std::string& content)
+		: path("record-index-tests-" + std::to_string(std::rand()) + ".ndjson")
+	{
+		std::ofstream(path, std::ios::binary) << content;
+	}
+
+	~TemporaryFile()
+	{
+		std::remove(path.c_str());
+		std::remove((path + ".idx").c_str());
+	}
+};
+
+std::string makeRecords(int count)
+{
+	std::string text;
+	for (int record = 0; record < count; record++) {
+		text += "{\"id\": " + std::to_string(record) + "}\n";
+		if (record % 7 == 0) {
+			text += "\n  \n";
+		}
+	}
+	return text;
+}
+
+} /* namespace */
+
+BOOST_AUTO_TEST_SUITE(RecordIndexTests)
+
+BOOST_AUTO_TEST_CASE(build_skips_blank_lines)
+{
+	std::string text = "\n{a:1}\n\n  [2]\r\n3";
+	auto index = RecordIndex::build(text.data(), text.size());
+	BOOST_CHECK_EQUAL(index.getRecords(), 3);
+	BOOST_CHECK_EQUAL(index.locate(text.data(), text.size(), 0), 1);
+	BOOST_CHECK_EQUAL(index.locate(text.data(), text.size(), 1), 8);
+	BOOST_CHECK_EQUAL(index.locate(text.data(), text.size(), 2), 15);
+	BOOST_CHECK_EQUAL(index.locate(text.data(), text.size(), 3), text.size());
+}
+
+BOOST_AUTO_TEST_CASE(build_in_parallel)
+{
+	std::string text = makeRecords(1000);
+	auto single = RecordIndex::build(text.data(), text.size(), RecordIndex::Options());
+	RecordIndex::Options options;
+	options.threads = 7;
+	options.sampling = 3;
+	auto sampled = RecordIndex::build(text.data(), text.size(), options);
+	BOOST_CHECK_EQUAL(single.getRecords(), 1000);
+	BOOST_CHECK_EQUAL(sampled.getRecords(), 1000);
+	BOOST_CHECK_EQUAL(sampled.getSampling(), 3);
+	for (uint64_t record = 0; record < 1000; record++) {
+		BOOST_CHECK_EQUAL(single.locate(text.data(), text.size(), record), sampled.locate(text.data(), text.size(), record));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(parse_records)
+{
+	TemporaryFile temporary(makeRecords(100));
+	MappedFile file(temporary.path);
+	RecordIndex::Options options;
+	options.sampling = 10;
+	auto index = RecordIndex::build(file, options);
+
+	Value json;
+	Reader reader(json);
+	reader.parseRecord(file, index, 42);
+	BOOST_CHECK_EQUAL(json, Value({{"id", 42}}));
+	reader.parseRecord(file, index, 99);
+	BOOST_CHECK_EQUAL(json, Value({{"id", 99}}));
+
+	reader.parseRecords(file, index, 5, 3);
+	BOOST_CHECK_EQUAL(json, Value({{{"id", 5}}, {{"id", 6}}, {{"id", 7}}}));
+
+	BOOST_CHECK_THROW(reader.parseRecord(file, index, 100), Error);
+	BOOST_CHECK_THROW(reader.parseRecords(file, index, 98, 3), Error);
+}
+
+BOOST_AUTO_TEST_CASE(save_and_load)
+{
+	TemporaryFile temporary(makeRecords(50));
+	{
+		MappedFile file(temporary.path);
+		RecordIndex::build(file).save(temporary.path + ".idx");
+		auto index = RecordIndex::load(temporary.path + ".idx", file);
+		BOOST_CHECK_EQUAL(index.getRecords(), 50);
+
+		Value json;
+		Reader(json).parseRecord(file, index, 17);
+		BOOST_CHECK_EQUAL(json, Value({{"id", 17}}));
+	}
+
+	// the index becomes outdated once the file is changed
+	std::ofstream(temporary.path, std::ios::app) << "{\"id\": 50}\n";
+	MappedFile file(temporary.path);
+	BOOST_CHECK_THROW(RecordIndex::load(temporary.path + ".idx", file), Error);
+
+	std::ofstream(temporary.path + ".idx", std::ios::binary) << "garbage";
+	BOOST_CHECK_THROW(RecordIndex::load(temporary.path + ".idx", file), Error);
+	BOOST_CHECK_THROW(RecordIndex::load(temporary.path + ".missing", file), Error);
+}
+
+BOOST_AUTO_TEST_CASE(load_corrupt_index)
+{
+	TemporaryFile temporary(makeRecords(50));
+	MappedFile file(temporary.path);
+	RecordIndex::build(file).save(temporary.path + ".idx");
+	std::string saved;
+	{
+		std::ifstream stream(temporary.path + ".idx", std::ios::binary);
+		saved.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+	// every record is sampled, so the file ends with the number of records, their count and their offsets
+	const auto offsets = saved.size() - 50 * sizeof(uint64_t);
+	auto corrupt = [&](std::initializer_list<std::pair<std::size_t, uint64_t>> fields) {
+		std::string copy = saved;
+		for (const auto& field : fields) {
+			std::memcpy(&copy[field.first], &field.second, sizeof(field.second));
+		}
+		std::ofstream(temporary.path + ".idx", std::ios::binary | std::ios::trunc) << copy;
+	};
+
+	// more offsets than the index holds
+	corrupt({{offsets - 2 * sizeof(uint64_t), file.size()}, {offsets - sizeof(uint64_t), file.size()}});
+	BOOST_CHECK_THROW(RecordIndex::load(temporary.path + ".idx", file), Error);
+
+	// an offset past the end of the file
+	corrupt({{saved.size() - sizeof(uint64_t), file.size()}});
+	BOOST_CHECK_THROW(RecordIndex::load(temporary.path + ".idx", file), Error);
+
+	// offsets out of order
+	uint64_t first = 0;
+	std::memcpy(&first, &saved[offsets], sizeof(first));
+	corrupt({{offsets + sizeof(uint64_t), first}});
+	BOOST_CHECK_THROW(RecordIndex::load(temporary.path + ".idx", file), Error);
+
+	// the untouched index is loaded
+	std::ofstream(temporary.path + ".idx", std::ios::binary | std::ios::trunc) << saved;
+	BOOST_CHECK_EQUAL(RecordIndex::load(temporary.path + ".idx", file).getRecords(), 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <boost/test/unit_test.hpp>
+#include <az/json/Reader.h>
+#include <random>
+
+using namespace az::json;
+
+namespace {
+
+std::string makeDocument(std::mt19937& random, int depth)
+{
+	std::uniform_int_distribution<int> kind(0, depth > 0 ? 5 : 2);
+	switch (kind(random)) {
+		case 0:
+			return std::to_string(random() % 1000);
+		case 1:
+			return "'text " + std::to_string(random() % 10) + "'";
+		case 2:
+			return "null";
+		case 3:
+		case 4: {
+			std::string text = "{";
+			for (int member = 0, count = int(random() % 5); member < count; member++) {
+				// duplicate keys are allowed, the last one wins
+				text += " k" + std::to_string(random() % 4) + ": " + makeDocument(random, depth - 1) + ",";
+			}
+			return text + "}";
+		}
+		default: {
+			std::string text = "[";
+			for (int element = 0, count = int(random() % 5); element < count; element++) {
+				text += makeDocument(random, depth - 1) + ", ";
+			}
+			return text + "]";
+		}
+	}
+}
+
+} /* namespace */
+
+BOOST_AUTO_TEST_SUITE(SourceMapTests)
+
+BOOST_AUTO_TEST_CASE(reparse_nested_edit)
+{
+	std::string text = "{a: [1, 2, {b: 3}], c: {d: [4]}, e: 5}";
+	Value json;
+	SourceMap map;
+	Reader reader(json);
+	reader.parse(text, map);
+	BOOST_REQUIRE(!map.empty());
+
+	// only [4] is re-parsed
+	reader.reparse(text, {SourceMap::Edit(text.find('4'), 1, "40, 41")}, map);
+	BOOST_CHECK_EQUAL(text, "{a: [1, 2, {b: 3}], c: {d: [40, 41]}, e: 5}");
+	BOOST_CHECK_EQUAL(json, Value({{"a", {1, 2, {{"b", 3}}}}, {"c", {{"d", {40, 41}}}}, {"e", 5}}));
+
+	// the following containers are moved by the previous edit
+	reader.reparse(text, {SourceMap::Edit(text.find('3'), 1, "'x'"), SourceMap::Edit(0, 0, " ")}, map);
+	BOOST_CHECK_EQUAL(json["a"][2]["b"], "x");
+
+	BOOST_REQUIRE_THROW(reader.reparse(text, {SourceMap::Edit(text.find("40"), 0, "[")}, map), Error);
+	BOOST_CHECK(map.empty());
+	BOOST_CHECK_THROW(reader.reparse(text, {SourceMap::Edit(text.size() + 1, 0, "")}, map), Error);
+}
+
+BOOST_AUTO_TEST_CASE(reparse_randomly)
+{
+	std::mt19937 random(2024);
+	const char* pieces[] = {"1", "22", ",", " ", "[", "]", "{", "}", "k1:", "k2: 7", "'s'", "\"", "'", "//", "/*", "*/", "\n", "null", "-"};
+	for (int document = 0; document < 20; document++) {
+		std::string text = makeDocument(random, 5);
+		Value json;
+		SourceMap map;
+		Reader reader(json);
+		reader.withNoThrows().parse(text, map);
+		for (int step = 0; step < 200; step++) {
+			SourceMap::Edit edit;
+			edit.offset = random() % (text.size() + 1);
+			edit.removed = std::min<std::size_t>(random() % 4, text.size() - edit.offset);
+			edit.inserted = pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+			reader.reparse(text, {edit}, map);
+
+			Value expected;
+			Reader full(expected);
+			full.withNoThrows().parse(text);
+			BOOST_REQUIRE_EQUAL(reader.hasErrors(), full.hasErrors());
+			BOOST_REQUIRE_EQUAL(json, expected);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,346 @@
+#include <boost/test/unit_test.hpp>
+#include <az/json/Reader.h>
+#include <az/json/FileSource.h>
+#include <az/json/ReadAheadSource.h>
+#include <az/json/AsyncFileSource.h>
+#include <az/json/CompressedSource.h>
+#include <fstream>
+#include <thread>
+#include <cstdio>
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+using namespace az::json;
+
+namespace {
+
+// provides a text from memory by small blocks
+class MemorySource : public BlockSource
+{
+	std::string text;
+	std::size_t offset = 0;
+	std::size_t failing;
+public:
+	MemorySource(const std::string& text, std::size_t block_size, std::size_t failing = std::string::npos)
+		: BlockSource(block_size), text(text), failing(failing) {}
+
+	std::size_t readBlock(char* buffer, std::size_t size) override {
+		if (offset >= failing) {
+			throw Error("unable to read");
+		}
+		size = std::min(size, text.size() - offset);
+		std::copy(text.begin() + offset, text.begin() + offset + size, buffer);
+		offset += size;
+		return size;
+	}
+};
+
+std::string makeArray(int count)
+{
+	std::string text = "[";
+	for (int index = 0; index < count; index++) {
+		text += (index ? ", " : "") + std::to_string(index);
+	}
+	return text + "]";
+}
+
+// {"numbers": [1, 2, 3], "text": "hello"}
+const std::string gzip_object(
+	"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\xAB\x56\xCA\x2B\xCD\x4D\x4A\x2D\x2A\x56\xB2\x52\x88\x36\xD4\x51"
+	"\x30\xD2\x51\x30\x8E\xD5\x51\x50\x2A\x49\xAD\x28\x01\x0A\x29\x65\xA4\xE6\xE4\xE4\x2B\xD5\x02\x00\x2A\xB2"
+	"\x1F\xDA\x27\x00\x00\x00", 58);
+
+// two members: [1, 2 and , 3]
+const std::string gzip_members(
+	"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\x8B\x36\xD4\x51\x30\x02\x00\xA5\x5C\x72\xAD\x05\x00\x00\x00"
+	"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\xD3\x51\x30\x8E\x05\x00\x03\xC1\x5C\x12\x04\x00\x00\x00", 49);
+
+// an array of 20001 zeros
+const std::string gzip_zeros(
+	"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\xED\xC2\x31\x0D\x00\x00\x08\x03\x30\x2B\x08\xE0\xC0\xCF\x82\x7F"
+	"\x1B\xD8\xE0\x68\xD3\x4C\x97\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA"
+	"\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA"
+	"\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xEA\xAF\x7B\xC5\xB1\xAF\xF8\x63\xEA\x00\x00", 101);
+
+// a zstd frame which keeps the text in a raw block
+std::string makeZstdFrame(const std::string& text)
+{
+	std::string frame("\x28\xB5\x2F\xFD\x20", 5);
+	frame.push_back(char(text.size()));
+	uint32_t header = 1 | uint32_t(text.size() << 3);
+	frame.append({char(header & 0xFF), char((header >> 8) & 0xFF), char(header >> 16)});
+	return frame + text;
+}
+
+} /* namespace */
+
+BOOST_AUTO_TEST_SUITE(SourceTests)
+
+BOOST_AUTO_TEST_CASE(block_source)
+{
+	for (std::size_t block_size : {1, 2, 7, 4096}) {
+		MemorySource source(makeArray(100), block_size);
+		Value json;
+		Reader(json).strictly().parse(source);
+		BOOST_REQUIRE_EQUAL(json.size(), 100);
+		BOOST_CHECK_EQUAL(json[99], 99);
+	}
+
+	MemorySource empty("", 16);
+	Value json;
+	BOOST_CHECK(Reader(json).withNoThrows().parse(empty).hasErrors());
+}
+
+BOOST_AUTO_TEST_CASE(segmented_source)
+{
+	const std::string text = "{\"key\": [1.5e3, 'caf\xC3\xA9', true], other: -0x10}";
+	Value expected;
+	Reader(expected).strictly().parse(text);
+	// splits the text at every pair of positions, so tokens and UTF-8 sequences cross the segments
+	for (std::size_t first = 0; first <= text.size(); first++) {
+		for (std::size_t second = first; second <= text.size(); second++) {
+			Segment segments[] = {
+				{text.data(), first},
+				{text.data() + first, 0},
+				{text.data() + first, second - first},
+				{text.data() + second, text.size() - second},
+				{nullptr, 0}
+			};
+			Value json;
+			Reader(json).strictly().withUtf8Validation().parse(segments, 5);
+			BOOST_REQUIRE_EQUAL(json, expected);
+		}
+	}
+
+	Segment empty[] = {{nullptr, 0}};
+	Value json;
+	BOOST_CHECK(Reader(json).withNoThrows().parse(empty, 1).hasErrors());
+	BOOST_CHECK(Reader(json).withNoThrows().parse(empty, 0).hasErrors());
+
+	// an error is located in the whole text
+	Segment broken[] = {{"[1,", 3}, {" 2,\n", 4}, {" ]]", 3}};
+	Reader reader(json);
+	BOOST_CHECK(reader.withNoThrows().strictly().parse(broken, 3).hasErrors());
+	BOOST_CHECK_EQUAL(reader.getLastError().line(), 2);
+	BOOST_CHECK_EQUAL(reader.getLastError().offset(), 9);
+
+	Segment malformed[] = {{"['\xC3", 3}, {"\x28']", 3}};
+	BOOST_CHECK(reader.withUtf8Validation().parse(malformed, 2).hasErrors());
+	BOOST_CHECK_EQUAL(reader.getLastError().offset(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(read_ahead_source)
+{
+	for (uint32_t blocks : {1, 2, 3}) {
+		for (std::size_t block_size : {1, 3, 1024}) {
+			MemorySource input(makeArray(1000), 1);
+			ReadAheadSource::Options options;
+			options.blocks = blocks;
+			options.block_size = block_size;
+			ReadAheadSource source(input, options);
+			Value json;
+			Reader(json).strictly().withUtf8Validation().parse(source);
+			BOOST_REQUIRE_EQUAL(json.size(), 1000);
+			BOOST_CHECK_EQUAL(json[999], 999);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(read_ahead_source_stops_early)
+{
+	// the parser gives up while the producer is waiting for a free block
+	MemorySource input("[1, }" + std::string(100000, ' '), 1);
+	ReadAheadSource::Options options;
+	options.blocks = 2;
+	options.block_size = 16;
+	ReadAheadSource source(input, options);
+	Value json;
+	BOOST_CHECK(Reader(json).withNoThrows().parse(source).hasErrors());
+}
+
+BOOST_AUTO_TEST_CASE(read_ahead_source_failure)
+{
+	MemorySource input(makeArray(1000), 1, 100);
+	ReadAheadSource::Options options;
+	options.block_size = 10;
+	ReadAheadSource source(input, options);
+	Value json;
+	Reader reader(json);
+	BOOST_CHECK(reader.withNoThrows().parse(source).hasErrors());
+	BOOST_CHECK_EQUAL(reader.getLastError().what(), std::string("unable to read"));
+	// the error points to the lexeme which has been interrupted
+	BOOST_CHECK_GT(reader.getLastError().offset(), 90);
+	BOOST_CHECK_LE(reader.getLastError().offset(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(parse_file)
+{
+	const std::string path = "source-tests.json";
+	std::ofstream(path) << makeArray(100000);
+	for (bool read_ahead : {false, true}) {
+		Value json;
+		Reader(json).withReadAhead(read_ahead).strictly().parseFile(path);
+		BOOST_REQUIRE_EQUAL(json.size(), 100000);
+		BOOST_CHECK_EQUAL(json[99999], 99999);
+	}
+	std::remove(path.c_str());
+
+	Value json;
+	BOOST_CHECK_THROW(Reader(json).parseFile(path), Error);
+	BOOST_CHECK(Reader(json).withNoThrows().parseFile(path).hasErrors());
+}
+
+BOOST_AUTO_TEST_CASE(async_file_source)
+{
+	const int files = 8;
+	std::vector<std::string> paths;
+	for (int file = 0; file < files; file++) {
+		paths.push_back("async-source-tests-" + std::to_string(file) + ".json");
+		std::ofstream(paths.back()) << makeArray(10000 * (file + 1));
+	}
+	AsyncFileSource::Options options;
+	options.blocks = 3;
+	options.block_size = 1000;
+	// the second ring is disabled to check the fallback
+	for (unsigned entries : {4, 0}) {
+		IoRing ring(entries);
+		std::vector<int> sizes(files);
+		std::vector<std::thread> threads;
+		for (int file = 0; file < files; file++) {
+			threads.emplace_back([&, file] {
+				AsyncFileSource source(ring, paths[file], options);
+				Value json;
+				Reader(json).withNoThrows().strictly().parse(source);
+				sizes[file] = json.size();
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		for (int file = 0; file < files; file++) {
+			BOOST_CHECK_EQUAL(sizes[file], 10000 * (file + 1));
+		}
+
+		// the source is destroyed while its reads are still in flight
+		AsyncFileSource source(ring, paths.back(), options);
+		BOOST_CHECK_EQUAL(source.getCharacter(), '[');
+		BOOST_CHECK_EQUAL(source.isAsynchronous(), ring.isAvailable());
+	}
+	for (const auto& path : paths) {
+		std::remove(path.c_str());
+	}
+
+	IoRing ring;
+	BOOST_CHECK_THROW(AsyncFileSource(ring, "async-source-tests.missing"), Error);
+}
+
+BOOST_AUTO_TEST_CASE(detect_compression)
+{
+	BOOST_CHECK(detectCompression(gzip_object.data(), gzip_object.size()) == Compression::Gzip);
+	auto frame = makeZstdFrame("[]");
+	BOOST_CHECK(detectCompression(frame.data(), frame.size()) == Compression::Zstd);
+	BOOST_CHECK(detectCompression("{}", 2) == Compression::None);
+	BOOST_CHECK(detectCompression("\x1F", 1) == Compression::None);
+}
+
+BOOST_AUTO_TEST_CASE(gzip_source)
+{
+	if (!GzipSource::isSupported()) {
+		MemorySource input(gzip_object, 16);
+		BOOST_CHECK_THROW(GzipSource source(input), Error);
+		return;
+	}
+	for (std::size_t block_size : {1, 5, 4096}) {
+		MemorySource input(gzip_object, block_size);
+		GzipSource source(input, block_size);
+		Value json;
+		Reader(json).strictly().parse(source);
+		BOOST_CHECK_EQUAL(json, Value({{"numbers", {1, 2, 3}}, {"text", "hello"}}));
+
+		MemorySource members_input(gzip_members, block_size);
+		GzipSource members(members_input, block_size);
+		Reader(json).strictly().parse(members);
+		BOOST_CHECK_EQUAL(json, Value({1, 2, 3}));
+	}
+
+	// the output is much larger than the compressed data and the buffers
+	MemorySource input(gzip_zeros, 16);
+	GzipSource source(input, 1000);
+	Value json;
+	Reader(json).strictly().parse(source);
+	BOOST_REQUIRE_EQUAL(json.size(), 20001);
+
+	MemorySource truncated_input(gzip_object.substr(0, 40), 16);
+	GzipSource truncated(truncated_input);
+	BOOST_CHECK(Reader(json).withNoThrows().parse(truncated).hasErrors());
+	MemorySource malformed_input(gzip_object.substr(0, 12) + "garbage", 16);
+	GzipSource malformed(malformed_input);
+	BOOST_CHECK(Reader(json).withNoThrows().parse(malformed).hasErrors());
+}
+
+BOOST_AUTO_TEST_CASE(zstd_source)
+{
+	auto frames = makeZstdFrame("[1, 2") + makeZstdFrame(", 3]");
+	if (!ZstdSource::isSupported()) {
+		MemorySource input(frames, 16);
+		BOOST_CHECK_THROW(ZstdSource source(input), Error);
+		return;
+	}
+	for (std::size_t block_size : {1, 5, 4096}) {
+		MemorySource input(frames, block_size);
+		ZstdSource source(input, block_size);
+		Value json;
+		Reader(json).strictly().parse(source);
+		BOOST_CHECK_EQUAL(json, Value({1, 2, 3}));
+	}
+	MemorySource truncated_input(frames.substr(0, 10), 16);
+	ZstdSource truncated(truncated_input);
+	Value json;
+	BOOST_CHECK(Reader(json).withNoThrows().parse(truncated).hasErrors());
+}
+
+BOOST_AUTO_TEST_CASE(parse_compressed_file)
+{
+	const std::string path = "source-tests.json.gz";
+	std::ofstream(path, std::ios::binary) << gzip_zeros;
+	for (bool read_ahead : {false, true}) {
+		Value json;
+		Reader reader(json);
+		reader.withNoThrows().withReadAhead(read_ahead).parseFile(path);
+		BOOST_CHECK_EQUAL(reader.hasErrors(), !GzipSource::isSupported());
+		BOOST_CHECK_EQUAL(json.size(), GzipSource::isSupported() ? 20001 : 0);
+	}
+	std::ofstream(path, std::ios::binary) << makeZstdFrame("{\"zstd\": true}");
+	Value json;
+	Reader reader(json);
+	reader.withNoThrows().parseFile(path);
+	BOOST_CHECK_EQUAL(reader.hasErrors(), !ZstdSource::isSupported());
+	std::remove(path.c_str());
+}
+
+#ifdef __unix__
+BOOST_AUTO_TEST_CASE(parse_file_from_pipe)
+{
+	// a pipe is read once, so the bytes which tell the compression must reach the parser as well
+	for (const std::string& text : {std::string("{\"a\":[1,2,3]}"), gzip_object}) {
+		int ends[2];
+		BOOST_REQUIRE_EQUAL(pipe(ends), 0);
+		BOOST_REQUIRE_EQUAL(write(ends[1], text.data(), text.size()), ssize_t(text.size()));
+		close(ends[1]);
+		Value json;
+		Reader reader(json);
+		reader.withNoThrows().parseFile("/dev/fd/" + std::to_string(ends[0]));
+		close(ends[0]);
+		if (text == gzip_object && !GzipSource::isSupported()) {
+			BOOST_CHECK(reader.hasErrors());
+			continue;
+		}
+		BOOST_REQUIRE(!reader.hasErrors());
+		const Value& object = json;
+		BOOST_CHECK_EQUAL(object[text == gzip_object ? "numbers" : "a"], Value({1, 2, 3}));
+	}
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
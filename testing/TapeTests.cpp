@@ -0,0 +1,221 @@
+#include <boost/test/unit_test.hpp>
+#include <az/json/Tape.h>
+#include <az/json/Reader.h>
+#include <az/json/Path.h>
+#include <az/json/SourceMap.h>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char* text = R"({
+	name: "tape",
+	'escaped': "line\nbreak é",
+	count: 42,
+	ratio: -0.5,
+	hex: 0xFF,
+	flags: [true, false, null, NaN],
+	nested: {list: [[], {}, [1, [2, 3]]], empty: ""},
+	last: "done"
+})";
+
+} /* namespace */
+
+BOOST_AUTO_TEST_SUITE(TapeTests)
+
+BOOST_AUTO_TEST_CASE(parse_into_tape)
+{
+	az::json::Tape tape;
+	az::json::Reader(tape).parse(text);
+	BOOST_REQUIRE(!tape.empty());
+	auto root = tape.getRoot();
+	BOOST_REQUIRE(root.isObject());
+	BOOST_CHECK_EQUAL(root.size(), 8);
+	BOOST_CHECK_EQUAL(root["name"].asString(), "tape");
+	BOOST_CHECK_EQUAL(root["escaped"].asString(), "line\nbreak \xc3\xa9");
+	BOOST_CHECK_EQUAL(std::strlen(root["escaped"].getStringData()), root["escaped"].getStringSize());
+	BOOST_CHECK(root["count"].isInteger());
+	BOOST_CHECK_EQUAL(root["count"].asInteger(), 42);
+	BOOST_CHECK_EQUAL(root["count"].asString(), "42");
+	BOOST_CHECK(root["ratio"].isReal());
+	BOOST_CHECK(root["ratio"].isNegative());
+	BOOST_CHECK_EQUAL(root["ratio"].asReal(), -0.5);
+	BOOST_CHECK_EQUAL(root["hex"].asInteger(), 255);
+	BOOST_CHECK_EQUAL(root["flags"].size(), 4);
+	BOOST_CHECK(root["flags"][0].asBool());
+	BOOST_CHECK(root["flags"][1].isBool());
+	BOOST_CHECK(!root["flags"][1].asBool());
+	BOOST_CHECK(root["flags"][2].isNull());
+	BOOST_CHECK(root["flags"][2]);
+	BOOST_CHECK(std::isnan(root["flags"][3].asReal()));
+	BOOST_CHECK(root["nested"]["list"][0].isArray());
+	BOOST_CHECK(root["nested"]["list"][0].empty());
+	BOOST_CHECK(root["nested"]["list"][1].isObject());
+	BOOST_CHECK_EQUAL(root["nested"]["list"][2][1][1].asInteger(), 3);
+	BOOST_CHECK(root["nested"]["empty"].isString());
+	BOOST_CHECK(root["nested"]["empty"].empty());
+	BOOST_CHECK_EQUAL(root["last"].asString(), "done");
+
+	// missing members and elements refer to no value
+	BOOST_CHECK(!root["missing"]);
+	BOOST_CHECK(root["missing"].isNull());
+	BOOST_CHECK(!root["flags"][4]);
+	BOOST_CHECK(!root["name"]["deeper"]);
+	BOOST_CHECK(root.has("last"));
+	BOOST_CHECK(!root.has("lost"));
+	BOOST_CHECK(root["flags"].has(3));
+	BOOST_CHECK(!root["flags"].has(4));
+
+	// the tape holds the same tree as a value does
+	az::json::Value value;
+	az::json::Reader(value).parse(text);
+	BOOST_CHECK_EQUAL(root["nested"].toValue(), value["nested"]);
+	BOOST_CHECK_EQUAL(root.toValue().stringify(false), value.stringify(false));
+}
+
+BOOST_AUTO_TEST_CASE(iterate_tape)
+{
+	az::json::Tape tape;
+	az::json::Reader(tape).parse("{b: [1, {x: 2}, 3], a: 'text', c: {}}");
+	auto root = tape.getRoot();
+	// members are kept in the order of the text
+	std::vector<std::string> keys;
+	for (auto member = root.begin(); member != root.end(); ++member) {
+		BOOST_CHECK(member.isObject());
+		keys.push_back(member.key());
+	}
+	BOOST_CHECK((keys == std::vector<std::string>{"b", "a", "c"}));
+	int64_t sum = 0;
+	for (auto element : root["b"]) {
+		sum += element.isInteger() ? element.asInteger() : element["x"].asInteger();
+	}
+	BOOST_CHECK_EQUAL(sum, 6);
+	BOOST_CHECK(root["c"].begin() == root["c"].end());
+	BOOST_CHECK(root["a"].begin() == root["a"].end());
+}
+
+BOOST_AUTO_TEST_CASE(index_large_array)
+{
+	// elements of different sizes, so positions of elements can not be computed from their indices
+	std::string text = "[";
+	for (int index = 0; index < 1000; index++) {
+		text += (index % 3 == 0) ? "null," : (index % 3 == 1) ? std::to_string(index) + "," : "[" + std::to_string(index) + ", {}],";
+	}
+	text += "true]";
+	az::json::Tape tape;
+	az::json::Reader(tape).parse(text);
+	auto root = tape.getRoot();
+	BOOST_REQUIRE_EQUAL(root.size(), 1001);
+	for (int index = 0; index < 1000; index++) {
+		const auto element = root[index];
+		if (index % 3 == 0) {
+			BOOST_REQUIRE(element.isNull());
+		}
+		else if (index % 3 == 1) {
+			BOOST_REQUIRE_EQUAL(element.asInteger(), index);
+		}
+		else {
+			BOOST_REQUIRE_EQUAL(element[0].asInteger(), index);
+		}
+	}
+	BOOST_CHECK(root[1000].asBool());
+	BOOST_CHECK(!root[1001]);
+	// positions of elements are not iterated
+	std::size_t count = 0;
+	for (auto element : root) {
+		(void)element;
+		count++;
+	}
+	BOOST_CHECK_EQUAL(count, 1001);
+}
+
+BOOST_AUTO_TEST_CASE(repeated_keys_on_tape)
+{
+	az::json::Tape tape;
+	az::json::Reader(tape).parse("{key: 1, other: 2, key: 3}");
+	// the last member wins as it does in a value
+	BOOST_CHECK_EQUAL(tape.getRoot()["key"].asInteger(), 3);
+	BOOST_CHECK_EQUAL(tape.getRoot().toValue(), az::json::Value({{"key", 3}, {"other", 2}}));
+
+	// a repeated key is kept once in its first place
+	az::json::Reader(tape).parse("{key: [1, [2]], other: {a: 1}, key: 'last', other: 'x', key: {b: [3, 4]}, end: null}");
+	auto root = tape.getRoot();
+	BOOST_CHECK_EQUAL(root.size(), 3);
+	std::vector<std::string> keys;
+	for (auto member = root.begin(); member != root.end(); ++member) {
+		keys.push_back(member.key());
+	}
+	BOOST_CHECK((keys == std::vector<std::string>{"key", "other", "end"}));
+	BOOST_CHECK_EQUAL(root["key"]["b"][1].asInteger(), 4);
+	BOOST_CHECK_EQUAL(root["other"].asString(), "x");
+	BOOST_CHECK(root["end"].isNull());
+
+	std::string text = "{";
+	for (int index = 0; index < 100; index++) {
+		text += "k" + std::to_string(index % 40) + ": " + std::to_string(index) + ", ";
+	}
+	text += "}";
+	az::json::Reader(tape).parse(text);
+	root = tape.getRoot();
+	BOOST_REQUIRE_EQUAL(root.size(), 40);
+	BOOST_CHECK_EQUAL(root.begin().key(), "k0");
+	for (int index = 0; index < 40; index++) {
+		BOOST_CHECK_EQUAL(root["k" + std::to_string(index)].asInteger(), index + (index < 20 ? 80 : 40));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(resolve_path_on_tape)
+{
+	az::json::Tape tape;
+	az::json::Reader(tape).parse(text);
+	auto root = tape.getRoot();
+	BOOST_CHECK_EQUAL(az::json::Path("nested.list[2][1][0]").resolve(root).asInteger(), 2);
+	BOOST_CHECK_EQUAL(az::json::Path(".'escaped'").resolve(root).asString(), "line\nbreak \xc3\xa9");
+	BOOST_CHECK(!az::json::Path("nested.missing[0]").resolve(root));
+	BOOST_CHECK(!az::json::Path("flags[10]").resolve(root));
+}
+
+BOOST_AUTO_TEST_CASE(scalar_tape)
+{
+	az::json::Tape tape;
+	az::json::Reader(tape).parse("\"a long string which is kept in the buffer\"");
+	BOOST_CHECK_EQUAL(tape.getRoot().asString(), "a long string which is kept in the buffer");
+	az::json::Reader(tape).parse("-12");
+	BOOST_CHECK_EQUAL(tape.getRoot().asInteger(), -12);
+	BOOST_CHECK_EQUAL(tape.getRoot().asBool(), true);
+	az::json::Reader(tape).parse("null");
+	BOOST_CHECK(tape.getRoot());
+	BOOST_CHECK(tape.getRoot().isNull());
+	BOOST_CHECK_GT(tape.getMemory(), 0);
+	tape.clear();
+	BOOST_CHECK(!tape.getRoot());
+}
+
+BOOST_AUTO_TEST_CASE(tape_errors)
+{
+	az::json::Tape tape;
+	az::json::Reader(tape).parse("[1, 2]");
+	BOOST_CHECK_THROW(az::json::Reader(tape).parse("[1, {a: 2"), az::json::Error);
+	BOOST_CHECK(tape.empty());
+
+	az::json::Reader reader(tape);
+	reader.withNoThrows().parse("[1e999]");
+	BOOST_CHECK(reader.hasErrors());
+	BOOST_CHECK(tape.empty());
+
+	reader.parse("[1, 2]");
+	BOOST_CHECK(!reader.hasErrors());
+	// validation leaves the tape untouched
+	reader.validate("[3]");
+	BOOST_CHECK_EQUAL(tape.getRoot().size(), 2);
+
+	// limits are applied as they are to values
+	az::json::Reader::Limits limits;
+	limits.depth = 2;
+	BOOST_CHECK_THROW(az::json::Reader(tape).withLimits(limits).parse("[[[1]]]"), az::json::Error);
+
+	az::json::SourceMap map;
+	BOOST_CHECK_THROW(az::json::Reader(tape).parse(std::string("[1]"), map), az::json::Error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#include <boost/test/unit_test.hpp>
+#include <az/json/Utf8Validator.h>
+#include <string>
+
+using az::json::Utf8Validator;
+
+BOOST_AUTO_TEST_SUITE(Utf8ValidatorTests)
+
+BOOST_AUTO_TEST_CASE(validate_ascii)
+{
+	std::string text(1000, 'a');
+	BOOST_CHECK_EQUAL(Utf8Validator::validate(text.data(), text.size()), Utf8Validator::npos);
+	BOOST_CHECK_EQUAL(Utf8Validator::validate(text.data(), 0), Utf8Validator::npos);
+}
+
+BOOST_AUTO_TEST_CASE(validate_well_formed_sequences)
+{
+	const std::string sequences[] = {
+		"\xC2\x80", "\xDF\xBF", // 2 bytes
+		"\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80", "\xEF\xBF\xBF", // 3 bytes
+		"\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF" // 4 bytes
+	};
+	for (const auto& sequence : sequences) {
+		// checks the sequence at every position of the blocks
+		for (std::size_t prefix = 0; prefix < 40; prefix++) {
+			std::string text = std::string(prefix, 'x') + sequence + std::string(20, 'y');
+			BOOST_CHECK_EQUAL(Utf8Validator::validate(text.data(), text.size()), Utf8Validator::npos);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(validate_malformed_sequences)
+{
+	const std::string sequences[] = {
+		"\x80", "\xBF", // lonely continuations
+		"\xC0\x80", "\xC1\xBF", // overlong 2 bytes
+		"\xE0\x9F\xBF", // overlong 3 bytes
+		"\xED\xA0\x80", "\xED\xBF\xBF", // surrogates
+		"\xF0\x8F\xBF\xBF", // overlong 4 bytes
+		"\xF4\x90\x80\x80", "\xF5\x80\x80\x80", // too large
+		"\xC2\x41", "\xE2\x82\x41", "\xF0\x9F\x98\x41", // too short
+		"\xFE", "\xFF"
+	};
+	for (const auto& sequence : sequences) {
+		for (std::size_t prefix = 0; prefix < 40; prefix++) {
+			std::string text = std::string(prefix, 'x') + sequence + std::string(20, 'y');
+			BOOST_CHECK_EQUAL(Utf8Validator::validate(text.data(), text.size()), prefix);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(validate_truncated_text)
+{
+	for (std::size_t prefix = 0; prefix < 40; prefix++) {
+		std::string text = std::string(prefix, 'x') + "\xF0\x9F\x98";
+		BOOST_CHECK_EQUAL(Utf8Validator::validate(text.data(), text.size()), prefix);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(validate_mixed_text)
+{
+	std::string text;
+	for (int index = 0; index < 100; index++) {
+		text += "ascii \xC2\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 ";
+	}
+	BOOST_CHECK_EQUAL(Utf8Validator::validate(text.data(), text.size()), Utf8Validator::npos);
+	text[text.size() / 2] = char(0xFF);
+	auto offset = Utf8Validator::validate(text.data(), text.size());
+	BOOST_REQUIRE_NE(offset, Utf8Validator::npos);
+	BOOST_CHECK_LE(offset, text.size() / 2);
+	BOOST_CHECK_GE(offset + 3, text.size() / 2);
+}
+
+BOOST_AUTO_TEST_CASE(feed_split_sequences)
+{
+	std::string text = "ab\xF0\x9F\x98\x80" "cd\xE2\x82\xAC";
+	for (std::size_t split = 0; split <= text.size(); split++) {
+		Utf8Validator validator;
+		BOOST_CHECK(validator.feed(text.data(), split));
+		BOOST_CHECK(validator.feed(text.data() + split, text.size() - split));
+		BOOST_CHECK(validator.finish());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(feed_malformed_pieces)
+{
+	Utf8Validator validator;
+	BOOST_CHECK(validator.feed("abc\xE2\x82", 5));
+	BOOST_CHECK(!validator.feed("\x41", 1));
+	BOOST_CHECK(validator.isMalformed());
+	BOOST_CHECK_EQUAL(validator.getOffset(), 3);
+
+	Utf8Validator truncated;
+	BOOST_CHECK(truncated.feed("abc\xE2\x82", 5));
+	BOOST_CHECK(!truncated.finish());
+	BOOST_CHECK_EQUAL(truncated.getOffset(), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
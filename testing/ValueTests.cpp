@@ -1,5 +1,28 @@
 #include <boost/test/unit_test.hpp>
 #include <az/json/Value.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <type_traits>
+#include <thread>
+
+struct CountingResource : public az::json::MemoryResource {
+	std::size_t allocations = 0;
+	std::size_t deallocations = 0;
+	std::size_t used = 0;
+
+protected:
+	void* doAllocate(std::size_t size, std::size_t) override {
+		allocations++;
+		used += size;
+		return ::operator new(size);
+	}
+	void doDeallocate(void* memory, std::size_t size, std::size_t) override {
+		deallocations++;
+		used -= size;
+		::operator delete(memory);
+	}
+};
 
 BOOST_AUTO_TEST_SUITE(ValueTests)
 
@@ -78,6 +101,34 @@ BOOST_AUTO_TEST_CASE(make_string_from_std_string)
 	BOOST_CHECK_EQUAL(json.size(), 3);
 }
 
+BOOST_AUTO_TEST_CASE(make_short_and_long_strings)
+{
+	const std::string short_string(az::json::Value::small_capacity, 's');
+	const std::string long_string(az::json::Value::small_capacity + 1, 'l');
+	az::json::Value json{short_string, long_string, std::string("a\0b", 3), "", "42"};
+	BOOST_CHECK_EQUAL(json[0].asString(), short_string);
+	BOOST_CHECK_EQUAL(json[1].asString(), long_string);
+	BOOST_CHECK_EQUAL(json[2].size(), 3);
+	BOOST_CHECK(json[3].empty());
+	BOOST_CHECK_EQUAL(json[4].asInteger(), 42);
+
+	// copies, moves and swaps keep both representations
+	az::json::Value copy = json;
+	BOOST_CHECK_EQUAL(copy, json);
+	az::json::Value moved = std::move(copy[1]);
+	BOOST_CHECK_EQUAL(moved, long_string);
+	moved.swap(copy[0]);
+	BOOST_CHECK_EQUAL(moved, short_string);
+	BOOST_CHECK_EQUAL(copy[0], long_string);
+	copy[0] = copy[0];
+	BOOST_CHECK_EQUAL(copy[0], long_string);
+
+	// strings are ordered by their bytes as std::string does
+	BOOST_CHECK_LT(az::json::Value("ab"), az::json::Value("abc"));
+	BOOST_CHECK_LT(az::json::Value("a"), az::json::Value("\xC3\xA9"));
+	BOOST_CHECK_LT(az::json::Value(long_string), az::json::Value(short_string));
+}
+
 BOOST_AUTO_TEST_CASE(make_array_from_initlist)
 {
 	az::json::Value json = {
@@ -170,6 +221,31 @@ BOOST_AUTO_TEST_CASE(append_several_to_not_array)
 	BOOST_CHECK_EQUAL(json[2], az::json::Value("3"));
 }
 
+BOOST_AUTO_TEST_CASE(emplace_to_reserved_array)
+{
+	az::json::Value json = "not array";
+	BOOST_CHECK_EQUAL(json.capacity(), 0);
+	json.reserve(100);
+	BOOST_REQUIRE(json.isArray());
+	BOOST_CHECK(json.empty());
+	BOOST_CHECK_GE(json.capacity(), json.size());
+
+	auto& first = json.emplace(1);
+	json.emplace("two");
+	json.emplace(az::json::Value::Type::Object)["three"] = 3;
+	BOOST_REQUIRE_EQUAL(json.size(), 3);
+	BOOST_CHECK_EQUAL(json, az::json::Value({1, "two", {{"three", 3}}}));
+#ifndef AZ_JSON_STABLE_ARRAYS
+	// the reserved array does not move its elements
+	BOOST_CHECK_EQUAL(json.capacity(), 100);
+	BOOST_CHECK_EQUAL(&first, &json[0]);
+#endif
+	BOOST_CHECK_EQUAL(first, 1);
+	json.shrinkToFit();
+	BOOST_CHECK_GE(json.capacity(), 3);
+	BOOST_CHECK_EQUAL(json[1], "two");
+}
+
 BOOST_AUTO_TEST_CASE(make_object_from_empty_initlist)
 {
 	az::json::Value json({});
@@ -588,4 +664,383 @@ BOOST_AUTO_TEST_CASE(iterate_null)
 	BOOST_CHECK_EQUAL(counter, 0);
 }
 
+BOOST_AUTO_TEST_CASE(iterate_object_in_insertion_order)
+{
+	az::json::Value json = az::json::Object(az::json::Object::Order::Insertion);
+	json["string"] = "coffee";
+	json["integer"] = 123;
+	json["bool"] = false;
+	json["integer"] = 321;
+
+	std::list<std::string> keys;
+	for (auto it = json.begin(); it != json.end(); it++) {
+		keys.push_back(it.key());
+	}
+	std::list<std::string> expected_keys = {"string", "integer", "bool"};
+	BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected_keys.begin(), expected_keys.end());
+	BOOST_CHECK_EQUAL(json["integer"], 321);
+	BOOST_CHECK(json.getObject().getOrder() == az::json::Object::Order::Insertion);
+}
+
+BOOST_AUTO_TEST_CASE(compare_objects_in_different_orders)
+{
+	az::json::Value sorted = {{"b", 2}, {"a", 1}};
+	az::json::Value inserted = az::json::Object(az::json::Object::Order::Insertion);
+	inserted["b"] = 2;
+	inserted["a"] = 1;
+	BOOST_CHECK_EQUAL(sorted.getObject().begin()->first, "a");
+	BOOST_CHECK_EQUAL(inserted.getObject().begin()->first, "b");
+	BOOST_CHECK_EQUAL(sorted, inserted);
+	BOOST_CHECK(!(sorted < inserted) && !(inserted < sorted));
+
+	inserted["a"] = 0;
+	BOOST_CHECK_NE(sorted, inserted);
+	BOOST_CHECK(inserted < sorted);
+}
+
+BOOST_AUTO_TEST_CASE(find_members_of_large_objects)
+{
+	const std::size_t size = 1000;
+	for (auto order : {az::json::Object::Order::Sorted, az::json::Object::Order::Insertion}) {
+		az::json::Value json = az::json::Object(order);
+		for (std::size_t i = 0; i < size; i++) {
+			json["key" + std::to_string(size - i)] = int(i);
+		}
+		BOOST_CHECK_EQUAL(json.size(), size);
+		const auto& object = json.getObject();
+		for (std::size_t i = 0; i < size; i++) {
+			const auto key = "key" + std::to_string(size - i);
+			BOOST_REQUIRE(object.find(key) != object.end());
+			BOOST_CHECK_EQUAL(object.at(key), int(i));
+		}
+		BOOST_CHECK(object.find("key0") == object.end());
+		BOOST_CHECK_EQUAL(object.count("key") + object.count("key1001"), 0);
+		BOOST_CHECK_THROW(object.at("key0"), std::out_of_range);
+		if (order == az::json::Object::Order::Insertion) {
+			BOOST_CHECK_EQUAL(object.begin()->first, "key1000");
+		} else {
+			BOOST_CHECK_EQUAL(object.begin()->first, "key1");
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(find_members_of_hashed_objects)
+{
+	for (auto order : {az::json::Object::Order::Sorted, az::json::Object::Order::Insertion}) {
+		az::json::Object object(order, az::json::Object::Lookup::Hashed);
+		object.reserve(100);
+		BOOST_CHECK_GE(object.capacity(), 100);
+		for (int i = 0; i < 100; i++) {
+			object[std::to_string(i * 7 % 100)] = i;
+		}
+		BOOST_CHECK_EQUAL(object.size(), 100);
+		for (int i = 0; i < 100; i++) {
+			BOOST_CHECK_EQUAL(object.at(std::to_string(i * 7 % 100)), i);
+		}
+		BOOST_CHECK(!object.emplace("7", 0));
+		BOOST_CHECK_EQUAL(object.count("100"), 0);
+		// members inserted out of order are found by the index and read in the order of the object
+		if (order == az::json::Object::Order::Sorted) {
+			BOOST_CHECK_EQUAL(object.begin()->first, "0");
+			BOOST_CHECK_EQUAL((--object.end())->first, "99");
+		}
+		else {
+			BOOST_CHECK_EQUAL((--object.end())->first, "93");
+		}
+		BOOST_CHECK(object.emplace("05", 5));
+		BOOST_CHECK_EQUAL(object.at("05"), 5);
+		BOOST_CHECK_EQUAL(object.at("6"), 58);
+
+		object.clear();
+		BOOST_CHECK(object.find("7") == object.end());
+		object["7"] = 7;
+		BOOST_CHECK_EQUAL(object.at("7"), 7);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(insert_into_large_sorted_object)
+{
+	// keys are inserted out of order, so a sorted object would shift its members on every insert
+	const int size = 20000;
+	az::json::Value json;
+	for (int i = 0; i < size; i++) {
+		json["key" + std::to_string(i * 7919 % size)] = i;
+		if (i % 5000 == 0) {
+			// members are found while they are out of order
+			BOOST_REQUIRE_EQUAL(json["key0"], 0);
+		}
+	}
+	BOOST_REQUIRE_EQUAL(json.size(), std::size_t(size));
+	const auto& view = json;
+	BOOST_CHECK_EQUAL(view["key7919"], 1);
+	// members are read in the order of their keys
+	const auto& object = json.getObject();
+	BOOST_CHECK(std::is_sorted(object.begin(), object.end(), [](const az::json::Object::value_type& left, const az::json::Object::value_type& right) {
+		return left.first < right.first;
+	}));
+	BOOST_CHECK_EQUAL(object.begin()->first, "key0");
+
+	// the members are found at their new positions, and inserting goes on after sorting
+	json["key" + std::to_string(size)] = size;
+	json["a"] = -1;
+	for (int i = 0; i < size; i++) {
+		BOOST_REQUIRE_EQUAL(view["key" + std::to_string(i * 7919 % size)], i);
+	}
+	BOOST_CHECK_EQUAL(view.begin().key(), "a");
+
+	// objects are compared and copied in order
+	az::json::Value ordered;
+	ordered["a"] = -1;
+	for (int i = 0; i <= size; i++) {
+		ordered["key" + std::to_string(i)] = json["key" + std::to_string(i)];
+	}
+	const az::json::Value copy = json.clone();
+	BOOST_CHECK(copy == ordered);
+	BOOST_CHECK(!(copy < ordered) && !(ordered < copy));
+	json["zero"] = 0;
+	json["b"] = 1;
+	BOOST_CHECK_EQUAL(json.stringify(false).substr(0, 13), "{\"a\":-1,\"b\":1");
+
+	// the first readers of an unsorted object wait until one of them sorts it
+	json["c"] = 2;
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < 4; thread++) {
+		threads.emplace_back([&view, &mismatches]() {
+			if (view.begin().key() != "a" || view["c"] != 2 || view["key1"] != 17679) {
+				mismatches++;
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	BOOST_CHECK_EQUAL(mismatches.load(), 0);
+}
+
+#ifdef AZ_JSON_STABLE_MEMBERS
+BOOST_AUTO_TEST_CASE(keep_references_to_members)
+{
+	const az::json::Object objects[] = {
+		az::json::Object(),
+		az::json::Object(az::json::Object::Order::Sorted, az::json::Object::Lookup::Hashed),
+		az::json::Object(az::json::Object::Order::Insertion)
+	};
+	// small and large objects, the keys are inserted before the first one and sorted by reading in order
+	for (const auto& object : objects) {
+		for (int size : {8, 100, 1000}) {
+			az::json::Value json = object;
+			auto& first = json["m"];
+			first = -1;
+			for (int i = 0; i < size; i++) {
+				json["key" + std::to_string(i * 7919 % size)] = i;
+			}
+			const auto& view = json;
+			BOOST_CHECK_EQUAL(view.begin().key(), object.getOrder() == az::json::Object::Order::Sorted ? "key0" : "m");
+			BOOST_CHECK_EQUAL(&first, &json["m"]);
+			BOOST_CHECK_EQUAL(first, -1);
+		}
+	}
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(reserve_object)
+{
+	az::json::Value json({});
+	json.reserve(1000);
+	BOOST_CHECK(json.isObject());
+	BOOST_CHECK_GE(json.capacity(), 1000);
+	for (int i = 0; i < 1000; i++) {
+		json["key" + std::to_string(i)] = i;
+	}
+	BOOST_CHECK_EQUAL(json.size(), 1000);
+	BOOST_CHECK_EQUAL(json["key999"], 999);
+}
+
+BOOST_AUTO_TEST_CASE(copy_on_write)
+{
+	az::json::Value json = {
+		{"array", {1, 2, 3}},
+		{"string", "a string which is too long to be kept inside"}
+	};
+	az::json::Value copy = json;
+	BOOST_CHECK_EQUAL(&copy.getObject(), &json.getObject());
+	BOOST_CHECK_EQUAL(&copy["array"].getArray(), &json["array"].getArray());
+
+	copy["array"].append(4);
+	copy["string"] = "other";
+	BOOST_CHECK_NE(&copy.getObject(), &json.getObject());
+	BOOST_CHECK_EQUAL(json["array"].size(), 3);
+	BOOST_CHECK_EQUAL(copy["array"].size(), 4);
+	BOOST_CHECK_EQUAL(json["string"], "a string which is too long to be kept inside");
+
+	// a value may be assigned from its own part
+	copy = copy["array"];
+	BOOST_CHECK_EQUAL(copy, az::json::Value({1, 2, 3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(copy_after_reference)
+{
+	// a reference which is kept while the value is copied modifies the value only
+	az::json::Value object = {{"x", 1}, {"y", 2}};
+	az::json::Value& x = object["x"];
+	const az::json::Value object_snapshot = object;
+	x = 99;
+	BOOST_CHECK_EQUAL(object["x"], 99);
+	BOOST_CHECK_EQUAL(object_snapshot["x"], 1);
+	BOOST_CHECK_NE(&object_snapshot.getObject(), &object.getObject());
+
+	az::json::Value array = {1, 2, 3};
+	array.reserve(4);
+	az::json::Value& last = array.append(4);
+	az::json::Value& first = array[0];
+	const az::json::Value array_snapshot = array;
+	first = 99;
+	last = "last";
+	BOOST_CHECK_EQUAL(array, az::json::Value({99, 2, 3, "last"}));
+	BOOST_CHECK_EQUAL(array_snapshot, az::json::Value({1, 2, 3, 4}));
+
+	// values which have not handed out references are still shared
+	const az::json::Value parsed = az::json::Value({{"list", {1, 2}}});
+	az::json::Value shared = parsed;
+	BOOST_CHECK_EQUAL(&shared.getObject(), &parsed.getObject());
+}
+
+BOOST_AUTO_TEST_CASE(clone_value)
+{
+	const az::json::Value json = {
+		{"array", {1, {{"key", "value"}}}},
+		{"string", "a string which is too long to be kept inside"}
+	};
+	const auto copy = json.clone();
+	BOOST_CHECK_EQUAL(copy, json);
+	BOOST_CHECK_NE(&copy.getObject(), &json.getObject());
+	BOOST_CHECK_NE(&copy["array"].getArray(), &json["array"].getArray());
+	BOOST_CHECK_NE(&copy["array"][1].getObject(), &json["array"][1].getObject());
+}
+
+BOOST_AUTO_TEST_CASE(copy_shared_value_in_threads)
+{
+	az::json::Value json;
+	for (int i = 0; i < 100; i++) {
+		json["key" + std::to_string(i)] = {i, "a string which is too long to be kept inside"};
+	}
+	const az::json::Value& shared = json;
+	std::vector<std::thread> threads;
+	std::atomic<int> mismatches(0);
+	for (int thread = 0; thread < 4; thread++) {
+		threads.emplace_back([&shared, &mismatches, thread]() {
+			for (int i = 0; i < 1000; i++) {
+				az::json::Value copy = shared;
+				copy["key" + std::to_string(i % 100)].append(thread);
+				if (shared["key" + std::to_string(i % 100)].size() != 2 || copy.get("key0")[0] != 0) {
+					mismatches++;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	BOOST_CHECK_EQUAL(mismatches.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(find_without_copying)
+{
+	const az::json::Value json = {
+		{"array", {1, 2}},
+		{"string", "value"}
+	};
+	BOOST_REQUIRE(json.find("array") != nullptr);
+	BOOST_CHECK_EQUAL(json.find("array"), &json["array"]);
+	BOOST_CHECK_EQUAL(json.find("string-key", 6), &json["string"]);
+	BOOST_CHECK_EQUAL(json.find(std::string("string")), &json["string"]);
+	BOOST_CHECK(json.find("missing") == nullptr);
+	BOOST_CHECK(json.find(0) == nullptr);
+	BOOST_CHECK_EQUAL(json["array"].find(1), &json["array"][1]);
+	BOOST_CHECK(json["array"].find(2) == nullptr);
+	BOOST_CHECK(json["array"].find("key") == nullptr);
+
+	const az::json::Value fallback = "fallback";
+	BOOST_CHECK_EQUAL(&json.lookup("string"), &json["string"]);
+	BOOST_CHECK_EQUAL(&json.lookup("missing", fallback), &fallback);
+	BOOST_CHECK_EQUAL(&json["array"].lookup(5, fallback), &fallback);
+	BOOST_CHECK(json.lookup("missing").isNull());
+	BOOST_CHECK(json.has("array") && !json.has("missing"));
+}
+
+BOOST_AUTO_TEST_CASE(allocate_from_resource)
+{
+	CountingResource resource;
+	{
+		az::json::Value json;
+		{
+			az::json::MemoryResource::Scope scope(&resource);
+			json = {
+				{"array", {1, 2, 3}},
+				{"string", "a string which is too long to be kept inside"}
+			};
+		}
+		BOOST_CHECK_GT(resource.allocations, 0);
+		BOOST_CHECK_EQUAL(json.getResource(), &resource);
+		BOOST_CHECK_EQUAL(json["string"].getResource(), &resource);
+		BOOST_CHECK(json["array"][0].getResource() == nullptr);
+
+		// containers keep taking memory from their resource out of the scope
+		const auto allocations = resource.allocations;
+		for (int i = 0; i < 100; i++) {
+			json["array"].append(i);
+		}
+		BOOST_CHECK_GT(resource.allocations, allocations);
+		BOOST_CHECK_EQUAL(json["array"].getResource(), &resource);
+	}
+	BOOST_CHECK_EQUAL(resource.allocations, resource.deallocations);
+	BOOST_CHECK_EQUAL(resource.used, 0);
+}
+
+BOOST_AUTO_TEST_CASE(copy_between_resources)
+{
+	CountingResource resource;
+	az::json::Value copy;
+	{
+		az::json::Value json;
+		{
+			az::json::MemoryResource::Scope scope(&resource);
+			json = {
+				{"array", {1, 2, 3}},
+				{"string", "a string which is too long to be kept inside"}
+			};
+			// values of the same resource share their storage
+			az::json::Value shared = json;
+			BOOST_CHECK_EQUAL(&shared.getObject(), &json.getObject());
+		}
+		// values of another resource copy it
+		copy = json;
+		BOOST_CHECK_NE(&copy.getObject(), &json.getObject());
+		BOOST_CHECK_EQUAL(copy.getResource(), az::json::MemoryResource::getDefault());
+		BOOST_CHECK_EQUAL(copy["array"].getResource(), az::json::MemoryResource::getDefault());
+	}
+	BOOST_CHECK_EQUAL(resource.used, 0);
+	BOOST_CHECK_EQUAL(copy["string"], "a string which is too long to be kept inside");
+	BOOST_CHECK_EQUAL(copy["array"], az::json::Value({1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(use_keys_as_std_strings)
+{
+	static_assert(std::is_same<az::json::Value::String, std::string>::value, "strings of values are std::string");
+	CountingResource resource;
+	az::json::MemoryResource::Scope scope(&resource);
+	const az::json::Value json = {{"a key which is long enough to be allocated", 1}, {"b", 2}};
+	std::map<std::string, int> keys;
+	for (const auto& member : json.getObject()) {
+		// keys are taken from the resource, but still used where std::string is expected
+		const std::string key = member.first;
+		keys[member.first] = int(member.second.asInteger());
+		BOOST_CHECK(member.first == key && key == member.first);
+		BOOST_CHECK(member.first != std::string("c"));
+	}
+	BOOST_CHECK_EQUAL(keys["b"], 2);
+	BOOST_CHECK_EQUAL(keys["a key which is long enough to be allocated"], 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
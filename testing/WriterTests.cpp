@@ -1,6 +1,8 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include <boost/test/unit_test.hpp>
 #include <az/json/Writer.h>
+#include <az/json/Error.h>
+#include <az/json/Reader.h>
 #include <cmath>
 
 struct WriterFixture {
@@ -178,4 +180,95 @@ BOOST_FIXTURE_TEST_CASE(pretty_write_with_left_margin, WriterFixture)
 	BOOST_CHECK_EQUAL(stream.str(), " [\n   true\n ]");
 }
 
+BOOST_FIXTURE_TEST_CASE(write_with_cancellation, WriterFixture)
+{
+	az::json::Value json(az::json::Value::Type::Array);
+	for (int index = 0; index < 1000; index++) {
+		json.append(index);
+	}
+	az::json::Cancellation cancellation(10);
+	writer.withCancellation(cancellation).write(json);
+	BOOST_CHECK_EQUAL(stream.str(), json.stringify(false));
+
+	cancellation.cancel();
+	stream.str("");
+	try {
+		writer.write(json);
+		BOOST_ERROR("writing is not cancelled");
+	} catch (const az::json::Error& error) {
+		BOOST_CHECK(error.code() == az::json::Error::Code::Cancelled);
+	}
+	BOOST_CHECK_LT(stream.str().size(), 40);
+}
+
+BOOST_FIXTURE_TEST_CASE(write_with_raw_text, WriterFixture)
+{
+	const std::string text = "{\"b\": [1,  2.50, \"x\\u0041\"], \"a\": {\"c\": \"text\", \"d\": 16}, \"e\": 1e3, \"g\": \"a long \\u0041 string kept in storage\"}";
+	az::json::Value json;
+	az::json::RawText raw;
+	az::json::Reader(json).parse(text, raw);
+	BOOST_CHECK(!raw.empty());
+	writer.withRawText(raw).write(json);
+	BOOST_CHECK_EQUAL(stream.str(), text);
+	// parsed objects are shared by copies
+	const az::json::Value copy = json;
+	BOOST_CHECK_EQUAL(&copy.getObject(), &json.getObject());
+
+	// reading through a constant reference keeps the values untouched
+	const auto& view = json;
+	BOOST_CHECK_EQUAL(view["a"]["d"], 16);
+	stream.str("");
+	writer.write(json);
+	BOOST_CHECK_EQUAL(stream.str(), text);
+
+	// only the modified value and its containers are written again, a copy is written as the original,
+	// numbers keep their digits and long strings keep their escapes
+	json["a"]["c"] = "new";
+	// the member is copied before the object grows, since growing moves the members
+	const az::json::Value member = view["b"];
+	json["f"] = member;
+	stream.str("");
+	writer.write(json);
+	BOOST_CHECK_EQUAL(stream.str(), "{\"a\":{\"c\":\"new\",\"d\":16},\"b\":[1,  2.50, \"x\\u0041\"],\"e\":1e3,\"f\":[1,  2.50, \"x\\u0041\"],\"g\":\"a long \\u0041 string kept in storage\"}");
+
+	// short strings take no storage, so they are escaped again once their container is modified
+	json["b"].append(3);
+	stream.str("");
+	writer.write(json["b"]);
+	BOOST_CHECK_EQUAL(stream.str(), "[1,2.50,\"xA\",3]");
+
+	// values are written as usual by writers which would write them otherwise
+	stream.str("");
+	az::json::Writer(stream).withRawText(raw).withoutQuoting().write(json["f"]);
+	BOOST_CHECK_EQUAL(stream.str(), "[1,2.50,\"xA\"]");
+	stream.str("");
+	az::json::Writer(stream).withRawText(raw).pretty().write(json["f"]);
+	BOOST_CHECK_EQUAL(stream.str(), json["f"].stringify(true));
+
+	// the text is kept by the caller, so it is never a temporary
+	const std::string broken = "[1, 2";
+	BOOST_CHECK_THROW(az::json::Reader(json).parse(broken, raw), az::json::Error);
+	BOOST_CHECK(raw.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(write_json5_with_raw_text, WriterFixture)
+{
+	// spans which use extensions of JSON5 are written again, the others are copied
+	const std::string text = "{a: [1, 0x10], b: ['text'], c: [1, 2], d: {\"e\": 1e3},}";
+	az::json::Value json;
+	az::json::RawText raw;
+	az::json::Reader(json).parse(text, raw);
+	writer.withRawText(raw).write(json);
+	BOOST_CHECK_EQUAL(stream.str(), "{\"a\":[1,16],\"b\":[\"text\"],\"c\":[1, 2],\"d\":{\"e\": 1e3}}");
+
+	// values of another text never take its spans
+	az::json::Value other;
+	const std::string other_text = "[[3, 4]]";
+	az::json::Reader(other).parse(other_text, raw);
+	az::json::Reader(json).parse("[[1, 2]]");
+	stream.str("");
+	writer.write(json);
+	BOOST_CHECK_EQUAL(stream.str(), "[[1,2]]");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
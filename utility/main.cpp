@@ -1,23 +1,46 @@
 #include <az/json/Reader.h>
 #include <az/json/Writer.h>
+#include <az/json/RecordIndex.h>
 #include <fstream>
 
 int main(int argc, const char **argv)
 {
-	if (argc != 3) {
+	if (argc != 3 && !(argc == 4 && std::string(argv[1]) == "-record")) {
 		std::cerr << "Invalid arguments" << std::endl;
 		return -1;
 	}
 
+	if (std::string(argv[1]) == "-index") {
+		// builds a side index of NDJSON records which is used by -record option
+		try {
+			az::json::MappedFile file(argv[2]);
+			auto index = az::json::RecordIndex::build(file);
+			index.save(std::string(argv[2]) + ".idx");
+			std::cout << index.getRecords() << " records indexed" << std::endl;
+		} catch (const az::json::Error& error) {
+			std::cerr << "Error: " << error.what() << std::endl;
+			return -1;
+		}
+		return 0;
+	}
+
 	az::json::Value json;
 	az::json::Reader reader(json);
 	reader.withNoThrows();
 
 	if (std::string(argv[1]) == "-file") {
-		std::ifstream file(argv[2]);
-		reader.parse(file);
+		reader.parseFile(argv[2]);
 	} else if (std::string(argv[1]) == "-text") {
 		reader.parse(argv[2]);
+	} else if (std::string(argv[1]) == "-record") {
+		try {
+			az::json::MappedFile file(argv[2]);
+			auto index = az::json::RecordIndex::load(std::string(argv[2]) + ".idx", file);
+			reader.parseRecord(file, index, std::stoull(argv[3]));
+		} catch (const std::exception& error) {
+			std::cerr << "Error: " << error.what() << std::endl;
+			return -1;
+		}
 	} else {
 		std::cerr << "Invalid option: " << argv[1] << std::endl;
 	}